@@ -0,0 +1,320 @@
+/* bench_spsc.c - Receive to processing handoff benchmark */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cfl/cfl_spsc.h"
+
+/* Configurations */
+
+#ifndef BENCH_MESSAGES
+#define BENCH_MESSAGES (2000000U)
+#endif
+
+#ifndef BENCH_RING_SIZE
+#define BENCH_RING_SIZE (16U)
+#endif
+
+/* Definitions */
+
+#define BENCH_MAX_BATCH (32U)
+
+/* Types */
+
+/* Baseline: the same bounded queue behind a mutex and condition variables */
+typedef struct bench_locked_queue_s {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint32_t head;
+    uint32_t tail;
+    cfl_spsc_entry_t slots[BENCH_RING_SIZE];
+} bench_locked_queue_t;
+
+typedef struct bench_handoff_s {
+    cfl_spsc_t ring;
+    bench_locked_queue_t queue;
+    size_t batch;
+    uint32_t messages;
+} bench_handoff_t;
+
+/* Variables */
+
+static cfl_spsc_entry_t ring_slots[BENCH_RING_SIZE];
+/* Stands in for the packet pool, the ring only moves the pointers */
+static uint8_t packets[BENCH_RING_SIZE * 2];
+static volatile uintptr_t sink;
+/* JSON lines for scripts/cfl_bench.py, written with --json FILE */
+static FILE *json;
+
+/* Functions */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_report(const char *name, uint64_t ns, uint32_t messages)
+{
+    double per_msg = (double)ns / messages;
+
+    printf("%-32s %8.1f ns/msg\n", name, per_msg);
+    if (json != NULL)
+    {
+        fprintf(
+            json,
+            "{\"case\": \"%s\", \"ns\": %.1f, \"per_sec\": %.0f}\n",
+            name,
+            per_msg,
+            1e9 / per_msg);
+    }
+}
+
+static void *spsc_producer(void *arg)
+{
+    bench_handoff_t *handoff = (bench_handoff_t *)arg;
+
+    for (uint32_t i = 0; i < handoff->messages; i++)
+    {
+        /* Like the service RX task with a pool large enough to wait on the ring */
+        while (cfl_spsc_push(&handoff->ring, &packets[i % sizeof(packets)], i) < 0)
+        {
+            /* Lets the consumer run when both share a CPU */
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *spsc_consumer(void *arg)
+{
+    bench_handoff_t *handoff = (bench_handoff_t *)arg;
+    cfl_spsc_entry_t batch[BENCH_MAX_BATCH];
+    uint32_t received = 0;
+    size_t count = 0;
+
+    while (received < handoff->messages)
+    {
+        count = cfl_spsc_pop_batch(&handoff->ring, batch, handoff->batch);
+        if (count == 0)
+        {
+            sched_yield();
+            continue;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            sink = (uintptr_t)batch[i].ptr + batch[i].tag;
+        }
+        received += (uint32_t)count;
+    }
+
+    return NULL;
+}
+
+static void *locked_producer(void *arg)
+{
+    bench_handoff_t *handoff = (bench_handoff_t *)arg;
+    bench_locked_queue_t *queue = &handoff->queue;
+
+    for (uint32_t i = 0; i < handoff->messages; i++)
+    {
+        pthread_mutex_lock(&queue->lock);
+        while (queue->head - queue->tail == BENCH_RING_SIZE)
+        {
+            pthread_cond_wait(&queue->not_full, &queue->lock);
+        }
+        queue->slots[queue->head % BENCH_RING_SIZE].ptr = &packets[i % sizeof(packets)];
+        queue->slots[queue->head % BENCH_RING_SIZE].tag = i;
+        queue->head++;
+        pthread_cond_signal(&queue->not_empty);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    return NULL;
+}
+
+static void *locked_consumer(void *arg)
+{
+    bench_handoff_t *handoff = (bench_handoff_t *)arg;
+    bench_locked_queue_t *queue = &handoff->queue;
+    cfl_spsc_entry_t entry;
+
+    for (uint32_t i = 0; i < handoff->messages; i++)
+    {
+        pthread_mutex_lock(&queue->lock);
+        while (queue->head == queue->tail)
+        {
+            pthread_cond_wait(&queue->not_empty, &queue->lock);
+        }
+        entry = queue->slots[queue->tail % BENCH_RING_SIZE];
+        queue->tail++;
+        pthread_cond_signal(&queue->not_full);
+        pthread_mutex_unlock(&queue->lock);
+
+        sink = (uintptr_t)entry.ptr + entry.tag;
+    }
+
+    return NULL;
+}
+
+static uint64_t run_pair(
+    void *(*producer)(void *),
+    void *(*consumer)(void *),
+    bench_handoff_t *handoff)
+{
+    pthread_t producer_thread;
+    pthread_t consumer_thread;
+    uint64_t start = now_ns();
+
+    pthread_create(&consumer_thread, NULL, consumer, handoff);
+    pthread_create(&producer_thread, NULL, producer, handoff);
+    pthread_join(producer_thread, NULL);
+    pthread_join(consumer_thread, NULL);
+
+    return now_ns() - start;
+}
+
+static void push_pop_single(void)
+{
+    cfl_spsc_t ring;
+    cfl_spsc_entry_t entry = {0};
+    uint64_t start = 0;
+
+    (void)cfl_spsc_init(&ring, ring_slots, BENCH_RING_SIZE);
+
+    start = now_ns();
+    for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        (void)cfl_spsc_push(&ring, &packets[i % sizeof(packets)], i);
+        (void)cfl_spsc_pop_batch(&ring, &entry, 1);
+        sink = (uintptr_t)entry.ptr + entry.tag;
+    }
+
+    bench_report("spsc_push_pop_single", now_ns() - start, BENCH_MESSAGES);
+}
+
+static void handoff_spsc(const char *name, size_t batch)
+{
+    static bench_handoff_t handoff;
+
+    (void)cfl_spsc_init(&handoff.ring, ring_slots, BENCH_RING_SIZE);
+    handoff.batch = batch;
+    handoff.messages = BENCH_MESSAGES;
+
+    bench_report(name, run_pair(spsc_producer, spsc_consumer, &handoff), BENCH_MESSAGES);
+}
+
+static void handoff_locked(void)
+{
+    static bench_handoff_t handoff;
+
+    pthread_mutex_init(&handoff.queue.lock, NULL);
+    pthread_cond_init(&handoff.queue.not_empty, NULL);
+    pthread_cond_init(&handoff.queue.not_full, NULL);
+    handoff.queue.head = 0;
+    handoff.queue.tail = 0;
+    handoff.messages = BENCH_MESSAGES;
+
+    bench_report(
+        "mutex_handoff",
+        run_pair(locked_producer, locked_consumer, &handoff),
+        BENCH_MESSAGES);
+
+    pthread_cond_destroy(&handoff.queue.not_full);
+    pthread_cond_destroy(&handoff.queue.not_empty);
+    pthread_mutex_destroy(&handoff.queue.lock);
+}
+
+static void full_ring(void)
+{
+    cfl_spsc_t ring;
+    cfl_spsc_entry_t batch[BENCH_MAX_BATCH];
+    uint32_t sent = 0;
+    uint32_t rejected = 0;
+    uint64_t start = 0;
+
+    (void)cfl_spsc_init(&ring, ring_slots, BENCH_RING_SIZE);
+
+    /* Bursts of twice the ring size between two drains, like a stalled processing thread */
+    for (uint32_t round = 0; round < BENCH_MESSAGES / (BENCH_RING_SIZE * 2); round++)
+    {
+        for (uint32_t i = 0; i < BENCH_RING_SIZE * 2; i++, sent++)
+        {
+            if (cfl_spsc_push(&ring, &packets[i], sent) < 0)
+            {
+                rejected++;
+            }
+        }
+
+        while (cfl_spsc_pop_batch(&ring, batch, BENCH_MAX_BATCH) > 0)
+        {
+        }
+    }
+
+    printf(
+        "%-32s %8u sent %8u accepted %8u rejected\n",
+        "spsc_burst_2x_ring",
+        sent,
+        sent - rejected,
+        rejected);
+
+    /* A push into a full ring only reloads the consumer index and returns */
+    while (cfl_spsc_push(&ring, &packets[0], 0) == 0)
+    {
+    }
+
+    start = now_ns();
+    for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        sink = (uintptr_t)cfl_spsc_push(&ring, &packets[0], i);
+    }
+
+    bench_report("spsc_push_full", now_ns() - start, BENCH_MESSAGES);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && strcmp(argv[1], "--json") == 0)
+    {
+        json = fopen(argv[2], "w");
+        if (json == NULL)
+        {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+    else if (argc != 1)
+    {
+        fprintf(stderr, "usage: %s [--json FILE]\n", argv[0]);
+        return 1;
+    }
+
+    printf("CFL host benchmarks, %u messages, %u ring slots\n", BENCH_MESSAGES, BENCH_RING_SIZE);
+
+    push_pop_single();
+    handoff_spsc("spsc_handoff_batch1", 1);
+    handoff_spsc("spsc_handoff_batch8", 8);
+    handoff_spsc("spsc_handoff_batch32", BENCH_MAX_BATCH);
+    handoff_locked();
+    full_ring();
+
+    if (json != NULL)
+    {
+        fclose(json);
+    }
+
+    return 0;
+}
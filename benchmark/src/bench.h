@@ -0,0 +1,81 @@
+/* bench.h - Shared helpers for the CFL benchmarks */
+
+/* All Rights Reserved */
+
+#ifndef INC_BENCH_H
+#define INC_BENCH_H
+
+/* Includes */
+
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS (1000)
+#endif
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* External Declarations */
+
+/*
+ * One line per case. With BENCH_JSON (CMake option CFL_BENCH_JSON) the line is
+ * a JSON object that scripts/cfl_bench.py compares against a baseline.
+ */
+static inline void bench_report(const char *name, uint64_t cycles, uint32_t iterations)
+{
+    uint64_t per_call = cycles / iterations;
+    uint32_t ns = (uint32_t)k_cyc_to_ns_floor64(per_call);
+    uint32_t per_sec = (per_call != 0) ? (uint32_t)(sys_clock_hw_cycles_per_sec() / per_call) : 0;
+
+#if defined(BENCH_JSON)
+    printk(
+        "{\"case\": \"%s\", \"cycles\": %u, \"ns\": %u, \"per_sec\": %u}\n",
+        name,
+        (uint32_t)per_call,
+        ns,
+        per_sec);
+#else
+    printk(
+        "%-32s %8u cycles/call %8u ns/call %10u calls/s\n",
+        name,
+        (uint32_t)per_call,
+        ns,
+        per_sec);
+#endif
+}
+
+static inline void bench_skip(const char *name, const char *reason)
+{
+#if defined(BENCH_JSON)
+    printk("{\"case\": \"%s\", \"skipped\": \"%s\"}\n", name, reason);
+#else
+    printk("%-32s skipped: %s\n", name, reason);
+#endif
+}
+
+extern void bench_codec(void);
+extern void bench_dispatch(void);
+extern void bench_status(void);
+extern void bench_transaction(void);
+extern void bench_smp(void);
+extern void bench_replay(void);
+extern void bench_registry(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_BENCH_H */
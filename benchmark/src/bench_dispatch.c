@@ -0,0 +1,156 @@
+/* bench_dispatch.c - Dispatch path benchmark */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include "danp/danp_buffer.h"
+
+#include "zephyr/tmtc.h"
+
+#include "bench.h"
+#include "cfl/cfl.h"
+#include "cfl/cfl_ext.h"
+#include "cfl/cfl_ext_codec.h"
+#include "services/cfl_service_danp_int.h"
+
+/* Definitions */
+
+/* Command IDs without a registered handler, so only the service itself runs */
+#define BENCH_UNHANDLED_CMD_ID (0xFFFE)
+
+/* Types */
+
+typedef enum bench_frame_e
+{
+    BENCH_FRAME_VALID,
+    BENCH_FRAME_TRUNCATED, /* Shorter than a CFL header */
+    BENCH_FRAME_BAD_LENGTH, /* Header length does not match the packet */
+} bench_frame_t;
+
+/* Variables */
+
+/* Volatile sink keeps the compiler from dropping the lookups */
+static volatile uintptr_t sink;
+
+/* Functions */
+
+static void fill_message(
+    danp_packet_t *pkt,
+    uint8_t flags,
+    uint16_t cmd_id,
+    bench_frame_t frame)
+{
+    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
+    const cfl_ext_schedule_cancel_t cancel = {.id = 0xFFFFFFFFU};
+
+    msg->sync = CFL_SYNC_WORD;
+    msg->version = CFL_VERSION;
+    msg->flags = flags;
+    msg->cmd_id = cmd_id;
+    msg->seq = 0;
+    if (cmd_id == CFL_EXT_CMD_SCHEDULE_CANCEL)
+    {
+        /* Well-formed cancel of an unknown ID, the handler runs and fails */
+        msg->length = (uint16_t)cfl_ext_schedule_cancel_encode(
+            msg->data, CFL_EXT_SCHEDULE_CANCEL_SIZE, &cancel);
+    }
+    else
+    {
+        msg->length = 8;
+        memset(msg->data, 0xA5, msg->length);
+    }
+    pkt->length = CFL_HEADER_SIZE + msg->length;
+
+    if (frame == BENCH_FRAME_TRUNCATED)
+    {
+        pkt->length = CFL_HEADER_SIZE - 1;
+    }
+    else if (frame == BENCH_FRAME_BAD_LENGTH)
+    {
+        msg->length++;
+    }
+}
+
+static void run_case(const char *name, uint8_t flags, uint16_t cmd_id, bench_frame_t frame)
+{
+    danp_packet_t *rqst_pkt = danp_buffer_get();
+    danp_packet_t *rply_pkt = NULL;
+    danp_packet_t *status_pkt = NULL;
+    uint64_t cycles = 0;
+    uint32_t start = 0;
+
+    if (rqst_pkt == NULL)
+    {
+        bench_skip(name, "no DANP buffer available");
+        return;
+    }
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        fill_message(rqst_pkt, flags, cmd_id, frame);
+        rply_pkt = NULL;
+        status_pkt = NULL;
+
+        start = k_cycle_get_32();
+        (void)cfl_process_message(1, 1, rqst_pkt, &rply_pkt, &status_pkt);
+        cycles += k_cycle_get_32() - start;
+
+        if (status_pkt != NULL && status_pkt != rqst_pkt)
+        {
+            danp_buffer_free(status_pkt);
+        }
+        if (rply_pkt != NULL)
+        {
+            danp_buffer_free(rply_pkt);
+        }
+    }
+
+    danp_buffer_free(rqst_pkt);
+    bench_report(name, cycles, BENCH_ITERATIONS);
+}
+
+static void run_lookup(const char *name, uint16_t cmd_id)
+{
+    uint64_t cycles = 0;
+    uint32_t start = 0;
+
+    start = k_cycle_get_32();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        sink = (uintptr_t)tmtc_get_cmd_handler(cmd_id);
+    }
+    cycles = k_cycle_get_32() - start;
+
+    bench_report(name, cycles, BENCH_ITERATIONS);
+}
+
+void bench_dispatch(void)
+{
+    run_case("dispatch_push_unhandled", CFL_F_PUSH, BENCH_UNHANDLED_CMD_ID, BENCH_FRAME_VALID);
+    run_case("dispatch_request_nack", CFL_F_RQST, BENCH_UNHANDLED_CMD_ID, BENCH_FRAME_VALID);
+#if defined(CONFIG_CFL_SCHED)
+    run_case(
+        "dispatch_request_ext",
+        CFL_F_RQST,
+        CFL_EXT_CMD_SCHEDULE_CANCEL,
+        BENCH_FRAME_VALID);
+#else
+    bench_skip("dispatch_request_ext", "needs CONFIG_CFL_SCHED");
+#endif
+    run_case(
+        "dispatch_invalid_truncated",
+        CFL_F_RQST,
+        BENCH_UNHANDLED_CMD_ID,
+        BENCH_FRAME_TRUNCATED);
+    run_case(
+        "dispatch_invalid_length",
+        CFL_F_RQST,
+        BENCH_UNHANDLED_CMD_ID,
+        BENCH_FRAME_BAD_LENGTH);
+    run_lookup("lookup_handler_miss", BENCH_UNHANDLED_CMD_ID);
+}
@@ -0,0 +1,161 @@
+/* bench_registry.c - Runtime handler lookup benchmark */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <zephyr/kernel.h>
+
+#include "bench.h"
+#include "cfl/services/cfl_registry.h"
+
+#if defined(CONFIG_CFL_REGISTRY)
+
+/* Definitions */
+
+#define BENCH_REGISTRY_FIRST_ID   (0x7000)
+#define BENCH_REGISTRY_ENTRIES    (MIN(8, CONFIG_CFL_REGISTRY_MAX - 1))
+/* Registered and removed again and again by the updater */
+#define BENCH_REGISTRY_CHURN_ID   (BENCH_REGISTRY_FIRST_ID + BENCH_REGISTRY_ENTRIES)
+/* Enough lookups for the run to span many updater periods */
+#define BENCH_REGISTRY_LOOKUPS    (BENCH_ITERATIONS * 100)
+#define BENCH_REGISTRY_STACK_SIZE (1024)
+/* Above the benchmark thread, so updates preempt lookups even on one CPU */
+#define BENCH_REGISTRY_PRIORITY   (-1)
+
+/* Variables */
+
+static K_THREAD_STACK_DEFINE(updater_stack, BENCH_REGISTRY_STACK_SIZE);
+static struct k_thread updater_thread;
+static volatile bool updater_running;
+static uint32_t updates;
+
+/* Volatile sink keeps the compiler from dropping the lookups */
+static volatile uintptr_t sink;
+
+/* Functions */
+
+static int32_t bench_handler(
+    void *ctx,
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply)
+{
+    ARG_UNUSED(ctx);
+    ARG_UNUSED(src_node);
+    ARG_UNUSED(rqst);
+    ARG_UNUSED(rply);
+
+    return 0;
+}
+
+static void updater_task(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    while (updater_running)
+    {
+        (void)cfl_registry_register(BENCH_REGISTRY_CHURN_ID, bench_handler, NULL);
+        (void)cfl_registry_unregister(BENCH_REGISTRY_CHURN_ID);
+        updates += 2;
+        k_sleep(K_TICKS(1));
+    }
+}
+
+static void run_lookups(const char *name)
+{
+    const cfl_registry_entry_t *entry = NULL;
+    uint32_t ref = 0;
+    uint32_t start = 0;
+    uint64_t cycles = 0;
+
+    start = k_cycle_get_32();
+    for (uint32_t i = 0; i < BENCH_REGISTRY_LOOKUPS; i++)
+    {
+        entry = cfl_registry_acquire(BENCH_REGISTRY_FIRST_ID + (i % BENCH_REGISTRY_ENTRIES), &ref);
+        if (entry != NULL)
+        {
+            sink = (uintptr_t)entry->handler;
+            cfl_registry_release(ref);
+        }
+    }
+    /* Wall-clock cycles, time taken by the updater is included */
+    cycles = k_cycle_get_32() - start;
+
+    bench_report(name, cycles, BENCH_REGISTRY_LOOKUPS);
+}
+
+static void run_updates(const char *name)
+{
+    uint32_t start = 0;
+    uint64_t cycles = 0;
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        start = k_cycle_get_32();
+        (void)cfl_registry_register(BENCH_REGISTRY_CHURN_ID, bench_handler, NULL);
+        (void)cfl_registry_unregister(BENCH_REGISTRY_CHURN_ID);
+        cycles += k_cycle_get_32() - start;
+    }
+
+    bench_report(name, cycles, BENCH_ITERATIONS * 2);
+}
+
+/*
+ * Lookups of the dispatch path with an idle registry, then with a thread
+ * registering and removing a handler every tick. The difference is what
+ * updates cost dispatch; registry_update is what they cost their caller.
+ */
+void bench_registry(void)
+{
+    cfl_registry_stats_t stats = {0};
+
+    for (uint16_t i = 0; i < BENCH_REGISTRY_ENTRIES; i++)
+    {
+        if (cfl_registry_register(BENCH_REGISTRY_FIRST_ID + i, bench_handler, NULL) < 0)
+        {
+            bench_skip("registry_lookup", "registry table full");
+            return;
+        }
+    }
+
+    run_lookups("registry_lookup");
+
+    updates = 0;
+    updater_running = true;
+    (void)k_thread_create(
+        &updater_thread,
+        updater_stack,
+        K_THREAD_STACK_SIZEOF(updater_stack),
+        updater_task,
+        NULL,
+        NULL,
+        NULL,
+        BENCH_REGISTRY_PRIORITY,
+        0,
+        K_NO_WAIT);
+    run_lookups("registry_lookup_updating");
+    updater_running = false;
+    k_thread_join(&updater_thread, K_FOREVER);
+
+    run_updates("registry_update");
+
+    cfl_registry_get_stats(&stats);
+    printk("registry: %u concurrent updates, %u lookup retries\n", updates, stats.retries);
+
+    for (uint16_t i = 0; i < BENCH_REGISTRY_ENTRIES; i++)
+    {
+        (void)cfl_registry_unregister(BENCH_REGISTRY_FIRST_ID + i);
+    }
+}
+
+#else
+
+void bench_registry(void)
+{
+    bench_skip("registry_lookup", "CONFIG_CFL_REGISTRY disabled");
+}
+
+#endif
@@ -0,0 +1,106 @@
+/* bench_replay.c - Replay of a service packet capture */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include "danp/danp_buffer.h"
+
+#include "bench.h"
+#include "services/cfl_service_danp_int.h"
+
+#if defined(BENCH_REPLAY)
+
+/* Types */
+
+typedef struct bench_replay_frame_s
+{
+    uint32_t offset_us; /* Send time relative to the first frame, already scaled */
+    uint16_t node;
+    uint16_t port;
+    uint16_t len;
+    const uint8_t *data;
+} bench_replay_frame_t;
+
+/* Variables */
+
+/* Generated by scripts/cfl_capture.py replay, see benchmark/CMakeLists.txt */
+#include "replay_capture.inc"
+
+/* Functions */
+
+void bench_replay(void)
+{
+    const bench_replay_frame_t *frame = NULL;
+    danp_packet_t *rqst_pkt = NULL;
+    danp_packet_t *rply_pkt = NULL;
+    danp_packet_t *status_pkt = NULL;
+    uint64_t cycles = 0;
+    uint64_t elapsed_us = 0;
+    uint32_t start = 0;
+    uint32_t replayed = 0;
+    int64_t t0 = k_uptime_ticks();
+
+    for (size_t i = 0; i < BENCH_REPLAY_FRAMES; i++)
+    {
+        frame = &replay_frames[i];
+
+        /* Recorded pacing, the gaps were scaled by the script */
+        elapsed_us = k_ticks_to_us_floor64(k_uptime_ticks() - t0);
+        if (frame->offset_us > elapsed_us)
+        {
+            k_usleep((int32_t)(frame->offset_us - elapsed_us));
+        }
+
+        rqst_pkt = danp_buffer_get();
+        if (rqst_pkt == NULL || frame->len > sizeof(rqst_pkt->payload))
+        {
+            printk("replay_capture: frame %u dropped\n", (unsigned int)i);
+            if (rqst_pkt != NULL)
+            {
+                danp_buffer_free(rqst_pkt);
+            }
+            continue;
+        }
+        memcpy(rqst_pkt->payload, frame->data, frame->len);
+        rqst_pkt->length = frame->len;
+        rply_pkt = NULL;
+        status_pkt = NULL;
+
+        start = k_cycle_get_32();
+        (void)cfl_process_message(frame->node, frame->port, rqst_pkt, &rply_pkt, &status_pkt);
+        cycles += k_cycle_get_32() - start;
+        replayed++;
+
+        if (status_pkt != rqst_pkt)
+        {
+            danp_buffer_free(rqst_pkt);
+        }
+        if (status_pkt != NULL)
+        {
+            danp_buffer_free(status_pkt);
+        }
+        if (rply_pkt != NULL)
+        {
+            danp_buffer_free(rply_pkt);
+        }
+    }
+
+    if (replayed > 0)
+    {
+        bench_report("replay_capture", cycles, replayed);
+    }
+}
+
+#else
+
+void bench_replay(void)
+{
+    bench_skip("replay_capture", "configure with -DCFL_REPLAY_PCAP=<capture.pcap>");
+}
+
+#endif
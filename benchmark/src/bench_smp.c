@@ -0,0 +1,164 @@
+/* bench_smp.c - Dispatch placement benchmark on SMP targets */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include "danp/danp_buffer.h"
+
+#include "bench.h"
+#include "cfl/cfl.h"
+#include "cfl/cfl_thread.h"
+#include "services/cfl_service_danp_int.h"
+
+#if defined(CONFIG_SMP) && defined(CONFIG_SCHED_CPU_MASK) && (CONFIG_MP_MAX_NUM_CPUS > 1)
+
+/* Definitions */
+
+#define BENCH_SMP_STACK_SIZE    (2048)
+#define BENCH_SMP_PRIORITY      (5)
+#define BENCH_SMP_LOAD_CPU      (0)
+#define BENCH_UNHANDLED_CMD_ID  (0xFFFE)
+
+/* Variables */
+
+static K_THREAD_STACK_DEFINE(load_stack, BENCH_SMP_STACK_SIZE);
+static K_THREAD_STACK_DEFINE(worker_stack, BENCH_SMP_STACK_SIZE);
+static struct k_thread load_thread;
+static struct k_thread worker_thread;
+static K_SEM_DEFINE(worker_done, 0, 1);
+static volatile bool load_running;
+static uint64_t worker_cycles;
+
+/* Functions */
+
+/* Competes with the worker at the same priority, yielding so both make progress */
+static void load_task(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    while (load_running)
+    {
+        k_busy_wait(50);
+        k_yield();
+    }
+}
+
+static void worker_task(void *arg1, void *arg2, void *arg3)
+{
+    danp_packet_t *rqst_pkt = danp_buffer_get();
+    danp_packet_t *rply_pkt = NULL;
+    danp_packet_t *status_pkt = NULL;
+    cfl_message_t *msg = NULL;
+    uint32_t start = 0;
+
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    worker_cycles = 0;
+
+    if (rqst_pkt == NULL)
+    {
+        k_sem_give(&worker_done);
+        return;
+    }
+
+    msg = (cfl_message_t *)rqst_pkt->payload;
+    start = k_cycle_get_32();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        msg->sync = CFL_SYNC_WORD;
+        msg->version = CFL_VERSION;
+        msg->flags = CFL_F_PUSH;
+        msg->cmd_id = BENCH_UNHANDLED_CMD_ID;
+        msg->seq = 0;
+        msg->length = 8;
+        memset(msg->data, 0xA5, 8);
+        rqst_pkt->length = CFL_HEADER_SIZE + 8;
+
+        rply_pkt = NULL;
+        status_pkt = NULL;
+        (void)cfl_process_message(1, 1, rqst_pkt, &rply_pkt, &status_pkt);
+        if (rply_pkt != NULL)
+        {
+            danp_buffer_free(rply_pkt);
+        }
+    }
+    /* Wall-clock cycles, so time lost to the load thread is included */
+    worker_cycles = k_cycle_get_32() - start;
+
+    danp_buffer_free(rqst_pkt);
+    k_sem_give(&worker_done);
+}
+
+static void run_case(const char *name, uint32_t worker_cpu_mask)
+{
+    k_tid_t load_tid = NULL;
+    k_tid_t worker_tid = NULL;
+
+    load_running = true;
+    load_tid = k_thread_create(
+        &load_thread,
+        load_stack,
+        K_THREAD_STACK_SIZEOF(load_stack),
+        load_task,
+        NULL,
+        NULL,
+        NULL,
+        BENCH_SMP_PRIORITY,
+        0,
+        K_FOREVER);
+    worker_tid = k_thread_create(
+        &worker_thread,
+        worker_stack,
+        K_THREAD_STACK_SIZEOF(worker_stack),
+        worker_task,
+        NULL,
+        NULL,
+        NULL,
+        BENCH_SMP_PRIORITY,
+        0,
+        K_FOREVER);
+
+    if (cfl_thread_set_cpu_mask(load_tid, BIT(BENCH_SMP_LOAD_CPU)) < 0 ||
+        cfl_thread_set_cpu_mask(worker_tid, worker_cpu_mask) < 0)
+    {
+        bench_skip(name, "failed to pin threads");
+        k_thread_abort(load_tid);
+        k_thread_abort(worker_tid);
+        return;
+    }
+
+    k_thread_start(load_tid);
+    k_thread_start(worker_tid);
+
+    k_sem_take(&worker_done, K_FOREVER);
+    load_running = false;
+    k_thread_join(&worker_thread, K_FOREVER);
+    k_thread_join(&load_thread, K_FOREVER);
+
+    bench_report(name, worker_cycles, BENCH_ITERATIONS);
+}
+
+void bench_smp(void)
+{
+    run_case("smp_dispatch_shared_cpu", BIT(BENCH_SMP_LOAD_CPU));
+    run_case("smp_dispatch_own_cpu", BIT(BENCH_SMP_LOAD_CPU + 1));
+}
+
+#else
+
+void bench_smp(void)
+{
+    bench_skip("smp_dispatch_shared_cpu", "needs CONFIG_SMP, CONFIG_SCHED_CPU_MASK and 2+ CPUs");
+    bench_skip("smp_dispatch_own_cpu", "needs CONFIG_SMP, CONFIG_SCHED_CPU_MASK and 2+ CPUs");
+}
+
+#endif
@@ -0,0 +1,45 @@
+/* bench_status.c - ACK/NACK construction benchmark */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <zephyr/kernel.h>
+
+#include "danp/danp_buffer.h"
+
+#include "bench.h"
+#include "services/cfl_service_danp_int.h"
+
+/* Functions */
+
+/* Allocation from the DANP pool is part of the measured cost, the free is not */
+static void run_case(const char *name, bool nack)
+{
+    danp_packet_t *pkt = NULL;
+    uint64_t cycles = 0;
+    uint32_t start = 0;
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        start = k_cycle_get_32();
+        pkt = nack ? cfl_create_nack_packet(0x1234, (uint16_t)i, -EINVAL)
+                   : cfl_create_ack_packet(0x1234, (uint16_t)i);
+        cycles += k_cycle_get_32() - start;
+
+        if (pkt == NULL)
+        {
+            bench_skip(name, "no DANP buffer available");
+            return;
+        }
+        danp_buffer_free(pkt);
+    }
+
+    bench_report(name, cycles, BENCH_ITERATIONS);
+}
+
+void bench_status(void)
+{
+    run_case("status_create_ack", false);
+    run_case("status_create_nack", true);
+}
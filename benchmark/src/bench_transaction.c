@@ -0,0 +1,150 @@
+/* bench_transaction.c - Loopback transaction benchmark */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <stdbool.h>
+
+#include <zephyr/kernel.h>
+
+#include "bench.h"
+#include "cfl/cfl.h"
+#include "cfl/cfl_utilities.h"
+#include "cfl/services/cfl_service_danp.h"
+#include "cfl/services/cfl_stream.h"
+#include "danp/danp_defs.h"
+
+/* Configurations */
+
+/* Address of this node on its DANP interface (CMake option CFL_BENCH_LOCAL_NODE) */
+#ifndef BENCH_LOCAL_NODE
+#define BENCH_LOCAL_NODE (1)
+#endif
+
+/* Definitions */
+
+#define BENCH_UNHANDLED_CMD_ID    (0xFFFE)
+#define BENCH_TRANSACTION_TIMEOUT (100)
+/* What cfl_transaction() returns for a NACK */
+#define BENCH_TRANSACTION_NACK    (-5)
+/* What cfl_stream_transaction() returns for the NACK of an unhandled command */
+#define BENCH_STREAM_NACK         (-EINVAL)
+/* Largest request a single DANP packet carries */
+#define BENCH_BULK_SIZE           (DANP_MAX_PACKET_SIZE - CFL_HEADER_SIZE)
+
+/* Functions */
+
+static bool run_dgram(const char *name, const uint8_t *request, uint16_t request_len)
+{
+    uint8_t reply[8];
+    uint64_t cycles = 0;
+    uint32_t start = 0;
+    int32_t ret = 0;
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        start = k_cycle_get_32();
+        ret = (int32_t)cfl_transaction(
+            BENCH_LOCAL_NODE,
+            BENCH_UNHANDLED_CMD_ID,
+            request,
+            request_len,
+            reply,
+            sizeof(reply),
+            BENCH_TRANSACTION_TIMEOUT);
+        cycles += k_cycle_get_32() - start;
+
+        /* Anything but the NACK means the request never reached the local service */
+        if (ret != BENCH_TRANSACTION_NACK)
+        {
+            bench_skip(name, "no reply from the local node");
+            return false;
+        }
+    }
+
+    bench_report(name, cycles, BENCH_ITERATIONS);
+    return true;
+}
+
+#if defined(CONFIG_CFL_STREAM)
+static void run_stream(
+    const char *name,
+    cfl_stream_t *stream,
+    const uint8_t *request,
+    uint16_t request_len)
+{
+    uint8_t reply[8];
+    uint64_t cycles = 0;
+    uint32_t start = 0;
+    int32_t ret = 0;
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        start = k_cycle_get_32();
+        ret = cfl_stream_transaction(
+            stream,
+            BENCH_UNHANDLED_CMD_ID,
+            request,
+            request_len,
+            reply,
+            sizeof(reply),
+            BENCH_TRANSACTION_TIMEOUT);
+        cycles += k_cycle_get_32() - start;
+
+        if (ret != BENCH_STREAM_NACK)
+        {
+            bench_skip(name, "no reply on the stream");
+            return;
+        }
+    }
+
+    bench_report(name, cycles, BENCH_ITERATIONS);
+}
+#endif
+
+/*
+ * Requests to the local service for a command without a handler: the full
+ * client and service paths run, with a NACK as the reply. The bulk cases send
+ * full packets, their calls per second times BENCH_BULK_SIZE is the payload
+ * throughput of each transport.
+ */
+void bench_transaction(void)
+{
+    const cfl_service_danp_config_t config = {
+        .port_id = CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT,
+    };
+    static uint8_t request[BENCH_BULK_SIZE];
+#if defined(CONFIG_CFL_STREAM)
+    cfl_stream_t stream = {0};
+#endif
+
+    if (cfl_service_danp_init(&config) < 0)
+    {
+        bench_skip("transaction_loopback", "service init failed");
+        return;
+    }
+
+    if (run_dgram("transaction_loopback", request, 8))
+    {
+        (void)run_dgram("bulk_dgram", request, sizeof(request));
+    }
+
+#if defined(CONFIG_CFL_STREAM)
+    if (cfl_stream_open(&stream, BENCH_LOCAL_NODE, 0) < 0)
+    {
+        bench_skip("transaction_stream", "no stream connection to the local node");
+    }
+    else
+    {
+        run_stream("transaction_stream", &stream, request, 8);
+        run_stream("bulk_stream", &stream, request, sizeof(request));
+        cfl_stream_close(&stream);
+    }
+#else
+    bench_skip("transaction_stream", "CONFIG_CFL_STREAM disabled");
+#endif
+
+    (void)cfl_service_danp_deinit();
+}
@@ -0,0 +1,28 @@
+/* main.c - CFL benchmark entry point */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "bench.h"
+
+/* Functions */
+
+int main(void)
+{
+    printk("CFL benchmark: %u iterations per case\n", BENCH_ITERATIONS);
+
+    bench_status();
+    bench_dispatch();
+    bench_codec();
+    bench_transaction();
+    bench_smp();
+    bench_replay();
+    bench_registry();
+
+    printk("CFL benchmark done\n");
+    return 0;
+}
@@ -0,0 +1,39 @@
+# ==============================================================================
+# CFL Payload Codec Generation
+# ==============================================================================
+# cfl_generate_codec(<schema.json> <output_dir> <header_var>)
+#
+# Adds a build step running scripts/cfl_codegen.py on <schema.json> and
+# writing <output_dir>/cfl/<schema name>_codec.h. The header path is returned
+# in <header_var>; list it in the sources of the consuming target so the step
+# runs before compilation, and add <output_dir> to its include directories.
+#
+# Example:
+#   cfl_generate_codec(${CMAKE_CURRENT_SOURCE_DIR}/app.json
+#       ${CMAKE_CURRENT_BINARY_DIR}/generated APP_CODEC)
+#   target_sources(app PRIVATE ${APP_CODEC})
+#   target_include_directories(app PRIVATE ${CMAKE_CURRENT_BINARY_DIR}/generated)
+set(CFL_CODEGEN_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/../scripts/cfl_codegen.py)
+
+function(cfl_generate_codec schema output_dir header_var)
+    # Zephyr provides its own interpreter, host builds look one up
+    if(PYTHON_EXECUTABLE)
+        set(python ${PYTHON_EXECUTABLE})
+    else()
+        find_package(Python3 REQUIRED COMPONENTS Interpreter)
+        set(python ${Python3_EXECUTABLE})
+    endif()
+
+    get_filename_component(name ${schema} NAME_WE)
+    set(header ${output_dir}/cfl/${name}_codec.h)
+
+    add_custom_command(
+        OUTPUT ${header}
+        COMMAND ${python} ${CFL_CODEGEN_SCRIPT} ${schema} -o ${header}
+        DEPENDS ${schema} ${CFL_CODEGEN_SCRIPT}
+        COMMENT "Generating ${name}_codec.h"
+        VERBATIM
+    )
+
+    set(${header_var} ${header} PARENT_SCOPE)
+endfunction()
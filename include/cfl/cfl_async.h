@@ -0,0 +1,113 @@
+/* cfl_async.h - Stackless transaction engine */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_ASYNC_H
+#define INC_CFL_ASYNC_H
+
+/* Includes */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cfl/cfl_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+/**
+ * @brief Completion callback of an asynchronous transaction
+ *
+ * Runs on the engine thread and must not block. The reply buffer is only
+ * valid for the duration of the call.
+ *
+ * @param result    0 for an ACK, reply length for a reply, -EIO for a NACK
+ *                  (reply holds the 4-byte status), -ETIMEDOUT, -EBADMSG for
+ *                  a malformed response or -ECANCELED when the engine stops
+ * @param reply     Reply data, NULL when there is none
+ * @param reply_len Reply data length
+ * @param user_data Pointer given to cfl_async_transaction()
+ */
+typedef void (*cfl_async_cb_t)(
+    int32_t result,
+    const uint8_t *reply,
+    uint16_t reply_len,
+    void *user_data);
+
+typedef struct cfl_async_stats_s {
+    uint32_t active;    /* Transactions waiting for a response */
+    uint32_t completed; /* Completed with an ACK, NACK or reply */
+    uint32_t timed_out; /* Completed with -ETIMEDOUT */
+    uint32_t unmatched; /* Responses without a waiting transaction */
+} cfl_async_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Start the transaction engine
+ *
+ * One thread and one socket bound to CONFIG_CFL_ASYNC_PORT serve every
+ * asynchronous transaction. Each transaction only holds a control block
+ * from a pool of CONFIG_CFL_ASYNC_MAX entries.
+ *
+ * @param attr Engine thread attributes, NULL for the Kconfig defaults
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_async_init(const cfl_thread_attr_t *attr);
+
+/**
+ * @brief Stop the engine, pending transactions complete with -ECANCELED
+ * @return 0 on success, -EALREADY if the engine is not running
+ */
+extern int32_t cfl_async_deinit(void);
+
+/**
+ * @brief Send a request and return without waiting for the response
+ * @param dest_id     Destination node
+ * @param cmd_id      Message ID
+ * @param request     Request data
+ * @param request_len Request data length
+ * @param timeout_ms  Time to wait for the response
+ * @param cb          Completion callback, called exactly once unless cancelled
+ * @param user_data   Passed to the callback
+ * @param id          Output handle for cfl_async_cancel(), may be NULL
+ * @return 0 on success, -ENOMEM if every control block is in use, -EAGAIN if
+ *         the engine is not running, negative error code if sending failed
+ */
+extern int32_t cfl_async_transaction(
+    uint16_t dest_id,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len,
+    uint32_t timeout_ms,
+    cfl_async_cb_t cb,
+    void *user_data,
+    uint32_t *id);
+
+/**
+ * @brief Forget a pending transaction, its callback is not called
+ * @param id Handle returned by cfl_async_transaction()
+ * @return 0 on success, -ENOENT if the transaction already completed
+ */
+extern int32_t cfl_async_cancel(uint32_t id);
+
+/**
+ * @brief Get engine counters
+ * @param stats Output statistics
+ */
+extern void cfl_async_get_stats(cfl_async_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_ASYNC_H */
@@ -0,0 +1,97 @@
+/* cfl_buf.h - Size-classed packet buffers */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_BUF_H
+#define INC_CFL_BUF_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "danp/danp_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+/*
+ * A small buffer keeps the danp_packet_t layout up to CONFIG_CFL_BUF_SMALL_SIZE
+ * payload bytes. DANP only accepts its own buffers, so a small one is copied
+ * back with CFL_BUF_TO_DANP() before it is sent.
+ */
+#if defined(CONFIG_CFL_BUF)
+#define CFL_BUF_SHRINK(_pkt, _capacity) cfl_buf_shrink((_pkt), (_capacity))
+#define CFL_BUF_TO_DANP(_pkt)           cfl_buf_to_danp(_pkt)
+#define CFL_BUF_FREE(_pkt)              cfl_buf_free(_pkt)
+#else
+#define CFL_BUF_SHRINK(_pkt, _capacity) (_pkt)
+#define CFL_BUF_TO_DANP(_pkt)           (_pkt)
+#define CFL_BUF_FREE(_pkt)              danp_buffer_free(_pkt)
+#endif
+
+/* Types */
+
+typedef struct cfl_buf_stats_s {
+    uint32_t small_used; /* Small buffers currently held */
+    uint32_t small_peak; /* Most small buffers held at once */
+    uint32_t shrunk;     /* Packets moved into a small buffer */
+    uint32_t too_large;  /* Packets kept in their DANP buffer, too large to move */
+    uint32_t exhausted;  /* Packets kept in their DANP buffer, no small buffer free */
+    uint32_t restored;   /* Small buffers copied back into a DANP buffer */
+} cfl_buf_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Move a DANP packet into a small buffer when it fits
+ *
+ * The DANP buffer goes back to its pool at once, so packets waiting in a
+ * queue no longer hold full-size buffers.
+ *
+ * @param pkt      Packet from the DANP pool, consumed when moved
+ * @param capacity Payload bytes the packet must hold afterwards, at least its length
+ * @return The small buffer, or pkt if it does not fit or the slab is empty
+ */
+extern danp_packet_t *cfl_buf_shrink(danp_packet_t *pkt, uint16_t capacity);
+
+/**
+ * @brief Get a DANP buffer holding the packet, e.g. to send it
+ * @param pkt Packet from cfl_buf_shrink(), consumed
+ * @return pkt if it is already a DANP buffer, a copy in a new DANP buffer,
+ *         or NULL if the DANP pool is empty
+ */
+extern danp_packet_t *cfl_buf_to_danp(danp_packet_t *pkt);
+
+/**
+ * @brief Release a packet to the pool it came from
+ * @param pkt Small or DANP buffer
+ */
+extern void cfl_buf_free(danp_packet_t *pkt);
+
+/**
+ * @brief Check whether a packet lives in a small buffer
+ * @param pkt Packet
+ * @return true for a small buffer, false for a DANP buffer
+ */
+extern bool cfl_buf_is_small(const danp_packet_t *pkt);
+
+/**
+ * @brief Get a snapshot of the buffer counters
+ * @param stats Output statistics
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_buf_get_stats(cfl_buf_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_BUF_H */
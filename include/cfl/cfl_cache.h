@@ -0,0 +1,86 @@
+/* cfl_cache.h - Client-side single-flight and read-through cache */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_CACHE_H
+#define INC_CFL_CACHE_H
+
+/* Includes */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+typedef struct cfl_cache_stats_s {
+    uint32_t hits;      /* Served from a fresh cache entry */
+    uint32_t misses;    /* Sent on the wire */
+    uint32_t coalesced; /* Joined a transaction already in flight */
+    uint32_t bypassed;  /* Not eligible, passed straight to cfl_transaction() */
+} cfl_cache_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Make a command eligible for coalescing and caching
+ *
+ * Only enable read-only commands: a cached reply is returned without the
+ * request reaching the remote node.
+ *
+ * @param cmd_id Message ID
+ * @param ttl_ms How long a reply stays valid, 0 to only coalesce concurrent calls
+ * @return 0 on success, -ENOMEM if the command table is full
+ */
+extern int32_t cfl_cache_enable(uint16_t cmd_id, uint32_t ttl_ms);
+
+/**
+ * @brief Stop coalescing and caching a command and drop its entries
+ * @param cmd_id Message ID
+ */
+extern void cfl_cache_disable(uint16_t cmd_id);
+
+/**
+ * @brief cfl_transaction() with single-flight and read-through caching
+ *
+ * Identical calls (same destination, command and request bytes) made while
+ * one is on the wire wait for and share its result. Successful replies of
+ * commands with a TTL are then served locally until they expire. Commands not
+ * enabled with cfl_cache_enable() go straight to cfl_transaction().
+ *
+ * @return Same as cfl_transaction()
+ */
+extern int32_t cfl_transaction_cached(
+    uint16_t dest_id,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len,
+    uint8_t *reply,
+    uint16_t reply_size,
+    uint32_t timeout);
+
+/**
+ * @brief Drop all cached replies, transactions in flight are unaffected
+ */
+extern void cfl_cache_flush(void);
+
+/**
+ * @brief Get cache counters
+ * @param stats Output statistics
+ */
+extern void cfl_cache_get_stats(cfl_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_CACHE_H */
@@ -0,0 +1,110 @@
+/* cfl_capture.h - Packet capture ring */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_CAPTURE_H
+#define INC_CFL_CAPTURE_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+#define CFL_CAPTURE_DIR_RX (0U) /* Packet received by the service */
+#define CFL_CAPTURE_DIR_TX (1U) /* Packet sent by the service */
+
+/*
+ * Dumps are pcap files (LINKTYPE_USER0) whose packets start with a pseudo
+ * header [dir:u8][reserved:u8][node:le16][port:le16] followed by the frame
+ * as it was on the wire, truncated to CONFIG_CFL_CAPTURE_SNAPLEN bytes.
+ */
+#define CFL_CAPTURE_LINKTYPE    (147U)
+#define CFL_CAPTURE_PSEUDO_SIZE (6U)
+
+#if defined(CONFIG_CFL_CAPTURE)
+#define CFL_CAPTURE_PACKET(_dir, _node, _port, _pkt)                                         \
+    cfl_capture_packet((_dir), (_node), (_port), (_pkt)->payload, (_pkt)->length)
+#else
+#define CFL_CAPTURE_PACKET(_dir, _node, _port, _pkt) ((void)(_pkt))
+#endif
+
+/* Types */
+
+/**
+ * @brief Sink for dumped capture bytes
+ * @param ctx  Pointer given to cfl_capture_dump()
+ * @param data Next chunk of the pcap stream
+ * @param len  Chunk length
+ */
+typedef void (*cfl_capture_write_t)(void *ctx, const uint8_t *data, size_t len);
+
+typedef struct cfl_capture_stats_s {
+    bool enabled;
+    uint32_t records;     /* Records currently held */
+    uint32_t overwritten; /* Oldest records lost to ring wrap since the last clear */
+} cfl_capture_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Record a frame entering or leaving the service
+ *
+ * Copies at most CONFIG_CFL_CAPTURE_SNAPLEN bytes under a spinlock. Does
+ * nothing while capture is disabled.
+ *
+ * @param dir  CFL_CAPTURE_DIR_RX or CFL_CAPTURE_DIR_TX
+ * @param node Peer node address
+ * @param port Peer port
+ * @param data Frame as it is on the wire
+ * @param len  Frame length
+ */
+extern void cfl_capture_packet(
+    uint8_t dir,
+    uint16_t node,
+    uint16_t port,
+    const uint8_t *data,
+    uint16_t len);
+
+/**
+ * @brief Start or stop recording, the ring content is kept
+ * @param enabled true to record
+ */
+extern void cfl_capture_set_enabled(bool enabled);
+
+/**
+ * @brief Discard all records
+ */
+extern void cfl_capture_clear(void);
+
+/**
+ * @brief Write the ring, oldest record first, as a pcap stream
+ *
+ * Records added while dumping may or may not be included.
+ *
+ * @param write Sink called for each chunk of the stream
+ * @param ctx   Passed to the sink
+ * @return Number of records written
+ */
+extern size_t cfl_capture_dump(cfl_capture_write_t write, void *ctx);
+
+/**
+ * @brief Get capture state
+ * @param stats Output statistics
+ */
+extern void cfl_capture_get_stats(cfl_capture_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_CAPTURE_H */
@@ -0,0 +1,94 @@
+/* cfl_codec.h - Little-endian field access for CFL payloads */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_CODEC_H
+#define INC_CFL_CODEC_H
+
+/* Includes */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/sys/byteorder.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+/*
+ * Payload fields sit at arbitrary offsets of cfl_message_t::data. The
+ * fixed-size memcpy() is alignment safe and compiles to a single load or
+ * store on targets with unaligned access, and the byte swap is free on
+ * little-endian CPUs. Used by the codecs generated by scripts/cfl_codegen.py.
+ */
+
+/* Types */
+
+
+/* External Declarations */
+
+static inline void cfl_codec_put_u8(uint8_t *dst, uint8_t val)
+{
+    *dst = val;
+}
+
+static inline void cfl_codec_put_u16(uint8_t *dst, uint16_t val)
+{
+    val = sys_cpu_to_le16(val);
+    memcpy(dst, &val, sizeof(val));
+}
+
+static inline void cfl_codec_put_u32(uint8_t *dst, uint32_t val)
+{
+    val = sys_cpu_to_le32(val);
+    memcpy(dst, &val, sizeof(val));
+}
+
+static inline void cfl_codec_put_u64(uint8_t *dst, uint64_t val)
+{
+    val = sys_cpu_to_le64(val);
+    memcpy(dst, &val, sizeof(val));
+}
+
+static inline uint8_t cfl_codec_get_u8(const uint8_t *src)
+{
+    return *src;
+}
+
+static inline uint16_t cfl_codec_get_u16(const uint8_t *src)
+{
+    uint16_t val;
+
+    memcpy(&val, src, sizeof(val));
+    return sys_le16_to_cpu(val);
+}
+
+static inline uint32_t cfl_codec_get_u32(const uint8_t *src)
+{
+    uint32_t val;
+
+    memcpy(&val, src, sizeof(val));
+    return sys_le32_to_cpu(val);
+}
+
+static inline uint64_t cfl_codec_get_u64(const uint8_t *src)
+{
+    uint64_t val;
+
+    memcpy(&val, src, sizeof(val));
+    return sys_le64_to_cpu(val);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_CODEC_H */
@@ -0,0 +1,115 @@
+/* cfl_compact.h - Compact message header encoding */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_COMPACT_H
+#define INC_CFL_COMPACT_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "danp/danp_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+/*
+ * Compact header layout, all fields little endian:
+ *
+ *   [sync:8][version:3|flags:5][cmd_id:varint][seq:varint][length:varint][data]
+ *
+ * Varints are LEB128 encoded, so IDs and lengths below 128 take one byte and
+ * the smallest header is 5 bytes. The first byte never matches the first byte
+ * of CFL_SYNC_WORD, which lets both formats share one port.
+ */
+#define CFL_COMPACT_SYNC (0xC5U)
+
+#define CFL_COMPACT_VERSION_MAX (0x07U)
+#define CFL_COMPACT_FLAGS_MASK  (0x1FU)
+
+#define CFL_COMPACT_HEADER_MIN (5U)
+#define CFL_COMPACT_HEADER_MAX (11U)
+
+/* Types */
+
+typedef struct cfl_compact_peer_s {
+    uint16_t node;  /* Peer node address */
+    bool learned;   /* Enabled because the peer sent a compact frame */
+} cfl_compact_peer_t;
+
+/* External Declarations */
+
+/**
+ * @brief Check whether a packet starts with a compact header
+ * @param pkt Packet to inspect
+ * @return true if the packet uses the compact format
+ */
+extern bool cfl_compact_is_compact(const danp_packet_t *pkt);
+
+/**
+ * @brief Rewrite a compact header into the full header in place
+ *
+ * The payload is moved behind a full CFL header so the rest of the stack only
+ * deals with cfl_message_t. Packets already in the full format are left as is.
+ *
+ * @param pkt Packet to convert
+ * @return 1 if the packet was expanded, 0 if it was not compact, or a negative
+ *         error code if the compact header is malformed or does not fit
+ */
+extern int32_t cfl_compact_expand(danp_packet_t *pkt);
+
+/**
+ * @brief Rewrite a full header into the compact header in place
+ * @param pkt Packet carrying a complete cfl_message_t
+ * @return 0 on success, -ENOTSUP if version or flags do not fit the compact
+ *         format, -EMSGSIZE if the compact header would not be shorter. The
+ *         packet is left untouched on error and can be sent as is.
+ */
+extern int32_t cfl_compact_pack(danp_packet_t *pkt);
+
+/**
+ * @brief Enable or disable compact headers towards a peer
+ *
+ * A disabled peer is enabled again as soon as it sends a compact frame.
+ *
+ * @param node    Peer node address
+ * @param enabled true to send compact headers to this peer
+ * @return 0 on success, -ENOMEM if the peer table is full
+ */
+extern int32_t cfl_compact_set_peer(uint16_t node, bool enabled);
+
+/**
+ * @brief Record that a peer sent a compact frame and therefore accepts them
+ * @param node Peer node address
+ */
+extern void cfl_compact_learn_peer(uint16_t node);
+
+/**
+ * @brief Check whether compact headers may be sent to a peer
+ * @param node Peer node address
+ * @return true if the peer is known to accept compact headers
+ */
+extern bool cfl_compact_peer_enabled(uint16_t node);
+
+/**
+ * @brief Get an entry of the compact peer table
+ * @param index Table index
+ * @param peer  Output peer entry
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_compact_get_peer(size_t index, cfl_compact_peer_t *peer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_COMPACT_H */
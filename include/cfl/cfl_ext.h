@@ -0,0 +1,135 @@
+/* cfl_ext.h - Reserved CFL command IDs and payload layouts */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_EXT_H
+#define INC_CFL_EXT_H
+
+/* Includes */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+/*
+ * Payload layouts are defined in schema/cfl_ext.json. The generated
+ * cfl/cfl_ext_codec.h provides their sizes and encode/decode functions.
+ */
+
+/* Command IDs from this base up are handled by the service itself, never by tmtc handlers */
+#define CFL_EXT_CMD_BASE (0xFF00U)
+
+/*
+ * Subscribe to a telemetry command.
+ * Request:  [cmd_id:le16][port:le16][period_ms:le32]
+ * Reply:    ACK, or NACK with the error code
+ * The service samples cmd_id every period_ms and pushes the reply data to the
+ * subscriber node on port, or on the CFL service port when port is 0.
+ * Subscribing again to the same command updates the period and renews the
+ * subscription, which lapses CONFIG_CFL_PUBSUB_LEASE_MS of the publisher
+ * after it was last made.
+ */
+#define CFL_EXT_CMD_SUBSCRIBE      (CFL_EXT_CMD_BASE + 0x00U)
+
+/*
+ * Remove a subscription.
+ * Request:  [cmd_id:le16][port:le16]
+ * Reply:    ACK, or NACK with -ENOENT
+ */
+#define CFL_EXT_CMD_UNSUBSCRIBE    (CFL_EXT_CMD_BASE + 0x01U)
+
+/*
+ * Queue a command for execution at a future time.
+ * Request:  [exec_at_ms:le64][cmd_id:le16][data]
+ * Reply:    [id:le32], or NACK with the error code
+ * exec_at_ms is the uptime of the executing node; times already past run on
+ * the next scheduler pass. The command runs as if the sender had requested it
+ * and its reply is discarded. Reserved commands and commands without a handler
+ * are refused with -ENOENT.
+ */
+#define CFL_EXT_CMD_SCHEDULE       (CFL_EXT_CMD_BASE + 0x02U)
+
+/*
+ * Cancel a queued command.
+ * Request:  [id:le32]
+ * Reply:    ACK, or NACK with -ENOENT if the command already ran or is unknown,
+ *           -EPERM if another node queued it
+ */
+#define CFL_EXT_CMD_SCHEDULE_CANCEL (CFL_EXT_CMD_BASE + 0x03U)
+
+/*
+ * Cumulative acknowledgement of reliable pushes, a status frame, never a request.
+ * Frame:    CFL_F_ACK, seq of the last push acknowledged, [first_seq:le16][count:le16]
+ * A push sent with CFL_EXT_F_PUSH_RELIABLE is acknowledged together with the
+ * pushes its sender sent before and after it: one frame covers count
+ * consecutive sequence numbers from first_seq on. Pushes received again are
+ * acknowledged again, so a lost frame only delays the release.
+ */
+#define CFL_EXT_CMD_PUSH_ACK        (CFL_EXT_CMD_BASE + 0x04U)
+
+/* Flags of a push asking for a cumulative acknowledgement, ignored by older receivers */
+#define CFL_EXT_F_PUSH_RELIABLE (CFL_F_PUSH | CFL_F_ACK)
+
+/*
+ * Start or resume a transfer to a target registered with cfl_xfer_register().
+ * Request:  [object:le32][size:le32][chunk_size:le16][crc32:le32]
+ * Reply:    [xfer_id:le16][received:le32], or NACK with the error code
+ * Opening the same object again with the same size, chunk size and CRC resumes
+ * the transfer: received tells how many chunks the receiver already holds.
+ */
+#define CFL_EXT_CMD_XFER_OPEN       (CFL_EXT_CMD_BASE + 0x05U)
+
+/*
+ * One chunk of a transfer, a push.
+ * Push:     [xfer_id:le16][index:le32][data]
+ * Chunks may arrive in any order and more than once.
+ */
+#define CFL_EXT_CMD_XFER_DATA       (CFL_EXT_CMD_BASE + 0x06U)
+
+/*
+ * Chunks held by the receiver, the sender re-sends the holes.
+ * Request:  [xfer_id:le16][base:le32]
+ * Reply:    [received:le32][base:le32][bitmap], or NACK with -ENOENT
+ * Bit n of bitmap byte m is set when chunk base + 8 * m + n is held. Bits past
+ * the last chunk are set.
+ */
+#define CFL_EXT_CMD_XFER_STATUS     (CFL_EXT_CMD_BASE + 0x07U)
+
+/*
+ * Finish a transfer once every chunk is held.
+ * Request:  [xfer_id:le16]
+ * Reply:    ACK once the target content matches the CRC of the open request,
+ *           NACK with -EAGAIN while chunks are missing, -EBADMSG on a CRC
+ *           mismatch, -ENOENT for an unknown transfer
+ */
+#define CFL_EXT_CMD_XFER_CLOSE      (CFL_EXT_CMD_BASE + 0x08U)
+
+/*
+ * Flag of a request asking for the times it was served, ignored by older receivers.
+ * Response: [data][rx_us:le64][tx_us:le64], the flag set and length covering the trailer
+ * rx_us and tx_us are the uptime of the responder when the request arrived and
+ * when the response left. Only the responder sets the flag on a response, so
+ * it is never added to the data of a peer that did not ask for it. The bit does
+ * not fit the compact header, flagged frames are always sent in the full format.
+ * Routers clear the flag on the requests they forward.
+ */
+#define CFL_EXT_F_TIMESTAMP (0x80U)
+
+/* Types */
+
+
+/* External Declarations */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_EXT_H */
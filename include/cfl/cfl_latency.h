@@ -0,0 +1,109 @@
+/* cfl_latency.h - One-way latency from timestamped transactions */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_LATENCY_H
+#define INC_CFL_LATENCY_H
+
+/* Includes */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "danp/danp_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+/*
+ * Times of a transaction, t1 and t4 on the local clock, t2 and t3 on the
+ * clock of the peer. The offset between the clocks is estimated NTP style from
+ * the sample of the last few with the shortest round trip, the one least
+ * skewed by queueing on either way.
+ */
+typedef struct cfl_latency_peer_s {
+    uint16_t node;        /* Peer node address */
+    uint32_t samples;     /* Timestamped transactions completed */
+    uint32_t idle_ms;     /* Time since the last sample */
+    int64_t offset_us;    /* Clock of the peer minus the local clock */
+    uint32_t delay_us;    /* Round trip without remote processing, of the offset sample */
+    int32_t uplink_us;    /* Request transit, smoothed */
+    int32_t remote_us;    /* Time the peer took to respond, smoothed */
+    int32_t downlink_us;  /* Response transit, smoothed */
+} cfl_latency_peer_t;
+
+/* External Declarations */
+
+/**
+ * @brief Local clock of the timestamps
+ * @return Uptime in microseconds
+ */
+extern uint64_t cfl_latency_now_us(void);
+
+/**
+ * @brief Append the serving times to a response, as asked by CFL_EXT_F_TIMESTAMP
+ *
+ * The transmit time is taken now, call it right before the packet is sent.
+ *
+ * @param pkt   Status or reply packet in the full format
+ * @param rx_us Local time the request arrived
+ * @return 0 on success, -EMSGSIZE if the trailer does not fit; the packet is
+ *         left untouched on error and can be sent as is
+ */
+extern int32_t cfl_latency_stamp(danp_packet_t *pkt, uint64_t rx_us);
+
+/**
+ * @brief Remove the serving times from a response
+ * @param pkt   Validated response packet in the full format
+ * @param rx_us Output time the request arrived at the peer
+ * @param tx_us Output time the response left the peer
+ * @return 1 if the times were removed, 0 if the response carries none, or
+ *         -EBADMSG if it is flagged but too short
+ */
+extern int32_t cfl_latency_strip(danp_packet_t *pkt, uint64_t *rx_us, uint64_t *tx_us);
+
+/**
+ * @brief Account the four times of a completed transaction to its peer
+ *
+ * The least recently updated peer is replaced when the table is full.
+ *
+ * @param node  Peer node address
+ * @param t1_us Local time the request was sent
+ * @param t2_us Peer time the request arrived
+ * @param t3_us Peer time the response left
+ * @param t4_us Local time the response was received
+ */
+extern void cfl_latency_record(
+    uint16_t node,
+    uint64_t t1_us,
+    uint64_t t2_us,
+    uint64_t t3_us,
+    uint64_t t4_us);
+
+/**
+ * @brief Get the latency estimate of a peer
+ * @param index Table index
+ * @param peer  Output estimate
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_latency_get(size_t index, cfl_latency_peer_t *peer);
+
+/**
+ * @brief Forget every peer
+ */
+extern void cfl_latency_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_LATENCY_H */
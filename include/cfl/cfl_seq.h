@@ -0,0 +1,149 @@
+/* cfl_seq.h - Windows and ranges of wrapping 16-bit sequence numbers */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_SEQ_H
+#define INC_CFL_SEQ_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+/* Sequence numbers remembered behind the newest one, the width of the bitmap */
+#define CFL_SEQ_WINDOW (32U)
+
+/* Types */
+
+typedef enum cfl_seq_verdict_e {
+    CFL_SEQ_NEW,       /* Not seen before */
+    CFL_SEQ_DUPLICATE, /* Seen before within the window */
+    CFL_SEQ_STALE,     /* Older than the window */
+    CFL_SEQ_RESYNC,    /* Older than the window once too often, the window restarted at it */
+} cfl_seq_verdict_t;
+
+/*
+ * Bit n of seen is set when sequence number top - n was received. Numbers are
+ * compared by their signed 16-bit distance to top, so up to 32767 ahead is
+ * newer and the window slides across the wrap at 0xFFFF. A zeroed window is
+ * empty and takes the first number as its top.
+ */
+typedef struct cfl_seq_window_s {
+    bool valid;
+    uint8_t stale;
+    uint16_t top;
+    uint32_t seen;
+} cfl_seq_window_t;
+
+/* count consecutive sequence numbers from first on, possibly across the wrap */
+typedef struct cfl_seq_range_s {
+    uint16_t first;
+    uint16_t count;
+} cfl_seq_range_t;
+
+/* Functions */
+
+/**
+ * @brief Record a sequence number and tell whether it was seen before
+ *
+ * Numbers older than the window are stale until resync of them arrive in a
+ * row, then the window restarts at the last one as a peer that restarted its
+ * numbering would need. Any other number breaks the row.
+ *
+ * @param window Window of the stream
+ * @param seq    Received sequence number
+ * @param resync Stale numbers in a row that restart the window, at least 1
+ * @return Verdict, the window is updated unless it is CFL_SEQ_DUPLICATE or CFL_SEQ_STALE
+ */
+static inline cfl_seq_verdict_t cfl_seq_window_check(
+    cfl_seq_window_t *window,
+    uint16_t seq,
+    uint8_t resync)
+{
+    int16_t diff = (int16_t)(seq - window->top);
+    uint32_t bit = 0;
+
+    if (!window->valid || diff > 0)
+    {
+        /* Newest so far, older numbers slide down and off the end */
+        window->seen = (!window->valid || diff >= (int16_t)CFL_SEQ_WINDOW)
+                           ? 1U
+                           : ((window->seen << diff) | 1U);
+        window->top = seq;
+        window->valid = true;
+        window->stale = 0;
+        return CFL_SEQ_NEW;
+    }
+
+    if (-diff >= (int16_t)CFL_SEQ_WINDOW)
+    {
+        /* A peer that restarted numbers from scratch looks like a replay at first */
+        if (++window->stale < resync)
+        {
+            return CFL_SEQ_STALE;
+        }
+
+        window->seen = 1U;
+        window->top = seq;
+        window->stale = 0;
+        return CFL_SEQ_RESYNC;
+    }
+
+    window->stale = 0;
+    bit = 1U << (uint32_t)(-diff);
+    if (window->seen & bit)
+    {
+        return CFL_SEQ_DUPLICATE;
+    }
+
+    window->seen |= bit;
+    return CFL_SEQ_NEW;
+}
+
+/**
+ * @brief Append a sequence number to a range
+ * @param range Range, empty when count is 0
+ * @param seq   Sequence number to append
+ * @return true if seq started the range or was the number after its last one,
+ *         false if it did not follow and the range was left untouched
+ */
+static inline bool cfl_seq_range_add(cfl_seq_range_t *range, uint16_t seq)
+{
+    if (range->count == 0)
+    {
+        range->first = seq;
+    }
+    else if (seq != (uint16_t)(range->first + range->count))
+    {
+        return false;
+    }
+
+    range->count++;
+    return true;
+}
+
+/**
+ * @brief Check whether a range holds a sequence number
+ * @param range Range
+ * @param seq   Sequence number
+ * @return true if seq is one of the range
+ */
+static inline bool cfl_seq_range_covers(const cfl_seq_range_t *range, uint16_t seq)
+{
+    return (uint16_t)(seq - range->first) < range->count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_SEQ_H */
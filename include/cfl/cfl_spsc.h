@@ -0,0 +1,159 @@
+/* cfl_spsc.h - Lock-free single-producer/single-consumer ring */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_SPSC_H
+#define INC_CFL_SPSC_H
+
+/* Includes */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+/* Producer and consumer indices live on separate cache lines on SMP and hosts */
+#ifndef CFL_SPSC_ALIGN
+#if defined(__ZEPHYR__) && !defined(CONFIG_SMP)
+#define CFL_SPSC_ALIGN (4)
+#else
+#define CFL_SPSC_ALIGN (64)
+#endif
+#endif
+
+/* Definitions */
+
+#define CFL_SPSC_LOAD_ACQUIRE(_ptr)        __atomic_load_n((_ptr), __ATOMIC_ACQUIRE)
+#define CFL_SPSC_STORE_RELEASE(_ptr, _val) __atomic_store_n((_ptr), (_val), __ATOMIC_RELEASE)
+
+/* Types */
+
+/* One ring slot: a packet pointer and a caller defined tag, e.g. its source address */
+typedef struct cfl_spsc_entry_s {
+    void *ptr;
+    uint32_t tag;
+} cfl_spsc_entry_t;
+
+/*
+ * Indices run freely and wrap at 2^32, the slot is index & mask. Each side
+ * keeps a cached copy of the other side's index and only reloads it when the
+ * ring looks full (producer) or empty (consumer), so a steady stream costs
+ * one release store per push and per batch.
+ */
+typedef struct cfl_spsc_s {
+    /* Producer side */
+    uint32_t head __attribute__((aligned(CFL_SPSC_ALIGN)));
+    uint32_t tail_cache;
+    /* Consumer side */
+    uint32_t tail __attribute__((aligned(CFL_SPSC_ALIGN)));
+    uint32_t head_cache;
+    /* Read-only after cfl_spsc_init() */
+    uint32_t mask __attribute__((aligned(CFL_SPSC_ALIGN)));
+    cfl_spsc_entry_t *slots;
+} cfl_spsc_t;
+
+/* External Declarations */
+
+/**
+ * @brief Initialize an empty ring
+ * @param ring  Ring to initialize
+ * @param slots Slot storage, owned by the ring afterwards
+ * @param size  Number of slots, a power of two
+ * @return 0 on success, -EINVAL if size is not a power of two
+ */
+static inline int32_t cfl_spsc_init(cfl_spsc_t *ring, cfl_spsc_entry_t *slots, uint32_t size)
+{
+    if (size == 0 || (size & (size - 1)) != 0)
+    {
+        return -EINVAL;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->mask = size - 1;
+    ring->slots = slots;
+
+    return 0;
+}
+
+/**
+ * @brief Append an entry, producer side only
+ * @param ring Ring
+ * @param ptr  Pointer to hand over
+ * @param tag  Caller defined value travelling with the pointer
+ * @return 0 on success, -ENOBUFS if the ring is full
+ */
+static inline int32_t cfl_spsc_push(cfl_spsc_t *ring, void *ptr, uint32_t tag)
+{
+    uint32_t head = ring->head;
+
+    if (head - ring->tail_cache > ring->mask)
+    {
+        ring->tail_cache = CFL_SPSC_LOAD_ACQUIRE(&ring->tail);
+        if (head - ring->tail_cache > ring->mask)
+        {
+            return -ENOBUFS;
+        }
+    }
+
+    ring->slots[head & ring->mask].ptr = ptr;
+    ring->slots[head & ring->mask].tag = tag;
+    CFL_SPSC_STORE_RELEASE(&ring->head, head + 1);
+
+    return 0;
+}
+
+/**
+ * @brief Remove up to max entries in FIFO order, consumer side only
+ * @param ring    Ring
+ * @param entries Output entries
+ * @param max     Capacity of entries
+ * @return Number of entries removed, 0 if the ring is empty
+ */
+static inline size_t cfl_spsc_pop_batch(cfl_spsc_t *ring, cfl_spsc_entry_t *entries, size_t max)
+{
+    uint32_t tail = ring->tail;
+    uint32_t avail = ring->head_cache - tail;
+    size_t count = 0;
+
+    if (avail == 0)
+    {
+        ring->head_cache = CFL_SPSC_LOAD_ACQUIRE(&ring->head);
+        avail = ring->head_cache - tail;
+    }
+
+    count = (avail < max) ? avail : max;
+    for (size_t i = 0; i < count; i++)
+    {
+        entries[i] = ring->slots[(tail + i) & ring->mask];
+    }
+
+    if (count > 0)
+    {
+        /* One release store hands every slot of the batch back to the producer */
+        CFL_SPSC_STORE_RELEASE(&ring->tail, tail + (uint32_t)count);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Number of entries in the ring, exact only when both sides are idle
+ * @param ring Ring
+ * @return Entry count
+ */
+static inline uint32_t cfl_spsc_count(const cfl_spsc_t *ring)
+{
+    return CFL_SPSC_LOAD_ACQUIRE(&ring->head) - CFL_SPSC_LOAD_ACQUIRE(&ring->tail);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_SPSC_H */
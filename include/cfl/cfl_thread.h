@@ -0,0 +1,70 @@
+/* cfl_thread.h - Thread placement for CFL threads */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_THREAD_H
+#define INC_CFL_THREAD_H
+
+/* Includes */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+typedef struct cfl_thread_attr_s {
+    int32_t priority;  /* Zephyr thread priority */
+    size_t stack_size; /* Stack size in bytes, 0 for the Kconfig default */
+    uint32_t cpu_mask; /* Bit n allows CPU n, 0 allows every CPU */
+} cfl_thread_attr_t;
+
+/* External Declarations */
+
+/**
+ * @brief Restrict a thread that is not runnable yet to a set of CPUs
+ *
+ * Meant for threads created with a K_FOREVER delay, before k_thread_start().
+ *
+ * @param tid      Thread to restrict
+ * @param cpu_mask Bit n allows CPU n, 0 allows every CPU
+ * @return 0 on success, -ENOTSUP for a non-zero mask without
+ *         CONFIG_SCHED_CPU_MASK, -EINVAL for CPUs that do not exist
+ */
+extern int32_t cfl_thread_set_cpu_mask(k_tid_t tid, uint32_t cpu_mask);
+
+/**
+ * @brief Change priority and CPU placement of a running thread
+ *
+ * The thread is suspended while its CPU mask is changed, so this cannot be
+ * used on the calling thread.
+ *
+ * @param tid      Thread to move
+ * @param priority New Zephyr priority
+ * @param cpu_mask Bit n allows CPU n, 0 allows every CPU
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_thread_place(k_tid_t tid, int32_t priority, uint32_t cpu_mask);
+
+/**
+ * @brief Work queue CFL background work is submitted to
+ * @return The CFL work queue with CONFIG_CFL_WORKQ, the system work queue otherwise
+ */
+extern struct k_work_q *cfl_thread_workq(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_THREAD_H */
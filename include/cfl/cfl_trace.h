@@ -0,0 +1,120 @@
+/* cfl_trace.h - Per-message stage latency tracing */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_TRACE_H
+#define INC_CFL_TRACE_H
+
+/* Includes */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(CONFIG_CFL_TRACE)
+#include <zephyr/kernel.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+#define CFL_TRACE_KIND_SERVICE     (0U) /* Message handled by the service RX task */
+#define CFL_TRACE_KIND_TRANSACTION (1U) /* Client side cfl_transaction() */
+
+/* Service stages */
+#define CFL_TRACE_RX     (0U) /* Packet returned by the socket */
+#define CFL_TRACE_LOOKUP (1U) /* Handler resolved */
+#define CFL_TRACE_EXEC   (2U) /* Handler returned */
+#define CFL_TRACE_BUILD  (3U) /* Status or reply packet ready */
+#define CFL_TRACE_TX     (4U) /* Responses handed to the socket */
+
+/* Transaction stages */
+#define CFL_TRACE_START (0U) /* cfl_transaction() entered */
+#define CFL_TRACE_ALLOC (1U) /* Request packet built */
+#define CFL_TRACE_SENT  (2U) /* Request handed to the socket */
+#define CFL_TRACE_RECV  (3U) /* Response received */
+#define CFL_TRACE_DONE  (4U) /* Response decoded */
+
+#define CFL_TRACE_STAGE_COUNT (5U)
+
+#if defined(CONFIG_CFL_TRACE)
+#define CFL_TRACE_BEGIN(_kind, _node)      cfl_trace_begin((_kind), (_node))
+#define CFL_TRACE_STAMP(_rec, _stage)      cfl_trace_stamp((_rec), (_stage))
+#define CFL_TRACE_SET_CMD(_rec, _cmd_id)   cfl_trace_set_cmd((_rec), (_cmd_id))
+#define CFL_TRACE_END(_rec)                cfl_trace_end(_rec)
+#else
+#define CFL_TRACE_BEGIN(_kind, _node)      (NULL)
+#define CFL_TRACE_STAMP(_rec, _stage)      ((void)(_rec))
+#define CFL_TRACE_SET_CMD(_rec, _cmd_id)   ((void)(_rec))
+#define CFL_TRACE_END(_rec)                ((void)(_rec))
+#endif
+
+/* Types */
+
+typedef struct cfl_trace_record_s {
+    uint8_t kind;
+    uint8_t stage_mask; /* Bit per stage that was reached */
+    uint8_t complete;
+    uint16_t node;
+    uint16_t cmd_id;
+    uint32_t stamp[CFL_TRACE_STAGE_COUNT]; /* Cycle counter per stage */
+} cfl_trace_record_t;
+
+/* External Declarations */
+
+/**
+ * @brief Claim a record in the trace ring and stamp the first stage
+ * @param kind CFL_TRACE_KIND_SERVICE or CFL_TRACE_KIND_TRANSACTION
+ * @param node Peer node address
+ * @return Record to stamp, never NULL
+ */
+extern cfl_trace_record_t *cfl_trace_begin(uint8_t kind, uint16_t node);
+
+/**
+ * @brief Mark a record as complete and export it to the tracing subsystem
+ * @param rec Record returned by cfl_trace_begin()
+ */
+extern void cfl_trace_end(cfl_trace_record_t *rec);
+
+/**
+ * @brief Copy a completed record out of the ring
+ * @param age Index counted back from the newest record, 0 is the newest
+ * @param out Output record
+ * @return 0 on success, -ENOENT if there is no such record
+ */
+extern int32_t cfl_trace_get(size_t age, cfl_trace_record_t *out);
+
+/**
+ * @brief Discard all recorded traces
+ */
+extern void cfl_trace_clear(void);
+
+#if defined(CONFIG_CFL_TRACE)
+static inline void cfl_trace_stamp(cfl_trace_record_t *rec, uint8_t stage)
+{
+    if (rec != NULL)
+    {
+        rec->stamp[stage] = k_cycle_get_32();
+        rec->stage_mask |= (uint8_t)(1U << stage);
+    }
+}
+
+static inline void cfl_trace_set_cmd(cfl_trace_record_t *rec, uint16_t cmd_id)
+{
+    if (rec != NULL)
+    {
+        rec->cmd_id = cmd_id;
+    }
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_TRACE_H */
@@ -0,0 +1,89 @@
+/* cfl_transport.h - Datagram transport backends */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_TRANSPORT_H
+#define INC_CFL_TRANSPORT_H
+
+/* Includes */
+
+#include <stdint.h>
+
+#include "danp/danp_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+/*
+ * Datagram socket operations used by the service, cfl_transaction() and the
+ * async engine. Packets are DANP buffers on every backend, so the buffer pool
+ * and the CFL framing stay the same whatever carries them.
+ */
+typedef struct cfl_transport_ops_s {
+    const char *name;
+    /* Open a socket bound to port, 0 for an ephemeral port, negative error code on failure */
+    int32_t (*open)(void **sock, uint16_t port);
+    void (*close)(void *sock);
+    /* Takes the packet in every case, returns the bytes sent or a negative error code */
+    int32_t (*send_to)(void *sock, danp_packet_t *pkt, uint16_t node, uint16_t port);
+    /* NULL when nothing arrived within timeout_ms */
+    danp_packet_t *(*recv_from)(
+        void *sock,
+        uint16_t *node,
+        uint16_t *port,
+        uint32_t timeout_ms);
+} cfl_transport_ops_t;
+
+/* External Declarations */
+
+/* DANP datagram sockets */
+extern const cfl_transport_ops_t cfl_transport_danp;
+
+#if defined(CONFIG_CFL_TRANSPORT_UDP)
+/*
+ * UDP sockets. Node N port P is UDP port CONFIG_CFL_TRANSPORT_UDP_BASE_PORT +
+ * N * CONFIG_CFL_TRANSPORT_UDP_NODE_PORTS + P at the address of node N, so the
+ * sender of a datagram is known from its source port alone.
+ */
+extern const cfl_transport_ops_t cfl_transport_udp;
+
+/**
+ * @brief Set the IPv4 address of a node, nodes without one use
+ *        CONFIG_CFL_TRANSPORT_UDP_DEFAULT_ADDR
+ * @param node Node address
+ * @param addr Dotted IPv4 address, NULL to drop the entry
+ * @return 0 on success, -EINVAL on a malformed address, -ENOMEM if the peer
+ *         table is full
+ */
+extern int32_t cfl_transport_udp_set_peer(uint16_t node, const char *addr);
+#endif
+
+/**
+ * @brief Get the transport used by sockets opened from now on
+ * @return Selected transport, CONFIG_CFL_TRANSPORT_UDP_DEFAULT picks UDP
+ *         instead of DANP until cfl_transport_set() is called
+ */
+extern const cfl_transport_ops_t *cfl_transport_get(void);
+
+/**
+ * @brief Select the transport, call it before cfl_service_danp_init() and
+ *        cfl_async_init(), they keep the transport they started with
+ * @param ops Transport operations
+ * @return 0 on success, -EINVAL on missing operations
+ */
+extern int32_t cfl_transport_set(const cfl_transport_ops_t *ops);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_TRANSPORT_H */
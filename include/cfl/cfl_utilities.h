@@ -27,6 +27,27 @@ extern "C" {
 
 /* External Declarations */
 
+/**
+ * @brief Sequence number for the next outgoing request
+ *
+ * Shared by every client API so responses can be matched to requests sent
+ * from the same socket. Starts at a random number at boot, so peers that keep
+ * sessions do not take the requests of a restarted node for replays.
+ *
+ * @return Next sequence number, wraps at 16 bits and skips 0
+ */
+extern uint16_t cfl_next_seq(void);
+
+/**
+ * @brief Random number to seed sequence numbers with
+ *
+ * From the system random generator when one is configured, from the cycle
+ * counter otherwise.
+ *
+ * @return Random value
+ */
+extern uint32_t cfl_random32(void);
+
 extern ssize_t cfl_transaction(
     uint16_t dest_id,
     uint16_t cmd_id,
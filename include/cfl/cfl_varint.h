@@ -0,0 +1,84 @@
+/* cfl_varint.h - Variable length 16-bit integers of the compact header */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_VARINT_H
+#define INC_CFL_VARINT_H
+
+/* Includes */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+/* Bytes of the longest encoding, 7 value bits per byte */
+#define CFL_VARINT_MAX_LEN (3U)
+
+/* Types */
+
+
+/* Functions */
+
+/**
+ * @brief Encode a value, 7 bits per byte from the least significant ones on
+ * @param buf   Output buffer of at least CFL_VARINT_MAX_LEN bytes
+ * @param value Value to encode
+ * @return Bytes written, 1 to CFL_VARINT_MAX_LEN
+ */
+static inline size_t cfl_varint_put(uint8_t *buf, uint16_t value)
+{
+    size_t len = 0;
+
+    while (value >= 0x80U)
+    {
+        buf[len++] = (uint8_t)(value | 0x80U);
+        value >>= 7;
+    }
+    buf[len++] = (uint8_t)value;
+
+    return len;
+}
+
+/**
+ * @brief Decode a value
+ * @param buf   Encoded bytes
+ * @param size  Bytes available in buf
+ * @param value Output decoded value
+ * @return Bytes consumed, or -EINVAL if the encoding is truncated, longer than
+ *         CFL_VARINT_MAX_LEN or exceeds 16 bits
+ */
+static inline int32_t cfl_varint_get(const uint8_t *buf, size_t size, uint16_t *value)
+{
+    uint32_t result = 0;
+
+    for (size_t i = 0; i < size && i < CFL_VARINT_MAX_LEN; i++)
+    {
+        result |= (uint32_t)(buf[i] & 0x7FU) << (7 * i);
+        if ((buf[i] & 0x80U) == 0)
+        {
+            if (result > UINT16_MAX)
+            {
+                return -EINVAL;
+            }
+            *value = (uint16_t)result;
+            return (int32_t)(i + 1);
+        }
+    }
+
+    return -EINVAL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_VARINT_H */
@@ -0,0 +1,96 @@
+/* cfl_budget.h - Per-command handler execution budgets */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_BUDGET_H
+#define INC_CFL_BUDGET_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+typedef struct cfl_budget_stats_s {
+    uint16_t cmd_id;     /* Command ID */
+    uint32_t budget_us;  /* Budget per invocation, 0 if none */
+    uint32_t calls;      /* Handler invocations measured */
+    uint32_t avg_cycles; /* Average cycles per invocation */
+    uint32_t max_cycles; /* Worst case cycles of one invocation */
+    uint32_t overruns;   /* Invocations that exceeded the budget */
+    uint32_t stalls;     /* Invocations still running when the watchdog fired */
+    uint32_t refused;    /* Invocations refused while quarantined */
+    bool quarantined;    /* Currently refused after repeated overruns */
+} cfl_budget_stats_t;
+
+/* One handler invocation, lives on the stack of the calling thread */
+typedef struct cfl_budget_watch_s {
+    uint16_t cmd_id;
+    uint32_t start;
+    uint32_t budget_cycles;
+#if defined(CONFIG_CFL_BUDGET_WATCHDOG)
+    struct k_timer timer;
+#endif
+} cfl_budget_watch_t;
+
+/* External Declarations */
+
+/**
+ * @brief Start measuring a handler invocation
+ *
+ * Arms the watchdog when the command has a budget. Every successful call must
+ * be paired with cfl_budget_end() on the same thread.
+ *
+ * @param watch  Invocation state
+ * @param cmd_id Command about to run
+ * @return 0 if the handler may run, -EBUSY if the command is quarantined
+ */
+extern int32_t cfl_budget_begin(cfl_budget_watch_t *watch, uint16_t cmd_id);
+
+/**
+ * @brief Stop measuring a handler invocation and account its cycles
+ * @param watch Invocation state passed to cfl_budget_begin()
+ * @return true if the invocation exceeded its budget
+ */
+extern bool cfl_budget_end(cfl_budget_watch_t *watch);
+
+/**
+ * @brief Set the budget of a command
+ * @param cmd_id    Command ID
+ * @param budget_us Budget per invocation, 0 for CONFIG_CFL_BUDGET_DEFAULT_US
+ * @return 0 on success, -ENOMEM if the command table is full
+ */
+extern int32_t cfl_budget_set(uint16_t cmd_id, uint32_t budget_us);
+
+/**
+ * @brief Get the accounting of a command
+ * @param index Table index
+ * @param stats Output statistics
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_budget_get(size_t index, cfl_budget_stats_t *stats);
+
+/**
+ * @brief Clear all measurements and lift quarantines, configured budgets are kept
+ */
+extern void cfl_budget_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_BUDGET_H */
@@ -0,0 +1,81 @@
+/* cfl_pubsub.h - Telemetry subscriptions with server-side sampling */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_PUBSUB_H
+#define INC_CFL_PUBSUB_H
+
+/* Includes */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+typedef struct cfl_pubsub_stats_s {
+    uint16_t node;      /* Subscriber node address */
+    uint16_t port;      /* Subscriber port pushes are sent to */
+    uint16_t cmd_id;    /* Sampled telemetry command */
+    uint32_t period_ms; /* Push period */
+    uint32_t pushes;    /* Pushes sent */
+    uint32_t failures;  /* Samples or sends that failed */
+} cfl_pubsub_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Subscribe to a telemetry command of a remote node
+ *
+ * Pushes for cmd_id arrive on the local CFL service port and are dispatched to
+ * the local tmtc handler of cmd_id. The subscription lapses after the lease of
+ * the remote node, CONFIG_CFL_PUBSUB_LEASE_MS, call this again to renew it.
+ *
+ * @param dest_id   Node providing the telemetry
+ * @param cmd_id    Telemetry command to sample
+ * @param period_ms Push period in milliseconds
+ * @param timeout   Transaction timeout in milliseconds
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_pubsub_subscribe(
+    uint16_t dest_id,
+    uint16_t cmd_id,
+    uint32_t period_ms,
+    uint32_t timeout);
+
+/**
+ * @brief Cancel a subscription on a remote node
+ * @param dest_id Node providing the telemetry
+ * @param cmd_id  Telemetry command
+ * @param timeout Transaction timeout in milliseconds
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_pubsub_unsubscribe(uint16_t dest_id, uint16_t cmd_id, uint32_t timeout);
+
+/**
+ * @brief Get an entry of the local subscriber table
+ * @param index Table index
+ * @param stats Output subscription state
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_pubsub_get(size_t index, cfl_pubsub_stats_t *stats);
+
+/**
+ * @brief Drop all subscriptions held by this node
+ */
+extern void cfl_pubsub_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_PUBSUB_H */
@@ -0,0 +1,81 @@
+/* cfl_ratelimit.h - Per-source and per-command rate limiting */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_RATELIMIT_H
+#define INC_CFL_RATELIMIT_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+typedef struct cfl_ratelimit_stats_s {
+    uint16_t id;      /* Source node or command ID */
+    uint32_t tokens;  /* Tokens currently available */
+    uint32_t passed;  /* Messages let through */
+    uint32_t limited; /* Messages rejected */
+} cfl_ratelimit_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Check and consume a token for a message
+ *
+ * A token is taken from the node bucket and from the command bucket, if the
+ * command has one, only when both have one left.
+ *
+ * @param src_node Source node address
+ * @param cmd_id   Message ID
+ * @return true if the message may be dispatched, false if it is over the limit
+ */
+extern bool cfl_ratelimit_allow(uint16_t src_node, uint16_t cmd_id);
+
+/**
+ * @brief Add, update or remove a per-command bucket
+ * @param cmd_id Message ID to limit
+ * @param rate   Sustained messages per second, 0 removes the bucket
+ * @param burst  Maximum number of tokens
+ * @return 0 on success, -ENOMEM if the command table is full
+ */
+extern int32_t cfl_ratelimit_set_cmd(uint16_t cmd_id, uint32_t rate, uint32_t burst);
+
+/**
+ * @brief Get statistics of a node bucket
+ * @param index Table index
+ * @param stats Output statistics
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_ratelimit_get_node(size_t index, cfl_ratelimit_stats_t *stats);
+
+/**
+ * @brief Get statistics of a command bucket
+ * @param index Table index
+ * @param stats Output statistics
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_ratelimit_get_cmd(size_t index, cfl_ratelimit_stats_t *stats);
+
+/**
+ * @brief Forget all node buckets and reset counters
+ */
+extern void cfl_ratelimit_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_RATELIMIT_H */
@@ -0,0 +1,111 @@
+/* cfl_registry.h - Runtime command handler registration */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_REGISTRY_H
+#define INC_CFL_REGISTRY_H
+
+/* Includes */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "zephyr/tmtc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+/* Same contract as a tmtc handler, with the source node and the registration context */
+typedef int32_t (*cfl_registry_handler_t)(
+    void *ctx,
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+
+typedef struct cfl_registry_entry_s {
+    uint16_t cmd_id;
+    cfl_registry_handler_t handler;
+    void *ctx;
+} cfl_registry_entry_t;
+
+typedef struct cfl_registry_stats_s {
+    uint32_t entries;  /* Registered handlers */
+    uint32_t version;  /* Tables published since boot */
+    uint32_t retries;  /* Lookups that raced a publish and read the new table */
+    uint32_t waits_ms; /* Time updates spent waiting for lookups of the old table */
+} cfl_registry_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Add a handler, it takes precedence over the tmtc handler of the same ID
+ *
+ * Lookups keep running on the current table while the new one is built, the
+ * caller waits instead of the dispatch path. Must not be called from a handler.
+ *
+ * @param cmd_id  Command ID, below CFL_EXT_CMD_BASE
+ * @param handler Handler run for requests and pushes with this ID
+ * @param ctx     Passed to every call of the handler
+ * @return 0 on success, -EINVAL on a reserved ID or a NULL handler, -EEXIST if
+ *         the ID has a handler already, -ENOMEM if the table is full
+ */
+extern int32_t cfl_registry_register(uint16_t cmd_id, cfl_registry_handler_t handler, void *ctx);
+
+/**
+ * @brief Remove a handler
+ *
+ * Returns once no message is dispatched to it anymore, so the code and the
+ * context of the handler can be released afterwards. Must not be called from
+ * a handler.
+ *
+ * @param cmd_id Command ID
+ * @return 0 on success, -ENOENT if the ID has no handler
+ */
+extern int32_t cfl_registry_unregister(uint16_t cmd_id);
+
+/**
+ * @brief Get a registered handler, entries are ordered by command ID
+ * @param index Table index
+ * @param entry Output entry
+ * @return 0 on success, -EINVAL past the last entry
+ */
+extern int32_t cfl_registry_get(size_t index, cfl_registry_entry_t *entry);
+
+/**
+ * @brief Get a snapshot of the registry counters
+ * @param stats Output statistics
+ */
+extern void cfl_registry_get_stats(cfl_registry_stats_t *stats);
+
+/**
+ * @brief Find the handler of a command for dispatch, without taking a lock
+ *
+ * The entry stays valid, and its handler registered, until
+ * cfl_registry_release() is called with the same reference.
+ *
+ * @param cmd_id Command ID
+ * @param ref    Output reference, only set when an entry is returned
+ * @return Entry of the command, NULL if it has none
+ */
+extern const cfl_registry_entry_t *cfl_registry_acquire(uint16_t cmd_id, uint32_t *ref);
+
+/**
+ * @brief End the use of an entry returned by cfl_registry_acquire()
+ * @param ref Reference set by cfl_registry_acquire()
+ */
+extern void cfl_registry_release(uint32_t ref);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_REGISTRY_H */
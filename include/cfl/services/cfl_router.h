@@ -0,0 +1,123 @@
+/* cfl_router.h - Command range routing between nodes */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_ROUTER_H
+#define INC_CFL_ROUTER_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cfl/cfl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+/* Messages with cmd_min <= cmd_id <= cmd_max are sent on to dst_node:dst_port */
+typedef struct cfl_route_s {
+    uint16_t cmd_min;  /* First command ID of the range */
+    uint16_t cmd_max;  /* Last command ID of the range, inclusive */
+    uint16_t dst_node; /* Next hop node address */
+    uint16_t dst_port; /* Next hop port, usually its CFL service port */
+} cfl_route_t;
+
+/* Where the service sends a routed packet */
+typedef struct cfl_router_hop_s {
+    uint16_t node;
+    uint16_t port;
+    bool compact; /* Next hop accepts compact headers */
+} cfl_router_hop_t;
+
+typedef struct cfl_router_stats_s {
+    uint32_t forwarded; /* Requests and pushes sent on */
+    uint32_t replies;   /* Replies returned to the requester */
+    uint32_t unmatched; /* Replies without a pending request */
+    uint32_t overflow;  /* Requests refused with the pending table full */
+    uint32_t expired;   /* Pending requests reclaimed without a reply */
+    uint32_t looped;    /* Messages dropped because the route points back */
+    uint32_t pending;   /* Requests currently waiting for a reply */
+} cfl_router_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Add a route, the first matching route wins
+ * @param route Route to add
+ * @return 0 on success, -EINVAL on an empty range, -ENOMEM if the table is full
+ */
+extern int32_t cfl_router_add(const cfl_route_t *route);
+
+/**
+ * @brief Remove the route of a command range
+ * @param cmd_min First command ID of the range
+ * @param cmd_max Last command ID of the range
+ * @return 0 on success, -ENOENT if no route has this range
+ */
+extern int32_t cfl_router_remove(uint16_t cmd_min, uint16_t cmd_max);
+
+/**
+ * @brief Get an entry of the route table
+ * @param index Table index
+ * @param route Output route
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_router_get_route(size_t index, cfl_route_t *route);
+
+/**
+ * @brief Get a snapshot of the router counters
+ * @param stats Output statistics
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_router_get_stats(cfl_router_stats_t *stats);
+
+/**
+ * @brief Route a received request or push
+ *
+ * Called by the service for every valid message before local dispatch. A
+ * routed request gets a router-wide sequence number in msg->seq so replies of
+ * different requesters cannot be confused; the original one is restored by
+ * cfl_router_return(). Only the header is written, the payload is untouched.
+ *
+ * @param src_node Source node address
+ * @param src_port Source port
+ * @param compact  The message arrived with a compact header
+ * @param msg      Message with a full header
+ * @param next     Output next hop
+ * @return 0 if the message is to be sent to next, -ENOENT if no route matches,
+ *         -EBUSY if the pending table is full, -ELOOP if the route points back
+ *         to the source
+ */
+extern int32_t cfl_router_forward(
+    uint16_t src_node,
+    uint16_t src_port,
+    bool compact,
+    cfl_message_t *msg,
+    cfl_router_hop_t *next);
+
+/**
+ * @brief Route a received ACK, NACK or reply back to its requester
+ * @param src_node Node the reply came from
+ * @param msg      Reply with a full header, msg->seq is restored on success
+ * @param next     Output requester
+ * @return 0 if the reply is to be sent to next, -ENOENT if it matches no
+ *         forwarded request
+ */
+extern int32_t cfl_router_return(uint16_t src_node, cfl_message_t *msg, cfl_router_hop_t *next);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_ROUTER_H */
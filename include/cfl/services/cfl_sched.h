@@ -0,0 +1,91 @@
+/* cfl_sched.h - Time-tagged command queue */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_SCHED_H
+#define INC_CFL_SCHED_H
+
+/* Includes */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+typedef struct cfl_sched_info_s {
+    uint32_t id;        /* Handle used to cancel the command */
+    int64_t exec_at_ms; /* Uptime the command runs at */
+    uint16_t src_node;  /* Node that queued the command, 0 for local */
+    uint16_t cmd_id;    /* Command to run */
+    uint16_t data_len;  /* Request data length */
+} cfl_sched_info_t;
+
+typedef struct cfl_sched_stats_s {
+    uint32_t queued;   /* Commands currently waiting */
+    uint32_t executed; /* Commands run successfully */
+    uint32_t failed;   /* Commands whose handler returned an error */
+    uint32_t rejected; /* Commands refused because the queue was full */
+} cfl_sched_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Queue a command for local execution at a future time
+ * @param exec_at_ms Uptime in milliseconds the command runs at
+ * @param cmd_id     Command to run
+ * @param data       Request data
+ * @param data_len   Request data length
+ * @param id         Output handle for cfl_sched_cancel(), may be NULL
+ * @return 0 on success, -ENOMEM if the queue is full, -EMSGSIZE if data is
+ *         larger than CONFIG_CFL_SCHED_MAX_DATA, -ENOENT if cmd_id is reserved
+ *         or has no handler
+ */
+extern int32_t cfl_sched_add(
+    int64_t exec_at_ms,
+    uint16_t cmd_id,
+    const uint8_t *data,
+    uint16_t data_len,
+    uint32_t *id);
+
+/**
+ * @brief Remove a queued command
+ * @param id Handle returned when the command was queued
+ * @return 0 on success, -ENOENT if the command already ran or is unknown
+ */
+extern int32_t cfl_sched_cancel(uint32_t id);
+
+/**
+ * @brief Drop every queued command
+ * @return Number of commands dropped
+ */
+extern size_t cfl_sched_flush(void);
+
+/**
+ * @brief Get a queued command by queue slot
+ * @param index Slot index
+ * @param info  Output command description
+ * @return 0 on success, -ENOENT if the slot is not queued, -EINVAL past the end
+ */
+extern int32_t cfl_sched_get(size_t index, cfl_sched_info_t *info);
+
+/**
+ * @brief Get queue counters
+ * @param stats Output statistics
+ */
+extern void cfl_sched_get_stats(cfl_sched_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_SCHED_H */
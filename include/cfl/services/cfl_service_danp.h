@@ -8,7 +8,9 @@
 /* Includes */
 
 #include <stdint.h>
-#include "osal/osal_thread.h"
+
+#include "cfl/cfl_thread.h"
+#include "cfl/cfl_transport.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,11 +19,11 @@ extern "C" {
 /* Configurations */
 
 #ifndef CFL_DANP_RX_TASK_STACK_SIZE
-#define CFL_DANP_RX_TASK_STACK_SIZE (2048)
+#define CFL_DANP_RX_TASK_STACK_SIZE (CONFIG_CFL_SERVICE_RX_STACK_SIZE)
 #endif
 
 #ifndef CFL_DANP_RX_TASK_PRIORITY
-#define CFL_DANP_RX_TASK_PRIORITY (OSAL_THREAD_PRIORITY_NORMAL)
+#define CFL_DANP_RX_TASK_PRIORITY (CONFIG_CFL_SERVICE_RX_PRIORITY)
 #endif
 
 #ifndef CFL_DANP_MAX_HANDLERS
@@ -39,8 +41,34 @@ extern "C" {
 
 typedef struct cfl_service_danp_config_s {
     uint16_t port_id;
+    /* RX thread placement, NULL for the Kconfig defaults */
+    const cfl_thread_attr_t *rx_thread;
+    /* Processing thread placement with CONFIG_CFL_SERVICE_RX_SPLIT, NULL for the defaults */
+    const cfl_thread_attr_t *proc_thread;
+    /* Datagram transport, NULL for cfl_transport_get() */
+    const cfl_transport_ops_t *transport;
 } cfl_service_danp_config_t;
 
+typedef struct cfl_service_danp_stats_s {
+    uint32_t rx_packets;   /* Packets received on the service socket */
+    uint32_t rx_invalid;   /* Malformed or unknown messages */
+    uint32_t rx_requests;  /* Requests dispatched to handlers */
+    uint32_t rx_pushes;    /* Pushes dispatched to handlers */
+    uint32_t rate_limited; /* Messages rejected by the rate limiter */
+    uint32_t rx_compact;   /* Messages received with a compact header */
+    uint32_t rx_dropped;   /* Packets dropped on a full RX ring */
+    uint32_t push_acks;    /* Cumulative ACKs sent for received reliable pushes */
+    uint32_t push_acked;   /* Received reliable pushes those ACKs covered */
+    uint32_t push_retries; /* Reliable pushes sent again for lack of an ACK */
+    uint32_t push_lost;    /* Reliable pushes given up after the last retry */
+    uint32_t duplicates;   /* Requests and reliable pushes dropped as seen before */
+} cfl_service_danp_stats_t;
+
+typedef struct cfl_service_danp_token_s {
+    uint16_t slot;
+    uint16_t generation;
+} cfl_service_danp_token_t;
+
 /* External Declarations */
 
 /**
@@ -56,6 +84,54 @@ extern int32_t cfl_service_danp_init(const cfl_service_danp_config_t *config);
  */
 extern int32_t cfl_service_danp_deinit(void);
 
+/**
+ * @brief Get the service RX thread, e.g. to move it with cfl_thread_place()
+ * @return Thread ID, or NULL if the service is not running
+ */
+extern k_tid_t cfl_service_danp_rx_thread(void);
+
+/**
+ * @brief Get the thread dispatching packets with CONFIG_CFL_SERVICE_RX_SPLIT
+ * @return Thread ID, or NULL if the service is not running or not split
+ */
+extern k_tid_t cfl_service_danp_proc_thread(void);
+
+/**
+ * @brief Get a snapshot of the service counters
+ * @param stats Output statistics
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_service_danp_get_stats(cfl_service_danp_stats_t *stats);
+
+/**
+ * @brief Defer the reply of the request currently being handled
+ *
+ * Must be called from within a request handler, i.e. on the service RX
+ * thread. The service sends no ACK or reply for the request when the handler
+ * returns; the final status is sent by cfl_service_danp_complete(). Request
+ * data is only valid until the handler returns, copy what is needed later.
+ *
+ * @param token Output reply token
+ * @return 0 on success, -ENOMEM if all deferred slots are busy,
+ *         -EINVAL if not called from a request handler dispatched by the
+ *         service, such as one run by cfl_service_danp_execute()
+ */
+extern int32_t cfl_service_danp_defer(cfl_service_danp_token_t *token);
+
+/**
+ * @brief Complete a deferred request from any thread
+ * @param token       Token obtained with cfl_service_danp_defer()
+ * @param status      Negative error code to send a NACK, otherwise success
+ * @param payload     Reply data (can be NULL if payload_len is 0)
+ * @param payload_len Reply length in bytes, 0 sends a plain ACK
+ * @return 0 on success, -ENOENT if the token expired or was already completed
+ */
+extern int32_t cfl_service_danp_complete(
+    const cfl_service_danp_token_t *token,
+    int32_t status,
+    const uint8_t *payload,
+    uint16_t payload_len);
+
 /**
  * @brief Send a request message
  * @param dst_node    Destination node address
@@ -63,7 +139,8 @@ extern int32_t cfl_service_danp_deinit(void);
  * @param id          Message ID
  * @param payload     Payload data (can be NULL if payload_len is 0)
  * @param payload_len Payload length in bytes
- * @param seq_out     Optional output for sequence number used
+ * @param seq_out     Optional output for the sequence number of the request, the
+ *                    one its status or reply carries back
  * @return 0 on success, negative error code on failure
  */
 extern int32_t cfl_service_danp_send_request(
@@ -90,6 +167,32 @@ extern int32_t cfl_service_danp_send_push(
     const uint8_t *payload,
     uint16_t payload_len);
 
+/**
+ * @brief Send a push message the receiver acknowledges
+ *
+ * The push carries CFL_EXT_F_PUSH_RELIABLE and a per-destination sequence
+ * number. The receiver acknowledges consecutive pushes with a single
+ * CFL_EXT_CMD_PUSH_ACK frame, after CONFIG_CFL_SERVICE_PUSH_ACK_COUNT pushes
+ * or CONFIG_CFL_SERVICE_PUSH_ACK_DELAY_MS. Until then the push is kept and sent
+ * again every CONFIG_CFL_SERVICE_PUSH_ACK_RETRY_MS, so it may be handled more
+ * than once.
+ *
+ * @param dst_node    Destination node address
+ * @param dst_port    Destination port
+ * @param id          Message ID
+ * @param payload     Payload data (can be NULL if payload_len is 0)
+ * @param payload_len Payload length, at most CONFIG_CFL_SERVICE_PUSH_ACK_MAX_DATA
+ * @return 0 on success, -EMSGSIZE if the payload is too long, -EBUSY if
+ *         CONFIG_CFL_SERVICE_PUSH_ACK_WINDOW pushes are unacknowledged, -ENOMEM
+ *         if no peer slot is free, negative error code on other failures
+ */
+extern int32_t cfl_service_danp_send_push_reliable(
+    uint16_t dst_node,
+    uint16_t dst_port,
+    uint16_t id,
+    const uint8_t *payload,
+    uint16_t payload_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,102 @@
+/* cfl_session.h - Per-peer session state and duplicate detection */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_SESSION_H
+#define INC_CFL_SESSION_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_seq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+/* Sequence numbers remembered behind the newest one of a stream */
+#define CFL_SESSION_WINDOW (CFL_SEQ_WINDOW)
+
+/* Types */
+
+typedef enum cfl_session_verdict_e {
+    CFL_SESSION_NEW,       /* Not seen before, or not sequence checked */
+    CFL_SESSION_DUPLICATE, /* Seen before within the window */
+    CFL_SESSION_STALE,     /* Older than the window, a replay or a restarted peer */
+} cfl_session_verdict_t;
+
+typedef struct cfl_session_info_s {
+    uint16_t node;       /* Peer node address */
+    uint16_t port;       /* Port of its last message */
+    uint32_t idle_ms;    /* Time since its last message */
+    uint32_t rx_msgs;    /* Messages received */
+    uint32_t rx_bytes;   /* Bytes received, CFL headers included */
+    uint32_t duplicates; /* Requests and reliable pushes dropped as seen before */
+    uint32_t stale;      /* Dropped as older than the window */
+    uint16_t rqst_top;   /* Newest request sequence number */
+    uint16_t push_top;   /* Newest reliable push sequence number */
+} cfl_session_info_t;
+
+typedef struct cfl_session_stats_s {
+    uint32_t created;    /* Sessions started for a new peer */
+    uint32_t evicted;    /* Sessions of the least recently active peer reused */
+    uint32_t duplicates; /* Messages dropped as duplicates */
+    uint32_t stale;      /* Messages dropped as older than the window */
+    uint32_t resyncs;    /* Windows restarted after repeated stale messages */
+} cfl_session_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Account a received message to its peer and check it was not seen before
+ *
+ * Requests and reliable pushes carry a sequence number per sender, each kind
+ * is checked against its own window of the last CFL_SESSION_WINDOW numbers.
+ * Requests numbered 0 are unsequenced, as older senders number them all, and
+ * like other messages are only counted. Sessions are keyed by node only, senders
+ * number requests per node whatever port they send from.
+ *
+ * @param node Source node
+ * @param port Source port
+ * @param msg  Validated message
+ * @return CFL_SESSION_NEW to dispatch the message, CFL_SESSION_DUPLICATE or
+ *         CFL_SESSION_STALE to drop it
+ */
+extern cfl_session_verdict_t cfl_session_accept(
+    uint16_t node,
+    uint16_t port,
+    const cfl_message_t *msg);
+
+/**
+ * @brief Get a session
+ * @param index Table index
+ * @param info  Output session state
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_session_get(size_t index, cfl_session_info_t *info);
+
+/**
+ * @brief Get a snapshot of the session counters
+ * @param stats Output statistics
+ */
+extern void cfl_session_get_stats(cfl_session_stats_t *stats);
+
+/**
+ * @brief Forget every peer, called by cfl_service_danp_deinit()
+ */
+extern void cfl_session_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_SESSION_H */
@@ -0,0 +1,131 @@
+/* cfl_stream.h - CFL framing over DANP stream sockets */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_STREAM_H
+#define INC_CFL_STREAM_H
+
+/* Includes */
+
+#include <stdint.h>
+
+#include "danp/danp_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+/*
+ * Source node handlers see for messages received on a stream connection, the
+ * node of a stream peer is unknown. Reserved commands, which keep state per
+ * requesting node, are refused on streams with -ENOTSUP.
+ */
+#define CFL_STREAM_SRC_NODE (0U)
+
+/* Types */
+
+/* Client side of one connection */
+typedef struct cfl_stream_s {
+    danp_socket_t *sock;
+    uint16_t node;
+} cfl_stream_t;
+
+typedef struct cfl_stream_stats_s {
+    uint32_t accepted;  /* Connections accepted by the server */
+    uint32_t frames_rx; /* Frames dispatched by the server */
+    uint32_t frames_tx; /* Status and reply frames written by the server */
+    uint32_t resyncs;   /* Bytes skipped looking for a sync word */
+    uint32_t errors;    /* Connections closed on a malformed frame or a write failure */
+} cfl_stream_stats_t;
+
+/* External Declarations */
+
+/**
+ * @brief Start accepting connections on CONFIG_CFL_STREAM_PORT
+ *
+ * Called by cfl_service_danp_init(). Frames received on a connection are
+ * dispatched to the handlers of the datagram service, one connection at a time.
+ *
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_stream_server_start(void);
+
+/**
+ * @brief Close the server and its connection, called by cfl_service_danp_deinit()
+ */
+extern void cfl_stream_server_stop(void);
+
+/**
+ * @brief Get a snapshot of the server counters
+ * @param stats Output statistics
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_stream_get_stats(cfl_stream_stats_t *stats);
+
+/**
+ * @brief Connect to the stream server of a node
+ * @param stream Connection to open
+ * @param node   Node address
+ * @param port   Stream port, 0 for CONFIG_CFL_STREAM_PORT
+ * @return 0 on success, -ENOMEM if no socket is available, negative error code
+ *         if the connection is refused
+ */
+extern int32_t cfl_stream_open(cfl_stream_t *stream, uint16_t node, uint16_t port);
+
+/**
+ * @brief Close a connection
+ * @param stream Connection opened with cfl_stream_open()
+ */
+extern void cfl_stream_close(cfl_stream_t *stream);
+
+/**
+ * @brief Write a push message, blocks while the peer is not reading
+ * @param stream      Open connection
+ * @param cmd_id      Message ID
+ * @param payload     Payload data (can be NULL if payload_len is 0)
+ * @param payload_len Payload length in bytes
+ * @return 0 on success, -EMSGSIZE if the message does not fit a DANP packet,
+ *         -ECONNRESET if the connection is lost
+ */
+extern int32_t cfl_stream_push(
+    cfl_stream_t *stream,
+    uint16_t cmd_id,
+    const uint8_t *payload,
+    uint16_t payload_len);
+
+/**
+ * @brief Send a request and wait for its ACK, NACK or reply
+ *
+ * Frames for other sequence numbers, such as replies to requests that timed
+ * out earlier, are skipped.
+ *
+ * @param stream      Open connection
+ * @param cmd_id      Command ID
+ * @param request     Request data (can be NULL if request_len is 0)
+ * @param request_len Request length in bytes
+ * @param reply       Reply buffer, NULL to only get the reply length
+ * @param reply_size  Reply buffer size
+ * @param timeout     Time to wait for the answer in milliseconds
+ * @return 0 on ACK, reply length on reply, the status carried by a NACK,
+ *         -ENOBUFS if the reply does not fit, -ETIMEDOUT, -ECONNRESET if the
+ *         connection is lost
+ */
+extern int32_t cfl_stream_transaction(
+    cfl_stream_t *stream,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len,
+    uint8_t *reply,
+    uint16_t reply_size,
+    uint32_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_STREAM_H */
@@ -0,0 +1,134 @@
+/* cfl_xfer.h - Windowed file and blob transfer */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_XFER_H
+#define INC_CFL_XFER_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+struct flash_area;
+
+/* Where a receiver stores an object, offsets are relative to its start */
+typedef struct cfl_xfer_ops_s {
+    /* Prepare for size bytes (erase flash, check room), called when a transfer starts */
+    int32_t (*open)(void *ctx, uint32_t size);
+    int32_t (*write)(void *ctx, uint32_t offset, const uint8_t *data, uint16_t len);
+    /* Reads back what was written, for the end-to-end CRC */
+    int32_t (*read)(void *ctx, uint32_t offset, uint8_t *data, uint16_t len);
+} cfl_xfer_ops_t;
+
+/* Context of cfl_xfer_ram_ops */
+typedef struct cfl_xfer_ram_s {
+    uint8_t *buf;
+    size_t size;
+} cfl_xfer_ram_t;
+
+#if defined(CONFIG_FLASH_MAP)
+/* Context of cfl_xfer_flash_ops, chunk sizes must be a multiple of the write block size */
+typedef struct cfl_xfer_flash_s {
+    uint8_t area_id;
+    const struct flash_area *area; /* Opened by the transfer */
+} cfl_xfer_flash_t;
+#endif
+
+/* Sender data source */
+typedef int32_t (*cfl_xfer_read_t)(void *ctx, uint32_t offset, uint8_t *data, uint16_t len);
+
+typedef struct cfl_xfer_info_s {
+    uint16_t xfer_id;   /* Transfer ID */
+    uint16_t src_node;  /* Node sending the object */
+    uint32_t object;    /* Object ID */
+    uint32_t size;      /* Object size in bytes */
+    uint32_t chunks;    /* Chunks in the object */
+    uint32_t received;  /* Chunks held */
+    uint32_t idle_ms;   /* Time since the last chunk or request */
+} cfl_xfer_info_t;
+
+/* External Declarations */
+
+/* RAM target, ctx is a cfl_xfer_ram_t */
+extern const cfl_xfer_ops_t cfl_xfer_ram_ops;
+
+#if defined(CONFIG_FLASH_MAP)
+/* Flash area target, ctx is a cfl_xfer_flash_t, the whole area is erased on open */
+extern const cfl_xfer_ops_t cfl_xfer_flash_ops;
+#endif
+
+/**
+ * @brief Let peers transfer an object to this node
+ * @param object Object ID senders open
+ * @param ops    Storage operations
+ * @param ctx    Passed to every operation
+ * @return 0 on success, -EINVAL on missing operations, -EEXIST if the object is
+ *         registered already, -ENOMEM if the target table is full
+ */
+extern int32_t cfl_xfer_register(uint32_t object, const cfl_xfer_ops_t *ops, void *ctx);
+
+/**
+ * @brief Send an object to a node and wait until it is stored and verified
+ *
+ * Keeps up to CONFIG_CFL_XFER_WINDOW chunks in flight as pushes, then asks
+ * the receiver which chunks it holds and re-sends the holes. Calling it
+ * again after a failure resumes where the receiver stopped. Needs the CFL
+ * service to be initialized.
+ *
+ * @param node   Receiver node address
+ * @param object Object ID registered on the receiver
+ * @param size   Object size in bytes
+ * @param read   Reads object data, called more than once for the same range
+ * @param ctx    Passed to read
+ * @return 0 on success, -ETIMEDOUT if the receiver stopped making progress,
+ *         -EBADMSG if the stored object does not match its CRC, -EIO if the
+ *         receiver refused the transfer, negative error code of read
+ */
+extern int32_t cfl_xfer_send(
+    uint16_t node,
+    uint32_t object,
+    uint32_t size,
+    cfl_xfer_read_t read,
+    void *ctx);
+
+/**
+ * @brief Send an object held in memory, see cfl_xfer_send()
+ * @param node   Receiver node address
+ * @param object Object ID registered on the receiver
+ * @param data   Object data
+ * @param size   Object size in bytes
+ * @return 0 on success, negative error code on failure
+ */
+extern int32_t cfl_xfer_send_buffer(
+    uint16_t node,
+    uint32_t object,
+    const uint8_t *data,
+    uint32_t size);
+
+/**
+ * @brief Get a receiving transfer
+ * @param index Table index
+ * @param info  Output transfer state
+ * @return 0 on success, -ENOENT if the slot is unused, -EINVAL past the end
+ */
+extern int32_t cfl_xfer_get(size_t index, cfl_xfer_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_XFER_H */
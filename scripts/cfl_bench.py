@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""cfl_bench.py - Benchmark results against a stored baseline
+
+Usage:
+    cfl_bench.py save <results.log> -o <baseline.json>
+    cfl_bench.py compare <baseline.json> <results.log> [--tolerance PCT]
+
+Results are the JSON lines printed by the benchmark built with
+CFL_BENCH_JSON=ON, or written by the host benchmark with --json. Console
+prefixes before the JSON object are ignored, so a raw console log works.
+
+save     Keep the results of a run as the baseline of later runs.
+compare  Print every case next to its baseline and exit with status 1 when a
+         case is slower than the baseline by more than --tolerance percent
+         (default 10). Cases missing on either side are only reported.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_results(path):
+    results = {}
+
+    with open(path, "r", errors="replace") as log:
+        for line in log:
+            start = line.find("{")
+            if start < 0:
+                continue
+            try:
+                entry = json.loads(line[start:])
+            except ValueError:
+                continue
+            if "case" in entry and "ns" in entry:
+                results[entry["case"]] = entry
+
+    return results
+
+
+def save(args):
+    results = load_results(args.log)
+    if not results:
+        sys.exit("no benchmark results in %s" % args.log)
+
+    with open(args.output, "w") as out:
+        json.dump(results, out, indent=2, sort_keys=True)
+        out.write("\n")
+
+    print("%s: %d cases" % (args.output, len(results)))
+
+
+def compare(args):
+    with open(args.baseline, "r") as f:
+        baseline = json.load(f)
+    results = load_results(args.log)
+    if not results:
+        sys.exit("no benchmark results in %s" % args.log)
+
+    regressions = 0
+    print("%-32s %12s %12s %8s" % ("case", "baseline ns", "ns", "change"))
+    for name in sorted(set(baseline) | set(results)):
+        if name not in results:
+            print("%-32s %12s %12s %8s" % (name, baseline[name]["ns"], "-", "missing"))
+            continue
+        if name not in baseline:
+            print("%-32s %12s %12s %8s" % (name, "-", results[name]["ns"], "new"))
+            continue
+
+        old = float(baseline[name]["ns"])
+        new = float(results[name]["ns"])
+        change = (new - old) * 100.0 / old if old > 0 else 0.0
+        mark = ""
+        if change > args.tolerance:
+            mark = "  REGRESSION"
+            regressions += 1
+        print("%-32s %12g %12g %+7.1f%%%s" % (name, old, new, change, mark))
+
+    if regressions:
+        sys.exit("%d case(s) slower than the baseline by more than %g%%" % (regressions, args.tolerance))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    cmd = commands.add_parser("save", help="results to baseline")
+    cmd.add_argument("log")
+    cmd.add_argument("-o", "--output", required=True)
+    cmd.set_defaults(func=save)
+
+    cmd = commands.add_parser("compare", help="results against a baseline")
+    cmd.add_argument("baseline")
+    cmd.add_argument("log")
+    cmd.add_argument("--tolerance", type=float, default=10.0)
+    cmd.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
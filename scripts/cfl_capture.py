@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""cfl_capture.py - Host side tools for CFL packet captures
+
+Usage:
+    cfl_capture.py extract <console.log> -o <capture.pcap>
+    cfl_capture.py show <capture.pcap>
+    cfl_capture.py replay <capture.pcap> [--speed N] -o <replay_capture.inc>
+
+extract  Pull the stream printed by `cfl capture dump` out of a console log
+         and write it as a pcap file (LINKTYPE_USER0, see cfl/cfl_capture.h).
+show     Print one line per captured frame with the decoded CFL header.
+replay   Turn the received frames of a capture into the input of the
+         benchmark replay case, which feeds them back through the service.
+         --speed scales the recorded gaps (2 replays twice as fast), 0 sends
+         the frames back to back.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+BEGIN_MARKER = "-----BEGIN CFL CAPTURE-----"
+END_MARKER = "-----END CFL CAPTURE-----"
+
+PCAP_MAGIC = 0xA1B2C3D4
+PCAP_LINKTYPE = 147
+PCAP_FILE_HDR = struct.Struct("<IHHiIII")
+PCAP_REC_HDR = struct.Struct("<IIII")
+PSEUDO_HDR = struct.Struct("<BBHH")
+
+DIR_RX = 0
+DIR_TX = 1
+
+# cfl_message_t from cfl/cfl.h: sync, version, flags, cmd_id, seq, length
+FULL_HDR = struct.Struct("<HBBHHH")
+COMPACT_SYNC = 0xC5
+
+HEX_LINE = re.compile(r"([0-9a-f]+)\s*$")
+
+
+def extract(args):
+    data = bytearray()
+    inside = False
+
+    with open(args.log, "r", errors="replace") as log:
+        for line in log:
+            if BEGIN_MARKER in line:
+                data.clear()
+                inside = True
+                continue
+            if END_MARKER in line:
+                inside = False
+                continue
+            if inside:
+                match = HEX_LINE.search(line)
+                if match:
+                    data += bytes.fromhex(match.group(1))
+
+    if not data:
+        sys.exit("no capture found in %s" % args.log)
+
+    with open(args.output, "wb") as out:
+        out.write(data)
+
+    print("%s: %d frames" % (args.output, len(read_pcap(args.output))))
+
+
+def read_pcap(path):
+    frames = []
+
+    with open(path, "rb") as pcap:
+        blob = pcap.read()
+
+    magic, _, _, _, _, _, linktype = PCAP_FILE_HDR.unpack_from(blob, 0)
+    if magic != PCAP_MAGIC or linktype != PCAP_LINKTYPE:
+        sys.exit("%s is not a CFL capture" % path)
+
+    offset = PCAP_FILE_HDR.size
+    while offset + PCAP_REC_HDR.size <= len(blob):
+        sec, usec, incl_len, orig_len = PCAP_REC_HDR.unpack_from(blob, offset)
+        offset += PCAP_REC_HDR.size
+        record = blob[offset : offset + incl_len]
+        offset += incl_len
+
+        direction, _, node, port = PSEUDO_HDR.unpack_from(record, 0)
+        frames.append(
+            {
+                "us": sec * 1000000 + usec,
+                "dir": direction,
+                "node": node,
+                "port": port,
+                "len": orig_len - PSEUDO_HDR.size,
+                "data": record[PSEUDO_HDR.size :],
+            }
+        )
+
+    return frames
+
+
+def read_leb128(data, offset):
+    value = 0
+    shift = 0
+    while offset < len(data):
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, offset
+        shift += 7
+    raise ValueError("truncated")
+
+
+def decode_header(data):
+    """Returns (format, flags, cmd_id, seq, length) or None"""
+    try:
+        if data and data[0] == COMPACT_SYNC:
+            flags = data[1] & 0x1F
+            cmd_id, offset = read_leb128(data, 2)
+            seq, offset = read_leb128(data, offset)
+            length, offset = read_leb128(data, offset)
+            return ("compact", flags, cmd_id, seq, length)
+        _, _, flags, cmd_id, seq, length = FULL_HDR.unpack_from(data, 0)
+        return ("full", flags, cmd_id, seq, length)
+    except (ValueError, struct.error):
+        return None
+
+
+def flags_to_str(flags):
+    names = ["RQST", "PUSH", "ACK", "NACK", "RPLY"]
+    return "|".join(name for bit, name in enumerate(names) if flags & (1 << bit)) or "-"
+
+
+def show(args):
+    frames = read_pcap(args.pcap)
+    start = frames[0]["us"] if frames else 0
+
+    for frame in frames:
+        header = decode_header(frame["data"])
+        if header is None:
+            desc = "truncated header"
+        else:
+            desc = "%-7s %-9s cmd_id=0x%04x seq=%-5u length=%u" % (
+                header[0],
+                flags_to_str(header[1]),
+                header[2],
+                header[3],
+                header[4],
+            )
+        print(
+            "%12.6f %s node=%-5u port=%-5u %4u bytes%s  %s"
+            % (
+                (frame["us"] - start) / 1e6,
+                "RX" if frame["dir"] == DIR_RX else "TX",
+                frame["node"],
+                frame["port"],
+                frame["len"],
+                " (cut)" if len(frame["data"]) < frame["len"] else "",
+                desc,
+            )
+        )
+
+
+def replay(args):
+    frames = [f for f in read_pcap(args.pcap) if f["dir"] == DIR_RX]
+    whole = [f for f in frames if len(f["data"]) == f["len"]]
+    start = whole[0]["us"] if whole else 0
+
+    if len(whole) < len(frames):
+        print(
+            "warning: %d truncated frames skipped, raise CONFIG_CFL_CAPTURE_SNAPLEN"
+            % (len(frames) - len(whole)),
+            file=sys.stderr,
+        )
+
+    with open(args.output, "w") as out:
+        out.write("/* Generated by scripts/cfl_capture.py from %s, do not edit */\n\n" % args.pcap)
+        for index, frame in enumerate(whole):
+            out.write("static const uint8_t replay_frame_%d[] = {" % index)
+            out.write(", ".join("0x%02x" % byte for byte in frame["data"]))
+            out.write("};\n")
+        out.write("\nstatic const bench_replay_frame_t replay_frames[] = {\n")
+        for index, frame in enumerate(whole):
+            offset = 0 if args.speed == 0 else int((frame["us"] - start) / args.speed)
+            out.write(
+                "    {%d, %d, %d, %d, replay_frame_%d},\n"
+                % (offset, frame["node"], frame["port"], frame["len"], index)
+            )
+        if not whole:
+            out.write("    {0, 0, 0, 0, NULL},\n")
+        out.write("};\n\n#define BENCH_REPLAY_FRAMES (%d)\n" % len(whole))
+
+    print("%s: %d frames" % (args.output, len(whole)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    cmd = commands.add_parser("extract", help="console log to pcap")
+    cmd.add_argument("log")
+    cmd.add_argument("-o", "--output", required=True)
+    cmd.set_defaults(func=extract)
+
+    cmd = commands.add_parser("show", help="print a capture")
+    cmd.add_argument("pcap")
+    cmd.set_defaults(func=show)
+
+    cmd = commands.add_parser("replay", help="pcap to benchmark replay input")
+    cmd.add_argument("pcap")
+    cmd.add_argument("--speed", type=float, default=1.0)
+    cmd.add_argument("-o", "--output", required=True)
+    cmd.set_defaults(func=replay)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+"""cfl_codegen.py - Generate CFL payload codecs from a JSON schema
+
+Usage:
+    cfl_codegen.py <schema.json> -o <name_codec.h>
+
+Schema:
+    {
+        "name": "<prefix>",
+        "doc": "<optional file description>",
+        "messages": [
+            {
+                "name": "<message>",
+                "doc": "<optional>",
+                "fields": [{"name": "<field>", "type": "<type>", "doc": "<optional>"}]
+            }
+        ]
+    }
+
+Types are u8, u16, u32, u64, i8, i16, i32, i64 (little-endian on the wire),
+bytes:<N> for a fixed-size byte array and tail for the remaining payload,
+which must be the last field and is decoded without a copy.
+
+For each message the header provides, with <P> = <prefix>_<message>:
+    <P>_t                          Decoded form
+    <P_UPPER>_SIZE                 Wire size without the tail
+    int32_t <P>_encode(uint8_t *dst, size_t size, const <P>_t *in)
+        Writes the payload, typically straight into cfl_message_t::data.
+        Returns its length or -EMSGSIZE when size is too small.
+    int32_t <P>_decode(const uint8_t *src, size_t len, <P>_t *out)
+        Returns 0, or -EINVAL when len does not match the layout.
+
+The build runs this through cfl_generate_codec() in cmake/CflCodegen.cmake.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+INTEGERS = {
+    "u8": ("uint8_t", 1, "u8", None),
+    "u16": ("uint16_t", 2, "u16", None),
+    "u32": ("uint32_t", 4, "u32", None),
+    "u64": ("uint64_t", 8, "u64", None),
+    "i8": ("int8_t", 1, "u8", "uint8_t"),
+    "i16": ("int16_t", 2, "u16", "uint16_t"),
+    "i32": ("int32_t", 4, "u32", "uint32_t"),
+    "i64": ("int64_t", 8, "u64", "uint64_t"),
+}
+
+IDENTIFIER = re.compile(r"^[a-z][a-z0-9_]*$")
+
+
+def fail(msg):
+    sys.exit("cfl_codegen: " + msg)
+
+
+def parse_field(message, field, last):
+    name = field.get("name", "")
+    ftype = field.get("type", "")
+    if not IDENTIFIER.match(name):
+        fail("%s: bad field name '%s'" % (message, name))
+
+    if ftype in INTEGERS:
+        return {"name": name, "kind": "int", "type": ftype, "size": INTEGERS[ftype][1], "doc": field.get("doc")}
+    if ftype.startswith("bytes:"):
+        size = int(ftype.split(":", 1)[1])
+        if size <= 0:
+            fail("%s.%s: bytes size must be positive" % (message, name))
+        return {"name": name, "kind": "bytes", "size": size, "doc": field.get("doc")}
+    if ftype == "tail":
+        if not last:
+            fail("%s.%s: tail must be the last field" % (message, name))
+        return {"name": name, "kind": "tail", "size": 0, "doc": field.get("doc")}
+
+    fail("%s.%s: unknown type '%s'" % (message, name, ftype))
+
+
+def load(path):
+    with open(path) as schema_file:
+        schema = json.load(schema_file)
+
+    prefix = schema.get("name", "")
+    if not IDENTIFIER.match(prefix):
+        fail("bad schema name '%s'" % prefix)
+
+    messages = []
+    for message in schema.get("messages", []):
+        name = message.get("name", "")
+        if not IDENTIFIER.match(name):
+            fail("bad message name '%s'" % name)
+        raw = message.get("fields", [])
+        fields = [parse_field(name, f, i == len(raw) - 1) for i, f in enumerate(raw)]
+        offset = 0
+        for field in fields:
+            field["offset"] = offset
+            offset += field["size"]
+        messages.append({"name": name, "doc": message.get("doc"), "fields": fields, "size": offset})
+
+    return prefix, schema.get("doc"), messages
+
+
+def emit_struct(out, sym, message):
+    if message["doc"]:
+        out.append("/* %s */" % message["doc"])
+    out.append("typedef struct %s_s {" % sym)
+    for field in message["fields"]:
+        comment = " /* %s */" % field["doc"] if field["doc"] else ""
+        if field["kind"] == "int":
+            out.append("    %s %s;%s" % (INTEGERS[field["type"]][0], field["name"], comment))
+        elif field["kind"] == "bytes":
+            out.append("    uint8_t %s[%d];%s" % (field["name"], field["size"], comment))
+        else:
+            out.append("    const uint8_t *%s;%s" % (field["name"], comment))
+            out.append("    uint16_t %s_len;" % field["name"])
+    if not message["fields"]:
+        out.append("    uint8_t unused;")
+    out.append("} %s_t;" % sym)
+    out.append("")
+
+
+def emit_encode(out, sym, upper, message):
+    tail = next((f for f in message["fields"] if f["kind"] == "tail"), None)
+    length = "%s_SIZE" % upper
+    if tail:
+        length = "(%s_SIZE + in->%s_len)" % (upper, tail["name"])
+
+    out.append("static inline int32_t %s_encode(uint8_t *dst, size_t size, const %s_t *in)" % (sym, sym))
+    out.append("{")
+    if not message["fields"]:
+        out.append("    (void)dst;")
+        out.append("    (void)size;")
+        out.append("    (void)in;")
+        out.append("    return 0;")
+        out.append("}")
+        out.append("")
+        return
+    out.append("    if (size < %s)" % length)
+    out.append("    {")
+    out.append("        return -EMSGSIZE;")
+    out.append("    }")
+    out.append("")
+    for field in message["fields"]:
+        dst = "&dst[%d]" % field["offset"]
+        if field["kind"] == "int":
+            _, _, access, cast = INTEGERS[field["type"]]
+            value = "in->%s" % field["name"]
+            if cast:
+                value = "(%s)%s" % (cast, value)
+            out.append("    cfl_codec_put_%s(%s, %s);" % (access, dst, value))
+        elif field["kind"] == "bytes":
+            out.append("    memcpy(%s, in->%s, %d);" % (dst, field["name"], field["size"]))
+        else:
+            out.append("    if (in->%s_len > 0)" % field["name"])
+            out.append("    {")
+            out.append("        memmove(%s, in->%s, in->%s_len);" % (dst, field["name"], field["name"]))
+            out.append("    }")
+    out.append("")
+    out.append("    return (int32_t)%s;" % length)
+    out.append("}")
+    out.append("")
+
+
+def emit_decode(out, sym, upper, message):
+    tail = next((f for f in message["fields"] if f["kind"] == "tail"), None)
+
+    out.append("static inline int32_t %s_decode(const uint8_t *src, size_t len, %s_t *out)" % (sym, sym))
+    out.append("{")
+    if tail:
+        out.append("    if (len < %s_SIZE || len - %s_SIZE > UINT16_MAX)" % (upper, upper))
+    else:
+        out.append("    if (len != %s_SIZE)" % upper)
+    out.append("    {")
+    out.append("        return -EINVAL;")
+    out.append("    }")
+    out.append("")
+    if not message["fields"]:
+        out.append("    (void)src;")
+        out.append("    (void)out;")
+    for field in message["fields"]:
+        src = "&src[%d]" % field["offset"]
+        if field["kind"] == "int":
+            ctype, _, access, cast = INTEGERS[field["type"]]
+            value = "cfl_codec_get_%s(%s)" % (access, src)
+            if cast:
+                value = "(%s)%s" % (ctype, value)
+            out.append("    out->%s = %s;" % (field["name"], value))
+        elif field["kind"] == "bytes":
+            out.append("    memcpy(out->%s, %s, %d);" % (field["name"], src, field["size"]))
+        else:
+            out.append("    out->%s = %s;" % (field["name"], src))
+            out.append("    out->%s_len = (uint16_t)(len - %s_SIZE);" % (field["name"], upper))
+    out.append("")
+    out.append("    return 0;")
+    out.append("}")
+    out.append("")
+
+
+def generate(schema_path, output_path):
+    prefix, doc, messages = load(schema_path)
+    filename = os.path.basename(output_path)
+    guard = "INC_" + re.sub(r"[^A-Za-z0-9]", "_", filename).upper()
+
+    out = []
+    out.append("/* %s - %s */" % (filename, doc or "Generated CFL payload codecs"))
+    out.append("")
+    out.append("/* Generated by scripts/cfl_codegen.py from %s, do not edit */" % os.path.basename(schema_path))
+    out.append("")
+    out.append("#ifndef %s" % guard)
+    out.append("#define %s" % guard)
+    out.append("")
+    out.append("/* Includes */")
+    out.append("")
+    out.append("#include <errno.h>")
+    out.append("#include <stddef.h>")
+    out.append("#include <stdint.h>")
+    out.append("#include <string.h>")
+    out.append("")
+    out.append('#include "cfl/cfl_codec.h"')
+    out.append("")
+    out.append("#ifdef __cplusplus")
+    out.append('extern "C" {')
+    out.append("#endif")
+    out.append("")
+    out.append("/* Definitions */")
+    out.append("")
+    for message in messages:
+        upper = ("%s_%s" % (prefix, message["name"])).upper()
+        out.append("#define %s_SIZE (%dU)" % (upper, message["size"]))
+    out.append("")
+    out.append("/* Types */")
+    out.append("")
+    for message in messages:
+        emit_struct(out, "%s_%s" % (prefix, message["name"]), message)
+    out.append("/* External Declarations */")
+    out.append("")
+    for message in messages:
+        sym = "%s_%s" % (prefix, message["name"])
+        emit_encode(out, sym, sym.upper(), message)
+        emit_decode(out, sym, sym.upper(), message)
+    out.append("#ifdef __cplusplus")
+    out.append("}")
+    out.append("#endif")
+    out.append("")
+    out.append("#endif /* %s */" % guard)
+
+    text = "\n".join(out) + "\n"
+
+    os.makedirs(os.path.dirname(os.path.abspath(output_path)), exist_ok=True)
+    with open(output_path, "w") as header:
+        header.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("schema")
+    parser.add_argument("-o", "--output", required=True)
+    args = parser.parse_args()
+    generate(args.schema, args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,491 @@
+/* cfl_async.c - Stackless transaction engine */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "danp/danp_buffer.h"
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_async.h"
+#include "cfl/cfl_compact.h"
+#include "cfl/cfl_transport.h"
+#include "cfl/cfl_utilities.h"
+#include "cfl_log.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define ASYNC_COUNT   (CONFIG_CFL_ASYNC_MAX)
+#define ASYNC_TICK_MS (CONFIG_CFL_ASYNC_TICK_MS)
+
+#define ASYNC_ID(gen, slot) (((uint32_t)(gen) << 16) | (uint32_t)(slot))
+#define ASYNC_ID_SLOT(id)   ((id) & 0xFFFFU)
+
+BUILD_ASSERT(
+    CONFIG_CFL_ASYNC_PORT != CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT,
+    "CONFIG_CFL_ASYNC_PORT collides with the service port");
+
+/* Types */
+
+/* Everything a transaction needs while it waits, no thread or stack of its own */
+typedef struct async_ctrl_s
+{
+    bool waiting;
+    uint16_t gen;
+    uint16_t dest_id;
+    uint16_t cmd_id;
+    uint16_t seq;
+    uint32_t deadline_ms;
+    cfl_async_cb_t cb;
+    void *user_data;
+} async_ctrl_t;
+
+typedef struct async_context_s
+{
+    bool running;
+    const cfl_transport_ops_t *transport;
+    void *socket;
+    struct k_thread thread;
+    k_tid_t tid;
+} async_context_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static K_THREAD_STACK_DEFINE(async_stack, CONFIG_CFL_ASYNC_STACK_SIZE);
+static async_context_t context;
+static struct k_spinlock lock;
+static async_ctrl_t ctrls[ASYNC_COUNT];
+static cfl_async_stats_t stats;
+
+/* Functions */
+
+/* Claims a waiting control block, so its callback runs exactly once */
+static bool take_locked(async_ctrl_t *ctrl, cfl_async_cb_t *cb, void **user_data)
+{
+    if (!ctrl->waiting)
+    {
+        return false;
+    }
+
+    *cb = ctrl->cb;
+    *user_data = ctrl->user_data;
+    ctrl->waiting = false;
+    ctrl->gen++;
+    stats.active--;
+
+    return true;
+}
+
+/* Milliseconds until the earliest deadline, capped to one engine tick */
+static uint32_t next_wait_ms(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint32_t now = k_uptime_get_32();
+    int32_t wait = ASYNC_TICK_MS;
+
+    for (size_t i = 0; i < ASYNC_COUNT; i++)
+    {
+        if (ctrls[i].waiting)
+        {
+            wait = MIN(wait, (int32_t)(ctrls[i].deadline_ms - now));
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+
+    return (uint32_t)MAX(wait, 0);
+}
+
+static void expire_due(void)
+{
+    cfl_async_cb_t cb = NULL;
+    void *user_data = NULL;
+    k_spinlock_key_t key;
+    uint32_t now = k_uptime_get_32();
+
+    for (size_t i = 0; i < ASYNC_COUNT; i++)
+    {
+        key = k_spin_lock(&lock);
+        if ((int32_t)(ctrls[i].deadline_ms - now) > 0 ||
+            !take_locked(&ctrls[i], &cb, &user_data))
+        {
+            k_spin_unlock(&lock, key);
+            continue;
+        }
+        stats.timed_out++;
+        k_spin_unlock(&lock, key);
+
+        CFL_LOG_RATELIMITED(LOG_ERR, "Async transaction timed out: [cmd_id]=%d", ctrls[i].cmd_id);
+        cb(-ETIMEDOUT, NULL, 0, user_data);
+    }
+}
+
+static void complete_from_packet(uint16_t src_node, danp_packet_t *pkt)
+{
+    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
+    cfl_async_cb_t cb = NULL;
+    void *user_data = NULL;
+    k_spinlock_key_t key;
+    bool found = false;
+    int32_t result = 0;
+
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+    if (cfl_compact_expand(pkt) < 0)
+    {
+        CFL_LOG_RATELIMITED(LOG_ERR, "Malformed compact header in async response");
+        return;
+    }
+#endif
+
+    if (pkt->length < CFL_HEADER_SIZE || msg->sync != CFL_SYNC_WORD)
+    {
+        CFL_LOG_RATELIMITED(LOG_ERR, "Invalid async response from node %d", src_node);
+        return;
+    }
+
+    key = k_spin_lock(&lock);
+    for (size_t i = 0; i < ASYNC_COUNT; i++)
+    {
+        if (ctrls[i].waiting && ctrls[i].dest_id == src_node && ctrls[i].cmd_id == msg->cmd_id &&
+            ctrls[i].seq == msg->seq)
+        {
+            found = take_locked(&ctrls[i], &cb, &user_data);
+            break;
+        }
+    }
+    if (found)
+    {
+        stats.completed++;
+    }
+    else
+    {
+        stats.unmatched++;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (!found)
+    {
+        LOG_DBG("Unmatched async response: [cmd_id]=%d [seq]=%d", msg->cmd_id, msg->seq);
+        return;
+    }
+
+    if (msg->length + CFL_HEADER_SIZE != pkt->length)
+    {
+        result = -EBADMSG;
+    }
+    else if (msg->flags & CFL_F_NACK)
+    {
+        result = -EIO;
+    }
+    else if (msg->flags & CFL_F_ACK)
+    {
+        result = 0;
+    }
+    else if (msg->flags & CFL_F_RPLY)
+    {
+        result = msg->length;
+    }
+    else
+    {
+        result = -EBADMSG;
+    }
+
+    if (result == -EBADMSG)
+    {
+        CFL_LOG_RATELIMITED(LOG_ERR, "Malformed async response: [cmd_id]=%d", msg->cmd_id);
+        cb(result, NULL, 0, user_data);
+        return;
+    }
+
+    cb(result, (msg->length > 0) ? msg->data : NULL, msg->length, user_data);
+}
+
+static void cfl_async_task(void *arg, void *unused1, void *unused2)
+{
+    danp_packet_t *pkt = NULL;
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
+
+    ARG_UNUSED(arg);
+    ARG_UNUSED(unused1);
+    ARG_UNUSED(unused2);
+
+    while (context.running)
+    {
+        /* The receive timeout doubles as the engine timer */
+        pkt = context.transport->recv_from(context.socket, &src_node, &src_port, next_wait_ms());
+        if (pkt != NULL)
+        {
+            complete_from_packet(src_node, pkt);
+            danp_buffer_free(pkt);
+        }
+
+        expire_due();
+    }
+}
+
+static void cancel_all(void)
+{
+    cfl_async_cb_t cb = NULL;
+    void *user_data = NULL;
+    k_spinlock_key_t key;
+    bool taken = false;
+
+    for (size_t i = 0; i < ASYNC_COUNT; i++)
+    {
+        key = k_spin_lock(&lock);
+        taken = take_locked(&ctrls[i], &cb, &user_data);
+        k_spin_unlock(&lock, key);
+
+        if (taken)
+        {
+            cb(-ECANCELED, NULL, 0, user_data);
+        }
+    }
+}
+
+int32_t cfl_async_init(const cfl_thread_attr_t *attr)
+{
+    int32_t ret = 0;
+    int32_t priority = CONFIG_CFL_ASYNC_PRIORITY;
+    uint32_t cpu_mask = 0;
+
+    for (;;)
+    {
+        if (context.running)
+        {
+            ret = -EALREADY;
+            break;
+        }
+
+        if (attr != NULL)
+        {
+            if (attr->stack_size > K_THREAD_STACK_SIZEOF(async_stack))
+            {
+                LOG_ERR("Async engine stack is limited to CONFIG_CFL_ASYNC_STACK_SIZE");
+                ret = -EINVAL;
+                break;
+            }
+            priority = attr->priority;
+            cpu_mask = attr->cpu_mask;
+        }
+
+        context.transport = cfl_transport_get();
+        ret = context.transport->open(&context.socket, CONFIG_CFL_ASYNC_PORT);
+        if (ret < 0)
+        {
+            LOG_ERR("Failed to open async socket: %d", ret);
+            context.socket = NULL;
+            break;
+        }
+
+        context.running = true;
+        context.tid = k_thread_create(
+            &context.thread,
+            async_stack,
+            K_THREAD_STACK_SIZEOF(async_stack),
+            cfl_async_task,
+            NULL,
+            NULL,
+            NULL,
+            priority,
+            0,
+            K_FOREVER);
+        k_thread_name_set(context.tid, "cfl_async");
+
+        ret = cfl_thread_set_cpu_mask(context.tid, cpu_mask);
+        if (ret < 0)
+        {
+            LOG_ERR("Failed to set async engine CPU mask 0x%x: %d", cpu_mask, ret);
+            k_thread_abort(context.tid);
+            context.running = false;
+            break;
+        }
+
+        k_thread_start(context.tid);
+
+        LOG_INF("CFL async engine started on port %d", CONFIG_CFL_ASYNC_PORT);
+        break;
+    }
+
+    if (ret < 0 && ret != -EALREADY && context.socket != NULL)
+    {
+        context.transport->close(context.socket);
+        context.socket = NULL;
+    }
+
+    return ret;
+}
+
+int32_t cfl_async_deinit(void)
+{
+    if (!context.running)
+    {
+        return -EALREADY;
+    }
+
+    context.running = false;
+    if (k_thread_join(&context.thread, K_MSEC(ASYNC_TICK_MS * 2)) != 0)
+    {
+        LOG_WRN("Async engine did not stop, aborting it");
+        k_thread_abort(context.tid);
+    }
+
+    context.transport->close(context.socket);
+    context.socket = NULL;
+
+    cancel_all();
+
+    return 0;
+}
+
+int32_t cfl_async_transaction(
+    uint16_t dest_id,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len,
+    uint32_t timeout_ms,
+    cfl_async_cb_t cb,
+    void *user_data,
+    uint32_t *id)
+{
+    danp_packet_t *pkt = NULL;
+    cfl_message_t *msg = NULL;
+    async_ctrl_t *ctrl = NULL;
+    k_spinlock_key_t key;
+    uint16_t seq = cfl_next_seq();
+    uint16_t gen = 0;
+    uint16_t slot = 0;
+    int32_t ret = 0;
+
+    if (cb == NULL || (request == NULL && request_len > 0))
+    {
+        return -EINVAL;
+    }
+
+    if (request_len > sizeof(pkt->payload) - CFL_HEADER_SIZE)
+    {
+        return -EMSGSIZE;
+    }
+
+    if (!context.running)
+    {
+        return -EAGAIN;
+    }
+
+    pkt = danp_buffer_get();
+    if (pkt == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    msg = (cfl_message_t *)pkt->payload;
+    msg->sync = CFL_SYNC_WORD;
+    msg->version = CFL_VERSION;
+    msg->flags = CFL_F_RQST;
+    msg->cmd_id = cmd_id;
+    msg->seq = seq;
+    msg->length = request_len;
+    if (request_len > 0)
+    {
+        memcpy(msg->data, request, request_len);
+    }
+    pkt->length = CFL_HEADER_SIZE + request_len;
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+    if (cfl_compact_peer_enabled(dest_id))
+    {
+        (void)cfl_compact_pack(pkt);
+    }
+#endif
+
+    key = k_spin_lock(&lock);
+    for (size_t i = 0; i < ASYNC_COUNT; i++)
+    {
+        if (!ctrls[i].waiting)
+        {
+            ctrl = &ctrls[i];
+            slot = (uint16_t)i;
+            break;
+        }
+    }
+    if (ctrl != NULL)
+    {
+        /* Armed before sending, the response may beat the send call back */
+        ctrl->waiting = true;
+        ctrl->dest_id = dest_id;
+        ctrl->cmd_id = cmd_id;
+        ctrl->seq = seq;
+        ctrl->deadline_ms = k_uptime_get_32() + timeout_ms;
+        ctrl->cb = cb;
+        ctrl->user_data = user_data;
+        gen = ctrl->gen;
+        stats.active++;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (ctrl == NULL)
+    {
+        danp_buffer_free(pkt);
+        return -ENOMEM;
+    }
+
+    ret = context.transport->send_to(
+        context.socket, pkt, dest_id, CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT);
+    if (ret < 0)
+    {
+        LOG_ERR("Failed to send async request");
+        (void)cfl_async_cancel(ASYNC_ID(gen, slot));
+        return ret;
+    }
+
+    if (id != NULL)
+    {
+        *id = ASYNC_ID(gen, slot);
+    }
+
+    return 0;
+}
+
+int32_t cfl_async_cancel(uint32_t id)
+{
+    cfl_async_cb_t cb = NULL;
+    void *user_data = NULL;
+    k_spinlock_key_t key;
+    size_t slot = ASYNC_ID_SLOT(id);
+    int32_t ret = -ENOENT;
+
+    if (slot >= ASYNC_COUNT)
+    {
+        return -ENOENT;
+    }
+
+    key = k_spin_lock(&lock);
+    if (ASYNC_ID(ctrls[slot].gen, slot) == id && take_locked(&ctrls[slot], &cb, &user_data))
+    {
+        ret = 0;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+void cfl_async_get_stats(cfl_async_stats_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = stats;
+    k_spin_unlock(&lock, key);
+}
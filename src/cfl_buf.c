@@ -0,0 +1,171 @@
+/* cfl_buf.c - Size-classed packet buffers */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl_buf.h"
+#include "cfl_log.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+/* Packet metadata in front of the payload is kept, whatever DANP stores there */
+#define BUF_META_SIZE  (offsetof(danp_packet_t, payload))
+#define BUF_SMALL_SIZE (CONFIG_CFL_BUF_SMALL_SIZE)
+#define BUF_BLOCK_SIZE (ROUND_UP(BUF_META_SIZE + BUF_SMALL_SIZE, sizeof(void *)))
+#define BUF_COUNT      (CONFIG_CFL_BUF_SMALL_COUNT)
+
+BUILD_ASSERT(BUF_SMALL_SIZE < DANP_MAX_PACKET_SIZE, "Small buffers must be smaller than DANP ones");
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static struct k_mem_slab small_slab;
+static uint8_t small_blocks[BUF_COUNT * BUF_BLOCK_SIZE] __aligned(sizeof(void *));
+static cfl_buf_stats_t stats;
+
+/* Functions */
+
+bool cfl_buf_is_small(const danp_packet_t *pkt)
+{
+    const uint8_t *addr = (const uint8_t *)pkt;
+
+    return addr >= small_blocks && addr < &small_blocks[sizeof(small_blocks)];
+}
+
+danp_packet_t *cfl_buf_shrink(danp_packet_t *pkt, uint16_t capacity)
+{
+    danp_packet_t *small = NULL;
+    k_spinlock_key_t key;
+
+    if (pkt == NULL || cfl_buf_is_small(pkt))
+    {
+        return pkt;
+    }
+
+    if (capacity > BUF_SMALL_SIZE || pkt->length > BUF_SMALL_SIZE)
+    {
+        key = k_spin_lock(&lock);
+        stats.too_large++;
+        k_spin_unlock(&lock, key);
+        return pkt;
+    }
+
+    if (k_mem_slab_alloc(&small_slab, (void **)&small, K_NO_WAIT) != 0)
+    {
+        key = k_spin_lock(&lock);
+        stats.exhausted++;
+        k_spin_unlock(&lock, key);
+        return pkt;
+    }
+
+    memcpy(small, pkt, BUF_META_SIZE + pkt->length);
+    danp_buffer_free(pkt);
+
+    key = k_spin_lock(&lock);
+    stats.shrunk++;
+    stats.small_used++;
+    if (stats.small_used > stats.small_peak)
+    {
+        stats.small_peak = stats.small_used;
+    }
+    k_spin_unlock(&lock, key);
+
+    return small;
+}
+
+danp_packet_t *cfl_buf_to_danp(danp_packet_t *pkt)
+{
+    danp_packet_t *full = NULL;
+    k_spinlock_key_t key;
+
+    if (pkt == NULL || !cfl_buf_is_small(pkt))
+    {
+        return pkt;
+    }
+
+    full = danp_buffer_get();
+    if (full == NULL)
+    {
+        CFL_LOG_RATELIMITED(LOG_ERR, "No DANP buffer to send a small packet");
+    }
+    else
+    {
+        memcpy(full, pkt, BUF_META_SIZE + pkt->length);
+    }
+
+    k_mem_slab_free(&small_slab, pkt);
+
+    key = k_spin_lock(&lock);
+    stats.small_used--;
+    if (full != NULL)
+    {
+        stats.restored++;
+    }
+    k_spin_unlock(&lock, key);
+
+    return full;
+}
+
+void cfl_buf_free(danp_packet_t *pkt)
+{
+    k_spinlock_key_t key;
+
+    if (pkt == NULL)
+    {
+        return;
+    }
+
+    if (!cfl_buf_is_small(pkt))
+    {
+        danp_buffer_free(pkt);
+        return;
+    }
+
+    k_mem_slab_free(&small_slab, pkt);
+
+    key = k_spin_lock(&lock);
+    stats.small_used--;
+    k_spin_unlock(&lock, key);
+}
+
+int32_t cfl_buf_get_stats(cfl_buf_stats_t *out)
+{
+    k_spinlock_key_t key;
+
+    if (out == NULL)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    *out = stats;
+    k_spin_unlock(&lock, key);
+
+    return 0;
+}
+
+static int cfl_buf_init(void)
+{
+    return k_mem_slab_init(&small_slab, small_blocks, BUF_BLOCK_SIZE, BUF_COUNT);
+}
+
+SYS_INIT(cfl_buf_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,358 @@
+/* cfl_cache.c - Client-side single-flight and read-through cache */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl_cache.h"
+#include "cfl/cfl_utilities.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define CACHE_ENTRY_COUNT (CONFIG_CFL_CACHE_ENTRIES)
+#define CACHE_CMD_COUNT   (CONFIG_CFL_CACHE_CMDS)
+#define CACHE_MAX_REQUEST (CONFIG_CFL_CACHE_MAX_REQUEST)
+#define CACHE_MAX_REPLY   (CONFIG_CFL_CACHE_MAX_REPLY)
+
+#define CACHE_STATE_FREE     (0U)
+#define CACHE_STATE_INFLIGHT (1U) /* A leader is on the wire for this key */
+#define CACHE_STATE_DONE     (2U) /* Result of the last flight is stored */
+
+/* Types */
+
+typedef struct cache_cmd_s
+{
+    bool used;
+    uint16_t cmd_id;
+    uint32_t ttl_ms;
+} cache_cmd_t;
+
+typedef struct cache_entry_s
+{
+    uint8_t state;
+    uint16_t dest_id;
+    uint16_t cmd_id;
+    uint16_t request_len;
+    uint8_t request[CACHE_MAX_REQUEST];
+    /* Bumped when a flight ends so waiters can tell their result is ready */
+    uint32_t flight;
+    uint32_t waiters;
+    int32_t result;
+    uint32_t expires_ms;
+    uint32_t last_used_ms;
+    uint8_t reply[CACHE_MAX_REPLY];
+} cache_entry_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static K_MUTEX_DEFINE(cache_lock);
+static K_CONDVAR_DEFINE(cache_done);
+static cache_cmd_t cmds[CACHE_CMD_COUNT];
+static cache_entry_t entries[CACHE_ENTRY_COUNT];
+static cfl_cache_stats_t stats;
+
+/* Functions */
+
+static cache_cmd_t *find_cmd(uint16_t cmd_id)
+{
+    for (size_t i = 0; i < CACHE_CMD_COUNT; i++)
+    {
+        if (cmds[i].used && cmds[i].cmd_id == cmd_id)
+        {
+            return &cmds[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool entry_matches(
+    const cache_entry_t *entry,
+    uint16_t dest_id,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len)
+{
+    return entry->state != CACHE_STATE_FREE && entry->dest_id == dest_id &&
+           entry->cmd_id == cmd_id && entry->request_len == request_len &&
+           memcmp(entry->request, request, request_len) == 0;
+}
+
+static cache_entry_t *find_entry(
+    uint16_t dest_id,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len)
+{
+    for (size_t i = 0; i < CACHE_ENTRY_COUNT; i++)
+    {
+        if (entry_matches(&entries[i], dest_id, cmd_id, request, request_len))
+        {
+            return &entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Free slot first, then the least recently used entry. Entries with waiters
+ * are never taken, even freed ones: a waiter not yet back from its wakeup
+ * would read the result of another request.
+ */
+static cache_entry_t *alloc_entry(void)
+{
+    cache_entry_t *victim = NULL;
+
+    for (size_t i = 0; i < CACHE_ENTRY_COUNT; i++)
+    {
+        cache_entry_t *entry = &entries[i];
+
+        if (entry->waiters != 0)
+        {
+            continue;
+        }
+
+        if (entry->state == CACHE_STATE_FREE)
+        {
+            return entry;
+        }
+
+        if (entry->state == CACHE_STATE_DONE &&
+            (victim == NULL || (int32_t)(entry->last_used_ms - victim->last_used_ms) < 0))
+        {
+            victim = entry;
+        }
+    }
+
+    return victim;
+}
+
+/* Same return convention as cfl_transaction() */
+static int32_t copy_result(const cache_entry_t *entry, uint8_t *reply, uint16_t reply_size)
+{
+    if (entry->result < 0 || reply == NULL || reply_size == 0)
+    {
+        return entry->result;
+    }
+
+    if (entry->result > reply_size)
+    {
+        return -6;
+    }
+
+    memcpy(reply, entry->reply, entry->result);
+    return entry->result;
+}
+
+int32_t cfl_cache_enable(uint16_t cmd_id, uint32_t ttl_ms)
+{
+    int32_t ret = 0;
+    cache_cmd_t *cmd = NULL;
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    cmd = find_cmd(cmd_id);
+    for (size_t i = 0; cmd == NULL && i < CACHE_CMD_COUNT; i++)
+    {
+        if (!cmds[i].used)
+        {
+            cmd = &cmds[i];
+            cmd->used = true;
+            cmd->cmd_id = cmd_id;
+        }
+    }
+
+    if (cmd == NULL)
+    {
+        ret = -ENOMEM;
+    }
+    else
+    {
+        cmd->ttl_ms = ttl_ms;
+    }
+
+    k_mutex_unlock(&cache_lock);
+
+    return ret;
+}
+
+void cfl_cache_disable(uint16_t cmd_id)
+{
+    cache_cmd_t *cmd = NULL;
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    cmd = find_cmd(cmd_id);
+    if (cmd != NULL)
+    {
+        cmd->used = false;
+    }
+
+    for (size_t i = 0; i < CACHE_ENTRY_COUNT; i++)
+    {
+        if (entries[i].state == CACHE_STATE_DONE && entries[i].cmd_id == cmd_id &&
+            entries[i].waiters == 0)
+        {
+            entries[i].state = CACHE_STATE_FREE;
+        }
+    }
+
+    k_mutex_unlock(&cache_lock);
+}
+
+int32_t cfl_transaction_cached(
+    uint16_t dest_id,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len,
+    uint8_t *reply,
+    uint16_t reply_size,
+    uint32_t timeout)
+{
+    int32_t ret = 0;
+    uint32_t ttl_ms = 0;
+    uint32_t flight = 0;
+    uint32_t now = 0;
+    cache_cmd_t *cmd = NULL;
+    cache_entry_t *entry = NULL;
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    cmd = find_cmd(cmd_id);
+    if (cmd == NULL || request_len > CACHE_MAX_REQUEST)
+    {
+        stats.bypassed++;
+        k_mutex_unlock(&cache_lock);
+        return cfl_transaction(
+            dest_id, cmd_id, request, request_len, reply, reply_size, timeout);
+    }
+    ttl_ms = cmd->ttl_ms;
+
+    for (;;)
+    {
+        now = k_uptime_get_32();
+        entry = find_entry(dest_id, cmd_id, request, request_len);
+
+        if (entry != NULL && entry->state == CACHE_STATE_INFLIGHT)
+        {
+            /* Single-flight: wait for the leader and share its result */
+            stats.coalesced++;
+            flight = entry->flight;
+            entry->waiters++;
+            while (entry->flight == flight)
+            {
+                k_condvar_wait(&cache_done, &cache_lock, K_FOREVER);
+            }
+            entry->waiters--;
+
+            /* Freed when the reply was too large to share, issue our own */
+            if (!entry_matches(entry, dest_id, cmd_id, request, request_len))
+            {
+                continue;
+            }
+
+            ret = copy_result(entry, reply, reply_size);
+            k_mutex_unlock(&cache_lock);
+            return ret;
+        }
+
+        if (entry != NULL && entry->result >= 0 && (int32_t)(entry->expires_ms - now) > 0)
+        {
+            stats.hits++;
+            entry->last_used_ms = now;
+            ret = copy_result(entry, reply, reply_size);
+            k_mutex_unlock(&cache_lock);
+            return ret;
+        }
+
+        break;
+    }
+
+    stats.misses++;
+    if (entry == NULL)
+    {
+        entry = alloc_entry();
+    }
+
+    if (entry == NULL)
+    {
+        /* Every slot has waiters, nothing to coalesce into */
+        k_mutex_unlock(&cache_lock);
+        return cfl_transaction(
+            dest_id, cmd_id, request, request_len, reply, reply_size, timeout);
+    }
+
+    entry->state = CACHE_STATE_INFLIGHT;
+    entry->dest_id = dest_id;
+    entry->cmd_id = cmd_id;
+    entry->request_len = request_len;
+    memcpy(entry->request, request, request_len);
+
+    k_mutex_unlock(&cache_lock);
+
+    /* The full reply always lands in the caller's buffer, the cache keeps a copy if it fits */
+    ret = cfl_transaction(dest_id, cmd_id, request, request_len, reply, reply_size, timeout);
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    now = k_uptime_get_32();
+    if (ret > CACHE_MAX_REPLY || (ret > 0 && (reply == NULL || reply_size == 0)))
+    {
+        entry->state = CACHE_STATE_FREE;
+    }
+    else
+    {
+        entry->state = CACHE_STATE_DONE;
+        entry->result = ret;
+        if (ret > 0)
+        {
+            memcpy(entry->reply, reply, ret);
+        }
+        /* Errors are shared with current waiters only */
+        entry->expires_ms = now + ((ret >= 0) ? ttl_ms : 0);
+        entry->last_used_ms = now;
+    }
+    entry->flight++;
+    k_condvar_broadcast(&cache_done);
+
+    k_mutex_unlock(&cache_lock);
+
+    return ret;
+}
+
+void cfl_cache_flush(void)
+{
+    k_mutex_lock(&cache_lock, K_FOREVER);
+
+    for (size_t i = 0; i < CACHE_ENTRY_COUNT; i++)
+    {
+        if (entries[i].state == CACHE_STATE_DONE && entries[i].waiters == 0)
+        {
+            entries[i].state = CACHE_STATE_FREE;
+        }
+    }
+
+    k_mutex_unlock(&cache_lock);
+}
+
+void cfl_cache_get_stats(cfl_cache_stats_t *out)
+{
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    *out = stats;
+    k_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,173 @@
+/* cfl_capture.c - Packet capture ring */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "cfl/cfl_capture.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+#define CAPTURE_COUNT   (CONFIG_CFL_CAPTURE_RECORDS)
+#define CAPTURE_SNAPLEN (CONFIG_CFL_CAPTURE_SNAPLEN)
+
+#define PCAP_MAGIC         (0xA1B2C3D4U)
+#define PCAP_VERSION_MAJOR (2U)
+#define PCAP_VERSION_MINOR (4U)
+#define PCAP_FILE_HDR_SIZE (24U)
+#define PCAP_REC_HDR_SIZE  (16U)
+
+/* Types */
+
+typedef struct capture_record_s
+{
+    int64_t ticks;
+    uint16_t node;
+    uint16_t port;
+    uint16_t orig_len;
+    uint8_t dir;
+    uint8_t cap_len;
+    uint8_t data[CAPTURE_SNAPLEN];
+} capture_record_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+BUILD_ASSERT(CAPTURE_SNAPLEN <= UINT8_MAX, "CFL_CAPTURE_SNAPLEN must fit the record length");
+
+static struct k_spinlock lock;
+static bool enabled = true;
+static capture_record_t records[CAPTURE_COUNT];
+static size_t head;  /* Next record to write */
+static size_t count; /* Valid records, at most CAPTURE_COUNT */
+static uint32_t overwritten;
+
+/* Functions */
+
+void cfl_capture_packet(
+    uint8_t dir,
+    uint16_t node,
+    uint16_t port,
+    const uint8_t *data,
+    uint16_t len)
+{
+    capture_record_t *rec = NULL;
+    k_spinlock_key_t key;
+
+    if (!enabled)
+    {
+        return;
+    }
+
+    key = k_spin_lock(&lock);
+
+    rec = &records[head];
+    rec->ticks = k_uptime_ticks();
+    rec->node = node;
+    rec->port = port;
+    rec->orig_len = len;
+    rec->dir = dir;
+    rec->cap_len = (uint8_t)MIN(len, CAPTURE_SNAPLEN);
+    memcpy(rec->data, data, rec->cap_len);
+
+    head = (head + 1) % CAPTURE_COUNT;
+    if (count < CAPTURE_COUNT)
+    {
+        count++;
+    }
+    else
+    {
+        overwritten++;
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+void cfl_capture_set_enabled(bool enable)
+{
+    enabled = enable;
+}
+
+void cfl_capture_clear(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    head = 0;
+    count = 0;
+    overwritten = 0;
+
+    k_spin_unlock(&lock, key);
+}
+
+size_t cfl_capture_dump(cfl_capture_write_t write, void *ctx)
+{
+    uint8_t hdr[PCAP_FILE_HDR_SIZE] = {0};
+    capture_record_t rec;
+    k_spinlock_key_t key;
+    uint64_t us = 0;
+    size_t written = 0;
+    size_t total = 0;
+    size_t index = 0;
+
+    sys_put_le32(PCAP_MAGIC, &hdr[0]);
+    sys_put_le16(PCAP_VERSION_MAJOR, &hdr[4]);
+    sys_put_le16(PCAP_VERSION_MINOR, &hdr[6]);
+    /* Bytes 8..15 are the zero time zone offset and accuracy */
+    sys_put_le32(CFL_CAPTURE_PSEUDO_SIZE + CAPTURE_SNAPLEN, &hdr[16]);
+    sys_put_le32(CFL_CAPTURE_LINKTYPE, &hdr[20]);
+    write(ctx, hdr, sizeof(hdr));
+
+    key = k_spin_lock(&lock);
+    total = count;
+    k_spin_unlock(&lock, key);
+
+    for (size_t i = 0; i < total; i++)
+    {
+        /* Copy one record at a time, the lock is never held across the sink */
+        key = k_spin_lock(&lock);
+        if (i >= count)
+        {
+            k_spin_unlock(&lock, key);
+            break;
+        }
+        index = (head + CAPTURE_COUNT - count + i) % CAPTURE_COUNT;
+        rec = records[index];
+        k_spin_unlock(&lock, key);
+
+        us = k_ticks_to_us_floor64(rec.ticks);
+        sys_put_le32((uint32_t)(us / USEC_PER_SEC), &hdr[0]);
+        sys_put_le32((uint32_t)(us % USEC_PER_SEC), &hdr[4]);
+        sys_put_le32(CFL_CAPTURE_PSEUDO_SIZE + rec.cap_len, &hdr[8]);
+        sys_put_le32(CFL_CAPTURE_PSEUDO_SIZE + rec.orig_len, &hdr[12]);
+        hdr[16] = rec.dir;
+        hdr[17] = 0;
+        sys_put_le16(rec.node, &hdr[18]);
+        sys_put_le16(rec.port, &hdr[20]);
+        write(ctx, hdr, PCAP_REC_HDR_SIZE + CFL_CAPTURE_PSEUDO_SIZE);
+        write(ctx, rec.data, rec.cap_len);
+        written++;
+    }
+
+    return written;
+}
+
+void cfl_capture_get_stats(cfl_capture_stats_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    out->enabled = enabled;
+    out->records = (uint32_t)count;
+    out->overwritten = overwritten;
+
+    k_spin_unlock(&lock, key);
+}
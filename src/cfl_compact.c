@@ -0,0 +1,261 @@
+/* cfl_compact.c - Compact message header encoding */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_compact.h"
+#include "cfl/cfl_varint.h"
+#include "danp/danp_defs.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define COMPACT_PEER_COUNT (CONFIG_CFL_COMPACT_PEERS)
+
+/* Either byte of the full sync word may come first depending on endianness */
+BUILD_ASSERT(CFL_COMPACT_SYNC != (CFL_SYNC_WORD & 0xFFU), "Compact sync collides with CFL sync");
+BUILD_ASSERT(CFL_COMPACT_SYNC != (CFL_SYNC_WORD >> 8), "Compact sync collides with CFL sync");
+
+/* Types */
+
+typedef struct compact_peer_entry_s
+{
+    bool used;
+    bool learned;
+    uint16_t node;
+} compact_peer_entry_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static compact_peer_entry_t peers[COMPACT_PEER_COUNT];
+
+/* Functions */
+
+static compact_peer_entry_t *find_peer(uint16_t node)
+{
+    for (size_t i = 0; i < COMPACT_PEER_COUNT; i++)
+    {
+        if (peers[i].used && peers[i].node == node)
+        {
+            return &peers[i];
+        }
+    }
+
+    return NULL;
+}
+
+static compact_peer_entry_t *add_peer(uint16_t node)
+{
+    for (size_t i = 0; i < COMPACT_PEER_COUNT; i++)
+    {
+        if (!peers[i].used)
+        {
+            peers[i].used = true;
+            peers[i].node = node;
+            return &peers[i];
+        }
+    }
+
+    return NULL;
+}
+
+bool cfl_compact_is_compact(const danp_packet_t *pkt)
+{
+    return pkt != NULL && pkt->length >= CFL_COMPACT_HEADER_MIN &&
+           pkt->payload[0] == CFL_COMPACT_SYNC;
+}
+
+int32_t cfl_compact_expand(danp_packet_t *pkt)
+{
+    uint16_t fields[3] = {0}; /* cmd_id, seq, length */
+    size_t offset = 2;
+    size_t data_len = 0;
+    uint8_t version = 0;
+    uint8_t flags = 0;
+    int32_t ret = 0;
+    cfl_message_t *msg = NULL;
+
+    if (!cfl_compact_is_compact(pkt))
+    {
+        return 0;
+    }
+
+    version = pkt->payload[1] >> 5;
+    flags = pkt->payload[1] & CFL_COMPACT_FLAGS_MASK;
+
+    for (size_t i = 0; i < ARRAY_SIZE(fields); i++)
+    {
+        ret = cfl_varint_get(&pkt->payload[offset], pkt->length - offset, &fields[i]);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        offset += (size_t)ret;
+    }
+
+    data_len = pkt->length - offset;
+    if (CFL_HEADER_SIZE + data_len > DANP_MAX_PACKET_SIZE)
+    {
+        return -EMSGSIZE;
+    }
+
+    /* Source and destination overlap, the payload is shifted behind the full header */
+    memmove(&pkt->payload[CFL_HEADER_SIZE], &pkt->payload[offset], data_len);
+
+    msg = (cfl_message_t *)pkt->payload;
+    msg->sync = CFL_SYNC_WORD;
+    msg->version = version;
+    msg->flags = flags;
+    msg->cmd_id = fields[0];
+    msg->seq = fields[1];
+    msg->length = fields[2];
+    pkt->length = (uint16_t)(CFL_HEADER_SIZE + data_len);
+
+    return 1;
+}
+
+int32_t cfl_compact_pack(danp_packet_t *pkt)
+{
+    uint8_t hdr[CFL_COMPACT_HEADER_MAX];
+    size_t hdr_len = 0;
+    const cfl_message_t *msg = NULL;
+
+    if (pkt == NULL || pkt->length < CFL_HEADER_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    msg = (const cfl_message_t *)pkt->payload;
+    if (msg->version > CFL_COMPACT_VERSION_MAX || (msg->flags & ~CFL_COMPACT_FLAGS_MASK) != 0)
+    {
+        return -ENOTSUP;
+    }
+
+    hdr[hdr_len++] = CFL_COMPACT_SYNC;
+    hdr[hdr_len++] = (uint8_t)((msg->version << 5) | msg->flags);
+    hdr_len += cfl_varint_put(&hdr[hdr_len], msg->cmd_id);
+    hdr_len += cfl_varint_put(&hdr[hdr_len], msg->seq);
+    hdr_len += cfl_varint_put(&hdr[hdr_len], msg->length);
+
+    if (hdr_len >= CFL_HEADER_SIZE)
+    {
+        return -EMSGSIZE;
+    }
+
+    memmove(&pkt->payload[hdr_len], &pkt->payload[CFL_HEADER_SIZE], pkt->length - CFL_HEADER_SIZE);
+    memcpy(pkt->payload, hdr, hdr_len);
+    pkt->length = (uint16_t)(pkt->length - CFL_HEADER_SIZE + hdr_len);
+
+    return 0;
+}
+
+int32_t cfl_compact_set_peer(uint16_t node, bool enabled)
+{
+    int32_t ret = 0;
+    compact_peer_entry_t *peer = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    peer = find_peer(node);
+    if (!enabled)
+    {
+        if (peer != NULL)
+        {
+            peer->used = false;
+        }
+    }
+    else
+    {
+        if (peer == NULL)
+        {
+            peer = add_peer(node);
+        }
+
+        if (peer == NULL)
+        {
+            ret = -ENOMEM;
+        }
+        else
+        {
+            peer->learned = false;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (ret < 0)
+    {
+        LOG_ERR("No free compact peer slot for node %d", node);
+    }
+
+    return ret;
+}
+
+void cfl_compact_learn_peer(uint16_t node)
+{
+    compact_peer_entry_t *peer = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (find_peer(node) == NULL)
+    {
+        peer = add_peer(node);
+        if (peer != NULL)
+        {
+            peer->learned = true;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+bool cfl_compact_peer_enabled(uint16_t node)
+{
+    bool enabled = false;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    enabled = (find_peer(node) != NULL);
+
+    k_spin_unlock(&lock, key);
+
+    return enabled;
+}
+
+int32_t cfl_compact_get_peer(size_t index, cfl_compact_peer_t *peer)
+{
+    int32_t ret = 0;
+    k_spinlock_key_t key;
+
+    if (peer == NULL || index >= COMPACT_PEER_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    if (!peers[index].used)
+    {
+        ret = -ENOENT;
+    }
+    else
+    {
+        peer->node = peers[index].node;
+        peer->learned = peers[index].learned;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
@@ -0,0 +1,238 @@
+/* cfl_latency.c - One-way latency from timestamped transactions */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_ext.h"
+#include "cfl/cfl_ext_codec.h"
+#include "cfl/cfl_latency.h"
+#include "danp/danp_defs.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define LATENCY_PEERS  (CONFIG_CFL_LATENCY_PEERS)
+#define LATENCY_FILTER (CONFIG_CFL_LATENCY_FILTER)
+
+/* Weight of a new sample in the smoothed legs, 1/8 as for TCP round trip times */
+#define LATENCY_EWMA_SHIFT (3)
+
+/* Types */
+
+typedef struct latency_sample_s
+{
+    int64_t offset_us;
+    uint32_t delay_us;
+} latency_sample_t;
+
+typedef struct latency_peer_s
+{
+    bool used;
+    uint16_t node;
+    uint32_t samples;
+    uint32_t last_ms;
+    /* Last samples, the offset is taken from the one with the shortest delay */
+    latency_sample_t filter[LATENCY_FILTER];
+    size_t next;
+    latency_sample_t best;
+    int32_t uplink_us;
+    int32_t remote_us;
+    int32_t downlink_us;
+} latency_peer_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static latency_peer_t peers[LATENCY_PEERS];
+
+/* Functions */
+
+static int32_t clamp_us(int64_t value)
+{
+    return (int32_t)CLAMP(value, INT32_MIN, INT32_MAX);
+}
+
+static void smooth(int32_t *avg, int32_t value, bool first)
+{
+    if (first)
+    {
+        *avg = value;
+    }
+    else
+    {
+        *avg += (int32_t)(((int64_t)value - *avg) / (1 << LATENCY_EWMA_SHIFT));
+    }
+}
+
+/* Entry of node, or the unused or least recently updated one started for it */
+static latency_peer_t *find_peer_locked(uint16_t node, uint32_t now)
+{
+    latency_peer_t *oldest = NULL;
+
+    for (size_t i = 0; i < LATENCY_PEERS; i++)
+    {
+        if (peers[i].used && peers[i].node == node)
+        {
+            return &peers[i];
+        }
+
+        if (oldest == NULL || !peers[i].used ||
+            (oldest->used && (now - peers[i].last_ms) > (now - oldest->last_ms)))
+        {
+            oldest = &peers[i];
+        }
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->used = true;
+    oldest->node = node;
+
+    return oldest;
+}
+
+uint64_t cfl_latency_now_us(void)
+{
+    return k_ticks_to_us_floor64((uint64_t)k_uptime_ticks());
+}
+
+int32_t cfl_latency_stamp(danp_packet_t *pkt, uint64_t rx_us)
+{
+    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
+    cfl_ext_timestamp_t times = {.rx_us = rx_us};
+
+    if ((size_t)pkt->length + CFL_EXT_TIMESTAMP_SIZE > DANP_MAX_PACKET_SIZE)
+    {
+        return -EMSGSIZE;
+    }
+
+    times.tx_us = cfl_latency_now_us();
+    (void)cfl_ext_timestamp_encode(&msg->data[msg->length], CFL_EXT_TIMESTAMP_SIZE, &times);
+    msg->length += CFL_EXT_TIMESTAMP_SIZE;
+    msg->flags |= CFL_EXT_F_TIMESTAMP;
+    pkt->length += CFL_EXT_TIMESTAMP_SIZE;
+
+    return 0;
+}
+
+int32_t cfl_latency_strip(danp_packet_t *pkt, uint64_t *rx_us, uint64_t *tx_us)
+{
+    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
+    cfl_ext_timestamp_t times = {0};
+
+    if (!(msg->flags & CFL_EXT_F_TIMESTAMP))
+    {
+        return 0;
+    }
+
+    if (msg->length < CFL_EXT_TIMESTAMP_SIZE)
+    {
+        return -EBADMSG;
+    }
+
+    msg->length -= CFL_EXT_TIMESTAMP_SIZE;
+    msg->flags &= (uint8_t)~CFL_EXT_F_TIMESTAMP;
+    pkt->length -= CFL_EXT_TIMESTAMP_SIZE;
+    (void)cfl_ext_timestamp_decode(&msg->data[msg->length], CFL_EXT_TIMESTAMP_SIZE, &times);
+    *rx_us = times.rx_us;
+    *tx_us = times.tx_us;
+
+    return 1;
+}
+
+void cfl_latency_record(
+    uint16_t node,
+    uint64_t t1_us,
+    uint64_t t2_us,
+    uint64_t t3_us,
+    uint64_t t4_us)
+{
+    uint32_t now = k_uptime_get_32();
+    int64_t remote = (int64_t)(t3_us - t2_us);
+    int64_t delay = (int64_t)(t4_us - t1_us) - remote;
+    latency_sample_t sample = {0};
+    latency_peer_t *peer = NULL;
+    bool first = false;
+    k_spinlock_key_t key;
+
+    /* Same clock at both ends of each difference, so the offset cancels out */
+    sample.offset_us = ((int64_t)(t2_us - t1_us) + (int64_t)(t3_us - t4_us)) / 2;
+    sample.delay_us = (uint32_t)CLAMP(delay, 0, INT32_MAX);
+
+    key = k_spin_lock(&lock);
+    peer = find_peer_locked(node, now);
+    first = peer->samples == 0;
+
+    peer->filter[peer->next] = sample;
+    peer->next = (peer->next + 1) % LATENCY_FILTER;
+    peer->best = sample;
+    for (size_t i = 0; i < MIN(peer->samples + 1, (uint32_t)LATENCY_FILTER); i++)
+    {
+        if (peer->filter[i].delay_us < peer->best.delay_us)
+        {
+            peer->best = peer->filter[i];
+        }
+    }
+
+    /* Legs of this transaction, split with the best offset rather than its own */
+    smooth(&peer->uplink_us, clamp_us((int64_t)(t2_us - t1_us) - peer->best.offset_us), first);
+    smooth(&peer->remote_us, clamp_us(remote), first);
+    smooth(&peer->downlink_us, clamp_us((int64_t)(t4_us - t3_us) + peer->best.offset_us), first);
+
+    peer->samples++;
+    peer->last_ms = now;
+    k_spin_unlock(&lock, key);
+}
+
+int32_t cfl_latency_get(size_t index, cfl_latency_peer_t *info)
+{
+    const latency_peer_t *peer = NULL;
+    k_spinlock_key_t key;
+
+    if (index >= LATENCY_PEERS)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    peer = &peers[index];
+    if (!peer->used)
+    {
+        k_spin_unlock(&lock, key);
+        return -ENOENT;
+    }
+
+    info->node = peer->node;
+    info->samples = peer->samples;
+    info->idle_ms = k_uptime_get_32() - peer->last_ms;
+    info->offset_us = peer->best.offset_us;
+    info->delay_us = peer->best.delay_us;
+    info->uplink_us = peer->uplink_us;
+    info->remote_us = peer->remote_us;
+    info->downlink_us = peer->downlink_us;
+    k_spin_unlock(&lock, key);
+
+    return 0;
+}
+
+void cfl_latency_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    memset(peers, 0, sizeof(peers));
+    k_spin_unlock(&lock, key);
+}
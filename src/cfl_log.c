@@ -8,6 +8,8 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/printk.h>
 
+#include "cfl_log.h"
+
 /* Imports */
 
 
@@ -26,3 +28,21 @@ LOG_MODULE_REGISTER(cfl, CONFIG_CFL_LOG_LEVEL);
 
 /* Functions */
 
+bool cfl_log_ratelimit(cfl_log_ratelimit_t *rl, uint32_t *suppressed)
+{
+    uint32_t now = k_uptime_get_32();
+
+    if (rl->started && (now - rl->window_start_ms) < CFL_LOG_RATELIMIT_MS)
+    {
+        rl->suppressed++;
+        return false;
+    }
+
+    *suppressed = rl->suppressed;
+    rl->started = true;
+    rl->window_start_ms = now;
+    rl->suppressed = 0;
+
+    return true;
+}
+
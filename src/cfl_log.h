@@ -0,0 +1,72 @@
+/* cfl_log.h - Internal logging helpers */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_LOG_H
+#define INC_CFL_LOG_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+#ifndef CFL_LOG_RATELIMIT_MS
+#if defined(CONFIG_CFL_LOG_RATELIMIT_MS)
+#define CFL_LOG_RATELIMIT_MS (CONFIG_CFL_LOG_RATELIMIT_MS)
+#else
+#define CFL_LOG_RATELIMIT_MS (1000)
+#endif
+#endif
+
+/* Definitions */
+
+/**
+ * @brief Emit a log statement at most once per CFL_LOG_RATELIMIT_MS
+ *
+ * Each call site keeps its own window. When messages were dropped, the next
+ * emitted one is preceded by a count of the suppressed messages.
+ */
+#define CFL_LOG_RATELIMITED(_log, ...)                                                             \
+    do                                                                                             \
+    {                                                                                              \
+        static cfl_log_ratelimit_t _cfl_log_rl;                                                    \
+        uint32_t _cfl_log_suppressed = 0;                                                          \
+        if (cfl_log_ratelimit(&_cfl_log_rl, &_cfl_log_suppressed))                                 \
+        {                                                                                          \
+            if (_cfl_log_suppressed > 0)                                                           \
+            {                                                                                      \
+                _log("%u similar messages suppressed", _cfl_log_suppressed);                      \
+            }                                                                                      \
+            _log(__VA_ARGS__);                                                                     \
+        }                                                                                          \
+    } while (0)
+
+/* Types */
+
+typedef struct cfl_log_ratelimit_s {
+    bool started;
+    uint32_t window_start_ms;
+    uint32_t suppressed;
+} cfl_log_ratelimit_t;
+
+/* External Declarations */
+
+/**
+ * @brief Check whether a rate limited log statement may be emitted
+ * @param rl         Call site state
+ * @param suppressed Output number of messages dropped since the last one
+ * @return true if the statement should be emitted
+ */
+extern bool cfl_log_ratelimit(cfl_log_ratelimit_t *rl, uint32_t *suppressed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_LOG_H */
@@ -10,7 +10,24 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/shell/shell.h>
 
+#include "cfl/cfl_async.h"
+#include "cfl/cfl_buf.h"
+#include "cfl/cfl_cache.h"
+#include "cfl/cfl_capture.h"
+#include "cfl/cfl_compact.h"
+#include "cfl/cfl_latency.h"
+#include "cfl/cfl_trace.h"
 #include "cfl/cfl_utilities.h"
+#include "cfl/services/cfl_budget.h"
+#include "cfl/services/cfl_pubsub.h"
+#include "cfl/services/cfl_ratelimit.h"
+#include "cfl/services/cfl_registry.h"
+#include "cfl/services/cfl_router.h"
+#include "cfl/services/cfl_sched.h"
+#include "cfl/services/cfl_service_danp.h"
+#include "cfl/services/cfl_session.h"
+#include "cfl/services/cfl_stream.h"
+#include "cfl/services/cfl_xfer.h"
 #include "danp/danp_defs.h"
 
 /* Imports */
@@ -18,9 +35,11 @@
 
 /* Definitions */
 
-LOG_MODULE_DECLARE(cfl);
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
 
 #define TMTC_SHELL_DEFAULT_TIMEOUT_MS 1000
+#define CFL_SHELL_TRACE_DEFAULT_COUNT 10
+#define CFL_SHELL_CAPTURE_LINE_BYTES  32
 
 /* Types */
 
@@ -32,14 +51,149 @@ typedef struct cfl_shell_data_s
     size_t rply_len;
 } cfl_shell_data_t;
 
+#if defined(CONFIG_CFL_CAPTURE)
+typedef struct cfl_shell_hex_s
+{
+    const struct shell *shell;
+    char line[(CFL_SHELL_CAPTURE_LINE_BYTES * 2) + 1];
+    size_t used;
+} cfl_shell_hex_t;
+#endif
+
 /* Forward Declarations */
 
 static int cfl_shell_transaction(const struct shell *shell, size_t argc, char **argv);
 static int cfl_shell_test(const struct shell *shell, size_t argc, char **argv);
 static int cfl_shell_stats(const struct shell *shell, size_t argc, char **argv);
+#if defined(CONFIG_CFL_ASYNC)
+static int cfl_shell_async(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_BUDGET)
+static int cfl_shell_budget(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_CACHE)
+static int cfl_shell_cache_show(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_cache_enable(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_cache_disable(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_cache_flush(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_CAPTURE)
+static int cfl_shell_capture_show(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_capture_on(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_capture_off(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_capture_clear(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_capture_dump(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+static int cfl_shell_compact(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_PUBSUB)
+static int cfl_shell_subs(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_SCHED)
+static int cfl_shell_sched_list(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_sched_flush(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_sched_cancel(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_SERVICE_RATE_LIMIT)
+static int cfl_shell_ratelimit(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_REGISTRY)
+static int cfl_shell_handlers(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_ROUTER)
+static int cfl_shell_route_show(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_route_add(const struct shell *shell, size_t argc, char **argv);
+static int cfl_shell_route_del(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_XFER)
+static int cfl_shell_xfer(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_SESSION)
+static int cfl_shell_sessions(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_LATENCY)
+static int cfl_shell_latency(const struct shell *shell, size_t argc, char **argv);
+#endif
+#if defined(CONFIG_CFL_TRACE)
+static int cfl_shell_trace(const struct shell *shell, size_t argc, char **argv);
+#endif
 
 /* Variables */
 
+#if defined(CONFIG_CFL_CACHE)
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_cfl_cache_cmds,
+    SHELL_CMD(show, NULL, "Print hit/miss counters", cfl_shell_cache_show),
+    SHELL_CMD_ARG(
+        enable,
+        NULL,
+        "Cache a read-only command\nUsage: cfl cache enable <cmd_id> <ttl_ms>",
+        cfl_shell_cache_enable,
+        3,
+        0),
+    SHELL_CMD_ARG(
+        disable,
+        NULL,
+        "Stop caching a command\nUsage: cfl cache disable <cmd_id>",
+        cfl_shell_cache_disable,
+        2,
+        0),
+    SHELL_CMD(flush, NULL, "Drop all cached replies", cfl_shell_cache_flush),
+    SHELL_SUBCMD_SET_END);
+#endif
+
+#if defined(CONFIG_CFL_CAPTURE)
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_cfl_capture_cmds,
+    SHELL_CMD(show, NULL, "Print capture ring state", cfl_shell_capture_show),
+    SHELL_CMD(on, NULL, "Start recording", cfl_shell_capture_on),
+    SHELL_CMD(off, NULL, "Stop recording, records are kept", cfl_shell_capture_off),
+    SHELL_CMD(clear, NULL, "Drop all records", cfl_shell_capture_clear),
+    SHELL_CMD(
+        dump,
+        NULL,
+        "Print the ring as a hex encoded pcap stream for scripts/cfl_capture.py",
+        cfl_shell_capture_dump),
+    SHELL_SUBCMD_SET_END);
+#endif
+
+#if defined(CONFIG_CFL_SCHED)
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_cfl_sched_cmds,
+    SHELL_CMD(list, NULL, "List queued commands", cfl_shell_sched_list),
+    SHELL_CMD(flush, NULL, "Drop all queued commands", cfl_shell_sched_flush),
+    SHELL_CMD_ARG(
+        cancel,
+        NULL,
+        "Cancel a queued command\nUsage: cfl sched cancel <id>",
+        cfl_shell_sched_cancel,
+        2,
+        0),
+    SHELL_SUBCMD_SET_END);
+#endif
+
+#if defined(CONFIG_CFL_ROUTER)
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_cfl_route_cmds,
+    SHELL_CMD(show, NULL, "Print routes and router counters", cfl_shell_route_show),
+    SHELL_CMD_ARG(
+        add,
+        NULL,
+        "Route a command range\nUsage: cfl route add <cmd_min> <cmd_max> <node> <port>",
+        cfl_shell_route_add,
+        5,
+        0),
+    SHELL_CMD_ARG(
+        del,
+        NULL,
+        "Remove the route of a command range\nUsage: cfl route del <cmd_min> <cmd_max>",
+        cfl_shell_route_del,
+        3,
+        0),
+    SHELL_SUBCMD_SET_END);
+#endif
+
 SHELL_STATIC_SUBCMD_SET_CREATE(
     sub_cfl_cmds,
     SHELL_CMD(
@@ -54,6 +208,92 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
         "Run CFL test (not implemented yet)\nUsage: cfl test <dest_id> <interval>",
         cfl_shell_test),
     SHELL_CMD(stats, NULL, "Print CFL statistics", cfl_shell_stats),
+    /* Optional commands are dropped entirely when their feature is disabled */
+    COND_CODE_1(
+        CONFIG_CFL_ASYNC,
+        (SHELL_CMD(async, NULL, "Print asynchronous transaction counters", cfl_shell_async),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_BUDGET,
+        (SHELL_CMD(
+             budget,
+             NULL,
+             "Print handler execution times, set a budget or clear the counters\nUsage: "
+             "cfl budget [<cmd_id> <budget_us>|reset]",
+             cfl_shell_budget),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_CACHE,
+        (SHELL_CMD(cache, &sub_cfl_cache_cmds, "Client transaction cache", NULL),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_CAPTURE,
+        (SHELL_CMD(capture, &sub_cfl_capture_cmds, "Service packet capture", NULL),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_COMPACT_HEADER,
+        (SHELL_CMD(
+             compact,
+             NULL,
+             "Print compact header peers or enable/disable a peer\nUsage: cfl compact "
+             "[<node> on|off]",
+             cfl_shell_compact),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_PUBSUB,
+        (SHELL_CMD(
+             subs,
+             NULL,
+             "Print telemetry subscribers of this node or drop them all\nUsage: cfl subs "
+             "[clear]",
+             cfl_shell_subs),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_SCHED,
+        (SHELL_CMD(sched, &sub_cfl_sched_cmds, "Time-tagged command queue", NULL),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_SERVICE_RATE_LIMIT,
+        (SHELL_CMD(
+             ratelimit,
+             NULL,
+             "Print rate limiter state or set a command limit\nUsage: cfl ratelimit "
+             "[<cmd_id> <rate> <burst>]",
+             cfl_shell_ratelimit),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_REGISTRY,
+        (SHELL_CMD(handlers, NULL, "Print handlers registered at runtime", cfl_shell_handlers),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_ROUTER,
+        (SHELL_CMD(route, &sub_cfl_route_cmds, "Command range routing", NULL),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_XFER,
+        (SHELL_CMD(xfer, NULL, "Print transfers being received", cfl_shell_xfer),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_SESSION,
+        (SHELL_CMD(sessions, NULL, "Print per-peer sessions", cfl_shell_sessions),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_LATENCY,
+        (SHELL_CMD(
+             latency,
+             NULL,
+             "Print uplink, remote and downlink time of transactions per peer\nUsage: cfl "
+             "latency [clear]",
+             cfl_shell_latency),),
+        ())
+    COND_CODE_1(
+        CONFIG_CFL_TRACE,
+        (SHELL_CMD(
+             trace,
+             NULL,
+             "Print per-stage latency of the last messages\nUsage: cfl trace [<count>|clear]",
+             cfl_shell_trace),),
+        ())
     SHELL_SUBCMD_SET_END);
 
 SHELL_CMD_REGISTER(cfl, &sub_cfl_cmds, "Base command for CFL operations", NULL);
@@ -128,6 +368,718 @@ static int cfl_shell_test(const struct shell *shell, size_t argc, char **argv)
 
 static int cfl_shell_stats(const struct shell *shell, size_t argc, char **argv)
 {
-    shell_print(shell, "CFL statistics not implemented yet");
+    cfl_service_danp_stats_t stats = {0};
+#if defined(CONFIG_CFL_BUF)
+    cfl_buf_stats_t buf = {0};
+#endif
+#if defined(CONFIG_CFL_STREAM)
+    cfl_stream_stats_t stream = {0};
+#endif
+
+    if (cfl_service_danp_get_stats(&stats) < 0)
+    {
+        shell_error(shell, "Failed to read service statistics");
+        return -EIO;
+    }
+
+    shell_print(shell, "rx_packets:   %u", stats.rx_packets);
+    shell_print(shell, "rx_invalid:   %u", stats.rx_invalid);
+    shell_print(shell, "rx_requests:  %u", stats.rx_requests);
+    shell_print(shell, "rx_pushes:    %u", stats.rx_pushes);
+    shell_print(shell, "rate_limited: %u", stats.rate_limited);
+    shell_print(shell, "rx_compact:   %u", stats.rx_compact);
+    shell_print(shell, "rx_dropped:   %u", stats.rx_dropped);
+#if defined(CONFIG_CFL_SESSION)
+    shell_print(shell, "duplicates:   %u", stats.duplicates);
+#endif
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+    shell_print(
+        shell,
+        "push_acks:    %u sent for %u pushes, %u retries, %u lost",
+        stats.push_acks,
+        stats.push_acked,
+        stats.push_retries,
+        stats.push_lost);
+#endif
+
+#if defined(CONFIG_CFL_BUF)
+    (void)cfl_buf_get_stats(&buf);
+    shell_print(
+        shell,
+        "small_bufs:   %u used, %u peak of %u",
+        buf.small_used,
+        buf.small_peak,
+        CONFIG_CFL_BUF_SMALL_COUNT);
+    shell_print(
+        shell,
+        "buf_moves:    %u shrunk, %u too large, %u exhausted, %u restored",
+        buf.shrunk,
+        buf.too_large,
+        buf.exhausted,
+        buf.restored);
+#endif
+
+#if defined(CONFIG_CFL_STREAM)
+    (void)cfl_stream_get_stats(&stream);
+    shell_print(
+        shell,
+        "stream:       %u accepted, %u frames in, %u out, %u resync bytes, %u errors",
+        stream.accepted,
+        stream.frames_rx,
+        stream.frames_tx,
+        stream.resyncs,
+        stream.errors);
+#endif
+
     return 0;
-}
\ No newline at end of file
+}
+
+#if defined(CONFIG_CFL_ASYNC)
+static int cfl_shell_async(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_async_stats_t stats = {0};
+
+    cfl_async_get_stats(&stats);
+
+    shell_print(shell, "active:    %u", stats.active);
+    shell_print(shell, "completed: %u", stats.completed);
+    shell_print(shell, "timed_out: %u", stats.timed_out);
+    shell_print(shell, "unmatched: %u", stats.unmatched);
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_BUDGET)
+static int cfl_shell_budget(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_budget_stats_t stats = {0};
+    int32_t ret = 0;
+
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0)
+    {
+        cfl_budget_reset();
+        return 0;
+    }
+
+    if (argc >= 3)
+    {
+        ret = cfl_budget_set((uint16_t)atoi(argv[1]), (uint32_t)atoi(argv[2]));
+        if (ret < 0)
+        {
+            shell_error(shell, "Failed to set budget: %d", ret);
+        }
+        return ret;
+    }
+
+    for (size_t i = 0;; i++)
+    {
+        ret = cfl_budget_get(i, &stats);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell,
+                "  [cmd_id]=%u [calls]=%u [avg]=%uus [max]=%uus [budget]=%uus [overruns]=%u "
+                "[stalls]=%u [refused]=%u%s",
+                stats.cmd_id,
+                stats.calls,
+                k_cyc_to_us_floor32(stats.avg_cycles),
+                k_cyc_to_us_floor32(stats.max_cycles),
+                stats.budget_us,
+                stats.overruns,
+                stats.stalls,
+                stats.refused,
+                stats.quarantined ? " quarantined" : "");
+        }
+    }
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_CACHE)
+static int cfl_shell_cache_show(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_cache_stats_t stats = {0};
+    uint32_t served = 0;
+    uint32_t total = 0;
+
+    cfl_cache_get_stats(&stats);
+
+    /* Coalesced calls are answered without their own round-trip as well */
+    served = stats.hits + stats.coalesced;
+    total = served + stats.misses;
+
+    shell_print(shell, "hits:      %u", stats.hits);
+    shell_print(shell, "coalesced: %u", stats.coalesced);
+    shell_print(shell, "misses:    %u", stats.misses);
+    shell_print(shell, "bypassed:  %u", stats.bypassed);
+    shell_print(shell, "hit ratio: %u%%", (total > 0) ? (served * 100U) / total : 0U);
+
+    return 0;
+}
+
+static int cfl_shell_cache_enable(const struct shell *shell, size_t argc, char **argv)
+{
+    int32_t ret = cfl_cache_enable((uint16_t)atoi(argv[1]), (uint32_t)atoi(argv[2]));
+
+    if (ret < 0)
+    {
+        shell_error(shell, "Failed to enable caching: %d", ret);
+    }
+
+    return ret;
+}
+
+static int cfl_shell_cache_disable(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_cache_disable((uint16_t)atoi(argv[1]));
+    return 0;
+}
+
+static int cfl_shell_cache_flush(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_cache_flush();
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_CAPTURE)
+static int cfl_shell_capture_show(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_capture_stats_t stats = {0};
+
+    cfl_capture_get_stats(&stats);
+
+    shell_print(shell, "enabled:     %s", stats.enabled ? "yes" : "no");
+    shell_print(shell, "records:     %u", stats.records);
+    shell_print(shell, "overwritten: %u", stats.overwritten);
+
+    return 0;
+}
+
+static int cfl_shell_capture_on(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_capture_set_enabled(true);
+    return 0;
+}
+
+static int cfl_shell_capture_off(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_capture_set_enabled(false);
+    return 0;
+}
+
+static int cfl_shell_capture_clear(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_capture_clear();
+    return 0;
+}
+
+static void cfl_shell_hex_flush(cfl_shell_hex_t *hex)
+{
+    if (hex->used > 0)
+    {
+        hex->line[hex->used * 2] = '\0';
+        shell_print(hex->shell, "%s", hex->line);
+        hex->used = 0;
+    }
+}
+
+static void cfl_shell_hex_write(void *ctx, const uint8_t *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    cfl_shell_hex_t *hex = (cfl_shell_hex_t *)ctx;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hex->line[hex->used * 2] = digits[data[i] >> 4];
+        hex->line[(hex->used * 2) + 1] = digits[data[i] & 0x0F];
+        hex->used++;
+        if (hex->used == CFL_SHELL_CAPTURE_LINE_BYTES)
+        {
+            cfl_shell_hex_flush(hex);
+        }
+    }
+}
+
+static int cfl_shell_capture_dump(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_shell_hex_t hex = {.shell = shell};
+    size_t records = 0;
+
+    /* Markers let the host script find the stream in a console log */
+    shell_print(shell, "-----BEGIN CFL CAPTURE-----");
+    records = cfl_capture_dump(cfl_shell_hex_write, &hex);
+    cfl_shell_hex_flush(&hex);
+    shell_print(shell, "-----END CFL CAPTURE-----");
+    shell_print(shell, "%u records", (unsigned int)records);
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+static int cfl_shell_compact(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_compact_peer_t peer = {0};
+    int32_t ret = 0;
+
+    if (argc >= 3)
+    {
+        ret = cfl_compact_set_peer((uint16_t)atoi(argv[1]), strcmp(argv[2], "on") == 0);
+        if (ret < 0)
+        {
+            shell_error(shell, "Failed to update compact peer: %d", ret);
+        }
+        return ret;
+    }
+
+    for (size_t i = 0;; i++)
+    {
+        ret = cfl_compact_get_peer(i, &peer);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell, "  [node]=%u [source]=%s", peer.node, peer.learned ? "learned" : "config");
+        }
+    }
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_PUBSUB)
+static int cfl_shell_subs(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_pubsub_stats_t stats = {0};
+    int32_t ret = 0;
+
+    if (argc >= 2 && strcmp(argv[1], "clear") == 0)
+    {
+        cfl_pubsub_clear();
+        return 0;
+    }
+
+    for (size_t i = 0;; i++)
+    {
+        ret = cfl_pubsub_get(i, &stats);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell,
+                "  [node]=%u [port]=%u [cmd_id]=%u [period]=%ums [pushes]=%u [failures]=%u",
+                stats.node,
+                stats.port,
+                stats.cmd_id,
+                stats.period_ms,
+                stats.pushes,
+                stats.failures);
+        }
+    }
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_SCHED)
+static int cfl_shell_sched_list(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_sched_info_t info = {0};
+    cfl_sched_stats_t stats = {0};
+    int64_t now = k_uptime_get();
+    int32_t ret = 0;
+
+    for (size_t i = 0;; i++)
+    {
+        ret = cfl_sched_get(i, &info);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell,
+                "  [id]=0x%08x [in]=%lldms [cmd_id]=%u [src]=%u [len]=%u",
+                info.id,
+                (long long)(info.exec_at_ms - now),
+                info.cmd_id,
+                info.src_node,
+                info.data_len);
+        }
+    }
+
+    cfl_sched_get_stats(&stats);
+    shell_print(
+        shell,
+        "queued: %u executed: %u failed: %u rejected: %u",
+        stats.queued,
+        stats.executed,
+        stats.failed,
+        stats.rejected);
+
+    return 0;
+}
+
+static int cfl_shell_sched_flush(const struct shell *shell, size_t argc, char **argv)
+{
+    shell_print(shell, "Dropped %u queued commands", (unsigned int)cfl_sched_flush());
+    return 0;
+}
+
+static int cfl_shell_sched_cancel(const struct shell *shell, size_t argc, char **argv)
+{
+    int32_t ret = cfl_sched_cancel((uint32_t)strtoul(argv[1], NULL, 0));
+
+    if (ret < 0)
+    {
+        shell_error(shell, "Failed to cancel command: %d", ret);
+    }
+
+    return ret;
+}
+#endif
+#if defined(CONFIG_CFL_SERVICE_RATE_LIMIT)
+static void cfl_shell_print_buckets(
+    const struct shell *shell,
+    const char *title,
+    int32_t (*get)(size_t, cfl_ratelimit_stats_t *))
+{
+    cfl_ratelimit_stats_t stats = {0};
+    int32_t ret = 0;
+
+    shell_print(shell, "%s:", title);
+    for (size_t i = 0;; i++)
+    {
+        ret = get(i, &stats);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell,
+                "  [id]=%u [tokens]=%u [passed]=%u [limited]=%u",
+                stats.id,
+                stats.tokens,
+                stats.passed,
+                stats.limited);
+        }
+    }
+}
+
+static int cfl_shell_ratelimit(const struct shell *shell, size_t argc, char **argv)
+{
+    int32_t ret = 0;
+
+    if (argc >= 4)
+    {
+        ret = cfl_ratelimit_set_cmd(
+            (uint16_t)atoi(argv[1]), (uint32_t)atoi(argv[2]), (uint32_t)atoi(argv[3]));
+        if (ret < 0)
+        {
+            shell_error(shell, "Failed to set command limit: %d", ret);
+        }
+        return ret;
+    }
+
+    cfl_shell_print_buckets(shell, "Nodes", cfl_ratelimit_get_node);
+    cfl_shell_print_buckets(shell, "Commands", cfl_ratelimit_get_cmd);
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_REGISTRY)
+static int cfl_shell_handlers(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_registry_entry_t entry = {0};
+    cfl_registry_stats_t stats = {0};
+
+    for (size_t i = 0; cfl_registry_get(i, &entry) == 0; i++)
+    {
+        shell_print(
+            shell,
+            "  [cmd_id]=%u [handler]=%p [ctx]=%p",
+            entry.cmd_id,
+            (void *)entry.handler,
+            entry.ctx);
+    }
+
+    cfl_registry_get_stats(&stats);
+    shell_print(
+        shell,
+        "entries: %u version: %u retries: %u waits: %ums",
+        stats.entries,
+        stats.version,
+        stats.retries,
+        stats.waits_ms);
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_ROUTER)
+static int cfl_shell_route_show(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_route_t route = {0};
+    cfl_router_stats_t stats = {0};
+    int32_t ret = 0;
+
+    for (size_t i = 0;; i++)
+    {
+        ret = cfl_router_get_route(i, &route);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell,
+                "  [cmd]=%u-%u [node]=%u [port]=%u",
+                route.cmd_min,
+                route.cmd_max,
+                route.dst_node,
+                route.dst_port);
+        }
+    }
+
+    cfl_router_get_stats(&stats);
+    shell_print(
+        shell,
+        "forwarded: %u replies: %u pending: %u unmatched: %u expired: %u overflow: %u "
+        "looped: %u",
+        stats.forwarded,
+        stats.replies,
+        stats.pending,
+        stats.unmatched,
+        stats.expired,
+        stats.overflow,
+        stats.looped);
+
+    return 0;
+}
+
+static int cfl_shell_route_add(const struct shell *shell, size_t argc, char **argv)
+{
+    const cfl_route_t route = {
+        .cmd_min = (uint16_t)strtoul(argv[1], NULL, 0),
+        .cmd_max = (uint16_t)strtoul(argv[2], NULL, 0),
+        .dst_node = (uint16_t)strtoul(argv[3], NULL, 0),
+        .dst_port = (uint16_t)strtoul(argv[4], NULL, 0),
+    };
+    int32_t ret = cfl_router_add(&route);
+
+    if (ret < 0)
+    {
+        shell_error(shell, "Failed to add route: %d", ret);
+    }
+
+    return ret;
+}
+
+static int cfl_shell_route_del(const struct shell *shell, size_t argc, char **argv)
+{
+    int32_t ret = cfl_router_remove(
+        (uint16_t)strtoul(argv[1], NULL, 0), (uint16_t)strtoul(argv[2], NULL, 0));
+
+    if (ret < 0)
+    {
+        shell_error(shell, "Failed to remove route: %d", ret);
+    }
+
+    return ret;
+}
+#endif
+#if defined(CONFIG_CFL_XFER)
+static int cfl_shell_xfer(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_xfer_info_t info = {0};
+    int32_t ret = 0;
+
+    for (size_t i = 0;; i++)
+    {
+        ret = cfl_xfer_get(i, &info);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell,
+                "  [id]=%u [src]=%u [object]=0x%08x [size]=%u [chunks]=%u/%u [idle]=%ums",
+                info.xfer_id,
+                info.src_node,
+                info.object,
+                info.size,
+                info.received,
+                info.chunks,
+                info.idle_ms);
+        }
+    }
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_SESSION)
+static int cfl_shell_sessions(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_session_info_t info = {0};
+    cfl_session_stats_t stats = {0};
+    int32_t ret = 0;
+
+    for (size_t i = 0;; i++)
+    {
+        ret = cfl_session_get(i, &info);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell,
+                "  [node]=%u [port]=%u [idle]=%ums [rx]=%u/%uB [dup]=%u [stale]=%u [seq]=%u/%u",
+                info.node,
+                info.port,
+                info.idle_ms,
+                info.rx_msgs,
+                info.rx_bytes,
+                info.duplicates,
+                info.stale,
+                info.rqst_top,
+                info.push_top);
+        }
+    }
+
+    cfl_session_get_stats(&stats);
+    shell_print(
+        shell,
+        "created: %u evicted: %u duplicates: %u stale: %u resyncs: %u",
+        stats.created,
+        stats.evicted,
+        stats.duplicates,
+        stats.stale,
+        stats.resyncs);
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_LATENCY)
+static int cfl_shell_latency(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_latency_peer_t peer = {0};
+    int32_t ret = 0;
+
+    if (argc >= 2 && strcmp(argv[1], "clear") == 0)
+    {
+        cfl_latency_reset();
+        return 0;
+    }
+
+    for (size_t i = 0;; i++)
+    {
+        ret = cfl_latency_get(i, &peer);
+        if (ret == -EINVAL)
+        {
+            break;
+        }
+        if (ret == 0)
+        {
+            shell_print(
+                shell,
+                "  [node]=%u [samples]=%u [up]=%dus [remote]=%dus [down]=%dus [offset]=%lldus "
+                "[delay]=%uus",
+                peer.node,
+                peer.samples,
+                peer.uplink_us,
+                peer.remote_us,
+                peer.downlink_us,
+                (long long)peer.offset_us,
+                peer.delay_us);
+        }
+    }
+
+    return 0;
+}
+#endif
+#if defined(CONFIG_CFL_TRACE)
+static const char *const trace_stage_names[][CFL_TRACE_STAGE_COUNT] = {
+    [CFL_TRACE_KIND_SERVICE] = {"rx", "lookup", "exec", "build", "tx"},
+    [CFL_TRACE_KIND_TRANSACTION] = {"start", "alloc", "sent", "recv", "done"},
+};
+
+static void cfl_shell_print_trace(const struct shell *shell, const cfl_trace_record_t *rec)
+{
+    char line[128];
+    int len = 0;
+    uint32_t prev = rec->stamp[0];
+
+    len = snprintf(
+        line,
+        sizeof(line),
+        "%s node=%u cmd=%u",
+        (rec->kind == CFL_TRACE_KIND_SERVICE) ? "svc" : "txn",
+        rec->node,
+        rec->cmd_id);
+
+    for (uint8_t stage = 1; stage < CFL_TRACE_STAGE_COUNT && len < (int)sizeof(line); stage++)
+    {
+        if ((rec->stage_mask & (1U << stage)) == 0)
+        {
+            continue;
+        }
+
+        len += snprintf(
+            &line[len],
+            sizeof(line) - len,
+            " %s=%uus",
+            trace_stage_names[rec->kind][stage],
+            k_cyc_to_us_floor32(rec->stamp[stage] - prev));
+        prev = rec->stamp[stage];
+    }
+
+    if (len < (int)sizeof(line))
+    {
+        snprintf(
+            &line[len], sizeof(line) - len, " total=%uus", k_cyc_to_us_floor32(prev - rec->stamp[0]));
+    }
+
+    shell_print(shell, "%s", line);
+}
+
+static int cfl_shell_trace(const struct shell *shell, size_t argc, char **argv)
+{
+    cfl_trace_record_t rec;
+    size_t count = CFL_SHELL_TRACE_DEFAULT_COUNT;
+
+    if (argc >= 2)
+    {
+        if (strcmp(argv[1], "clear") == 0)
+        {
+            cfl_trace_clear();
+            return 0;
+        }
+        count = (size_t)atoi(argv[1]);
+    }
+
+    /* Oldest first so the output reads in arrival order */
+    for (size_t age = count; age > 0; age--)
+    {
+        if (cfl_trace_get(age - 1, &rec) == 0)
+        {
+            cfl_shell_print_trace(shell, &rec);
+        }
+    }
+
+    return 0;
+}
+#endif
@@ -0,0 +1,133 @@
+/* cfl_thread.c - Thread placement for CFL threads */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl_thread.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+#if defined(CONFIG_CFL_WORKQ)
+static K_THREAD_STACK_DEFINE(cfl_workq_stack, CONFIG_CFL_WORKQ_STACK_SIZE);
+static struct k_work_q cfl_workq;
+#endif
+
+/* Functions */
+
+int32_t cfl_thread_set_cpu_mask(k_tid_t tid, uint32_t cpu_mask)
+{
+#if defined(CONFIG_SCHED_CPU_MASK)
+    int32_t ret = 0;
+
+    if (tid == NULL || (cpu_mask >> CONFIG_MP_MAX_NUM_CPUS) != 0)
+    {
+        return -EINVAL;
+    }
+
+    if (cpu_mask == 0)
+    {
+        return k_thread_cpu_mask_enable_all(tid);
+    }
+
+    ret = k_thread_cpu_mask_clear(tid);
+    for (int cpu = 0; ret == 0 && cpu < CONFIG_MP_MAX_NUM_CPUS; cpu++)
+    {
+        if (cpu_mask & BIT(cpu))
+        {
+            ret = k_thread_cpu_mask_enable(tid, cpu);
+        }
+    }
+
+    return ret;
+#else
+    ARG_UNUSED(tid);
+    return (cpu_mask == 0) ? 0 : -ENOTSUP;
+#endif
+}
+
+int32_t cfl_thread_place(k_tid_t tid, int32_t priority, uint32_t cpu_mask)
+{
+    int32_t ret = 0;
+
+    if (tid == NULL || tid == k_current_get())
+    {
+        return -EINVAL;
+    }
+
+    k_thread_priority_set(tid, priority);
+
+#if defined(CONFIG_SCHED_CPU_MASK)
+    /* CPU masks may only be changed while the thread is not runnable */
+    k_thread_suspend(tid);
+    ret = cfl_thread_set_cpu_mask(tid, cpu_mask);
+    k_thread_resume(tid);
+#else
+    ret = cfl_thread_set_cpu_mask(tid, cpu_mask);
+#endif
+
+    if (ret < 0)
+    {
+        LOG_ERR("Failed to set CPU mask 0x%x: %d", cpu_mask, ret);
+    }
+
+    return ret;
+}
+
+struct k_work_q *cfl_thread_workq(void)
+{
+#if defined(CONFIG_CFL_WORKQ)
+    return &cfl_workq;
+#else
+    return &k_sys_work_q;
+#endif
+}
+
+#if defined(CONFIG_CFL_WORKQ)
+static int cfl_thread_workq_init(void)
+{
+    const struct k_work_queue_config cfg = {
+        .name = "cfl_workq",
+    };
+
+    k_work_queue_init(&cfl_workq);
+    k_work_queue_start(
+        &cfl_workq,
+        cfl_workq_stack,
+        K_THREAD_STACK_SIZEOF(cfl_workq_stack),
+        CONFIG_CFL_WORKQ_PRIORITY,
+        &cfg);
+
+    /* The queue thread is idle at this point, so moving it is cheap */
+    if (CONFIG_CFL_WORKQ_CPU_MASK != 0)
+    {
+        (void)cfl_thread_place(
+            k_work_queue_thread_get(&cfl_workq),
+            CONFIG_CFL_WORKQ_PRIORITY,
+            CONFIG_CFL_WORKQ_CPU_MASK);
+    }
+
+    return 0;
+}
+
+SYS_INIT(cfl_thread_workq_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif
@@ -0,0 +1,107 @@
+/* cfl_trace.c - Per-message stage latency tracing */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#if defined(CONFIG_CFL_TRACE_TRACING)
+#include <zephyr/tracing/tracing.h>
+#endif
+
+#include "cfl/cfl_trace.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+#define TRACE_DEPTH (CONFIG_CFL_TRACE_DEPTH)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static cfl_trace_record_t records[TRACE_DEPTH];
+static atomic_t next_index = ATOMIC_INIT(0);
+
+/* Functions */
+
+cfl_trace_record_t *cfl_trace_begin(uint8_t kind, uint16_t node)
+{
+    /* Slots are claimed lock-free; a slot is only reused after the ring wraps */
+    uint32_t index = (uint32_t)atomic_inc(&next_index) % TRACE_DEPTH;
+    cfl_trace_record_t *rec = &records[index];
+
+    rec->complete = 0;
+    rec->kind = kind;
+    rec->node = node;
+    rec->cmd_id = 0;
+    rec->stage_mask = 0;
+    cfl_trace_stamp(rec, 0);
+
+    return rec;
+}
+
+void cfl_trace_end(cfl_trace_record_t *rec)
+{
+    if (rec == NULL)
+    {
+        return;
+    }
+
+    rec->complete = 1;
+
+#if defined(CONFIG_CFL_TRACE_TRACING)
+    uint32_t last = rec->stamp[0];
+    for (uint8_t stage = 1; stage < CFL_TRACE_STAGE_COUNT; stage++)
+    {
+        if (rec->stage_mask & (1U << stage))
+        {
+            last = rec->stamp[stage];
+        }
+    }
+
+    sys_trace_named_event(
+        (rec->kind == CFL_TRACE_KIND_SERVICE) ? "cfl_service" : "cfl_transaction",
+        rec->cmd_id,
+        k_cyc_to_us_floor32(last - rec->stamp[0]));
+#endif
+}
+
+int32_t cfl_trace_get(size_t age, cfl_trace_record_t *out)
+{
+    uint32_t newest = (uint32_t)atomic_get(&next_index);
+
+    if (out == NULL)
+    {
+        return -EINVAL;
+    }
+
+    if (age >= TRACE_DEPTH || age >= newest)
+    {
+        return -ENOENT;
+    }
+
+    *out = records[(newest - 1 - age) % TRACE_DEPTH];
+    if (!out->complete)
+    {
+        return -ENOENT;
+    }
+
+    return 0;
+}
+
+void cfl_trace_clear(void)
+{
+    memset(records, 0, sizeof(records));
+    atomic_set(&next_index, 0);
+}
@@ -0,0 +1,95 @@
+/* cfl_transport.c - Transport selection and the DANP backend */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <stddef.h>
+
+#include <zephyr/kernel.h>
+
+#include "danp/danp.h"
+
+#include "cfl/cfl_transport.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+#if defined(CONFIG_CFL_TRANSPORT_UDP_DEFAULT)
+static const cfl_transport_ops_t *selected = &cfl_transport_udp;
+#else
+static const cfl_transport_ops_t *selected = &cfl_transport_danp;
+#endif
+
+/* Functions */
+
+static int32_t dgram_open(void **sock, uint16_t port)
+{
+    danp_socket_t *danp_sock = danp_socket(DANP_TYPE_DGRAM);
+
+    if (danp_sock == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    if (port != 0 && danp_bind(danp_sock, port) < 0)
+    {
+        danp_close(danp_sock);
+        return -EADDRNOTAVAIL;
+    }
+
+    *sock = danp_sock;
+    return 0;
+}
+
+static void dgram_close(void *sock)
+{
+    danp_close((danp_socket_t *)sock);
+}
+
+static int32_t dgram_send(void *sock, danp_packet_t *pkt, uint16_t node, uint16_t port)
+{
+    return danp_send_packet_to((danp_socket_t *)sock, pkt, node, port);
+}
+
+static danp_packet_t *dgram_recv(void *sock, uint16_t *node, uint16_t *port, uint32_t timeout_ms)
+{
+    return danp_recv_packet_from((danp_socket_t *)sock, node, port, timeout_ms);
+}
+
+const cfl_transport_ops_t cfl_transport_danp = {
+    .name = "danp",
+    .open = dgram_open,
+    .close = dgram_close,
+    .send_to = dgram_send,
+    .recv_from = dgram_recv,
+};
+
+const cfl_transport_ops_t *cfl_transport_get(void)
+{
+    return selected;
+}
+
+int32_t cfl_transport_set(const cfl_transport_ops_t *ops)
+{
+    if (ops == NULL || ops->open == NULL || ops->close == NULL || ops->send_to == NULL ||
+        ops->recv_from == NULL)
+    {
+        return -EINVAL;
+    }
+
+    selected = ops;
+    return 0;
+}
@@ -0,0 +1,315 @@
+/* cfl_transport_udp.c - UDP transport backend */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+
+#include "danp/danp_buffer.h"
+
+#include "cfl/cfl_transport.h"
+#include "cfl_log.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define UDP_SOCKETS    (CONFIG_CFL_TRANSPORT_UDP_SOCKETS)
+#define UDP_PEERS      (CONFIG_CFL_TRANSPORT_UDP_PEERS)
+#define UDP_BASE_PORT  (CONFIG_CFL_TRANSPORT_UDP_BASE_PORT)
+#define UDP_NODE_PORTS (CONFIG_CFL_TRANSPORT_UDP_NODE_PORTS)
+#define UDP_LOCAL_NODE (CONFIG_CFL_TRANSPORT_UDP_NODE)
+
+/* Ephemeral ports are taken from the upper half of the block of this node */
+#define UDP_EPHEMERAL_FIRST (UDP_NODE_PORTS / 2)
+
+/* Types */
+
+typedef struct udp_sock_s
+{
+    bool used;
+    int fd;
+} udp_sock_t;
+
+typedef struct udp_peer_s
+{
+    bool used;
+    uint16_t node;
+    struct in_addr addr;
+} udp_peer_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static udp_sock_t socks[UDP_SOCKETS];
+static udp_peer_t peers[UDP_PEERS];
+
+/* Functions */
+
+static int32_t udp_port_of(uint16_t node, uint16_t port, uint16_t *udp_port)
+{
+    uint32_t value = UDP_BASE_PORT + ((uint32_t)node * UDP_NODE_PORTS) + port;
+
+    if (port >= UDP_NODE_PORTS || value > UINT16_MAX)
+    {
+        return -EINVAL;
+    }
+
+    *udp_port = (uint16_t)value;
+    return 0;
+}
+
+static void peer_addr(uint16_t node, struct in_addr *addr)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bool found = false;
+
+    for (size_t i = 0; i < UDP_PEERS; i++)
+    {
+        if (peers[i].used && peers[i].node == node)
+        {
+            *addr = peers[i].addr;
+            found = true;
+            break;
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    if (!found)
+    {
+        (void)zsock_inet_pton(AF_INET, CONFIG_CFL_TRANSPORT_UDP_DEFAULT_ADDR, addr);
+    }
+}
+
+static int32_t bind_port(int fd, uint16_t port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    uint16_t udp_port = 0;
+
+    if (udp_port_of(UDP_LOCAL_NODE, port, &udp_port) < 0)
+    {
+        return -EINVAL;
+    }
+    addr.sin_port = htons(udp_port);
+
+    if (zsock_bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        return -errno;
+    }
+
+    return 0;
+}
+
+static int32_t udp_open(void **sock, uint16_t port)
+{
+    udp_sock_t *slot = NULL;
+    k_spinlock_key_t key;
+    int fd = 0;
+    int32_t ret = -EADDRINUSE;
+
+    key = k_spin_lock(&lock);
+    for (size_t i = 0; i < UDP_SOCKETS; i++)
+    {
+        if (!socks[i].used)
+        {
+            slot = &socks[i];
+            slot->used = true;
+            break;
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    if (slot == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    for (;;)
+    {
+        fd = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (fd < 0)
+        {
+            ret = -ENOMEM;
+            break;
+        }
+
+        if (port != 0)
+        {
+            ret = bind_port(fd, port);
+        }
+        else
+        {
+            for (uint16_t p = UDP_EPHEMERAL_FIRST; p < UDP_NODE_PORTS && ret == -EADDRINUSE; p++)
+            {
+                ret = bind_port(fd, p);
+            }
+        }
+
+        if (ret < 0)
+        {
+            (void)zsock_close(fd);
+            ret = -EADDRNOTAVAIL;
+            break;
+        }
+
+        slot->fd = fd;
+        *sock = slot;
+        break;
+    }
+
+    if (ret < 0)
+    {
+        slot->used = false;
+    }
+
+    return ret;
+}
+
+static void udp_close(void *sock)
+{
+    udp_sock_t *slot = (udp_sock_t *)sock;
+
+    (void)zsock_close(slot->fd);
+    slot->used = false;
+}
+
+static int32_t udp_send(void *sock, danp_packet_t *pkt, uint16_t node, uint16_t port)
+{
+    udp_sock_t *slot = (udp_sock_t *)sock;
+    struct sockaddr_in addr = {.sin_family = AF_INET};
+    uint16_t udp_port = 0;
+    int32_t ret = udp_port_of(node, port, &udp_port);
+
+    if (ret == 0)
+    {
+        addr.sin_port = htons(udp_port);
+        peer_addr(node, &addr.sin_addr);
+
+        ret = (int32_t)zsock_sendto(
+            slot->fd, pkt->payload, pkt->length, 0, (struct sockaddr *)&addr, sizeof(addr));
+        if (ret < 0)
+        {
+            ret = -errno;
+        }
+    }
+
+    danp_buffer_free(pkt);
+    return ret;
+}
+
+static danp_packet_t *udp_recv(void *sock, uint16_t *node, uint16_t *port, uint32_t timeout_ms)
+{
+    udp_sock_t *slot = (udp_sock_t *)sock;
+    struct zsock_pollfd pfd = {.fd = slot->fd, .events = ZSOCK_POLLIN};
+    struct sockaddr_in addr;
+    socklen_t addr_len = 0;
+    danp_packet_t *pkt = NULL;
+    int64_t deadline = k_uptime_get() + timeout_ms;
+    int64_t remaining = timeout_ms;
+    ssize_t len = 0;
+    uint8_t discard = 0;
+    uint16_t offset = 0;
+
+    while (pkt == NULL && remaining >= 0)
+    {
+        if (zsock_poll(&pfd, 1, (int)MIN(remaining, INT32_MAX)) <= 0)
+        {
+            break;
+        }
+
+        /* Taken only once a datagram is waiting, an idle socket holds no buffer */
+        pkt = danp_buffer_get();
+        if (pkt == NULL)
+        {
+            CFL_LOG_RATELIMITED(LOG_ERR, "No buffer for a UDP datagram, dropped");
+            (void)zsock_recv(slot->fd, &discard, sizeof(discard), 0);
+            remaining = deadline - k_uptime_get();
+            continue;
+        }
+
+        addr_len = sizeof(addr);
+        len = zsock_recvfrom(
+            slot->fd, pkt->payload, DANP_MAX_PACKET_SIZE, 0, (struct sockaddr *)&addr, &addr_len);
+
+        /* Datagrams from outside the CFL port range cannot be answered */
+        if (len <= 0 || addr.sin_family != AF_INET || ntohs(addr.sin_port) < UDP_BASE_PORT)
+        {
+            danp_buffer_free(pkt);
+            pkt = NULL;
+            remaining = deadline - k_uptime_get();
+            continue;
+        }
+
+        offset = (uint16_t)(ntohs(addr.sin_port) - UDP_BASE_PORT);
+        pkt->length = (uint16_t)len;
+        *node = offset / UDP_NODE_PORTS;
+        *port = offset % UDP_NODE_PORTS;
+    }
+
+    return pkt;
+}
+
+const cfl_transport_ops_t cfl_transport_udp = {
+    .name = "udp",
+    .open = udp_open,
+    .close = udp_close,
+    .send_to = udp_send,
+    .recv_from = udp_recv,
+};
+
+int32_t cfl_transport_udp_set_peer(uint16_t node, const char *addr)
+{
+    struct in_addr parsed = {0};
+    udp_peer_t *peer = NULL;
+    udp_peer_t *unused = NULL;
+    k_spinlock_key_t key;
+
+    if (addr != NULL && zsock_inet_pton(AF_INET, addr, &parsed) != 1)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    for (size_t i = 0; i < UDP_PEERS; i++)
+    {
+        if (peers[i].used && peers[i].node == node)
+        {
+            peer = &peers[i];
+        }
+        else if (!peers[i].used && unused == NULL)
+        {
+            unused = &peers[i];
+        }
+    }
+
+    if (peer == NULL && addr != NULL)
+    {
+        peer = unused;
+    }
+
+    if (peer != NULL)
+    {
+        peer->used = (addr != NULL);
+        peer->node = node;
+        peer->addr = parsed;
+    }
+    k_spin_unlock(&lock, key);
+
+    return (peer == NULL && addr != NULL) ? -ENOMEM : 0;
+}
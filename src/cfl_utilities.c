@@ -4,21 +4,32 @@
 
 /* Includes */
 
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/printk.h>
+#if defined(CONFIG_ENTROPY_HAS_DRIVER) || defined(CONFIG_TEST_RANDOM_GENERATOR)
+#include <zephyr/random/random.h>
+#endif
 
-#include "danp/danp.h"
 #include "danp/danp_buffer.h"
 
 #include "cfl/cfl.h"
+#include "cfl/cfl_compact.h"
+#include "cfl/cfl_ext.h"
+#include "cfl/cfl_ext_codec.h"
+#include "cfl/cfl_latency.h"
+#include "cfl/cfl_trace.h"
+#include "cfl/cfl_transport.h"
 #include "cfl/cfl_utilities.h"
+#include "cfl_log.h"
 
 /* Imports */
 
 
 /* Definitions */
 
-LOG_MODULE_DECLARE(cfl);
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
 
 /* Types */
 
@@ -28,20 +39,58 @@ LOG_MODULE_DECLARE(cfl);
 
 /* Variables */
 
+static atomic_t seq_counter = ATOMIC_INIT(0);
 
 /* Functions */
 
+uint16_t cfl_next_seq(void)
+{
+    uint16_t seq = 0;
+
+    /* 0 marks an unsequenced request, as sent by older cfl_transaction() */
+    do
+    {
+        seq = (uint16_t)atomic_inc(&seq_counter);
+    } while (seq == 0);
+
+    return seq;
+}
+
+uint32_t cfl_random32(void)
+{
+#if defined(CONFIG_ENTROPY_HAS_DRIVER) || defined(CONFIG_TEST_RANDOM_GENERATOR)
+    return sys_rand32_get();
+#else
+    return k_cycle_get_32();
+#endif
+}
+
+static int cfl_seq_init(void)
+{
+    (void)atomic_set(&seq_counter, (atomic_val_t)cfl_random32());
+
+    return 0;
+}
+
+SYS_INIT(cfl_seq_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
 static int32_t tmtc_transaction_packet(
     uint16_t dest_id,
     uint16_t dest_port,
     danp_packet_t *rqst_pkt,
     danp_packet_t **received_pkt,
-    uint32_t timeout)
+    uint32_t timeout,
+    cfl_trace_record_t *trace,
+    uint64_t *sent_us,
+    uint64_t *recv_us)
 {
     int32_t ret = 0;
-    danp_socket_t *sock = NULL;
+    const cfl_transport_ops_t *transport = cfl_transport_get();
+    void *sock = NULL;
     bool is_sock_created = false;
     int32_t sent_len = 0;
+    uint16_t src_node = 0;
+    uint16_t src_port = 0;
 
     for (;;)
     {
@@ -52,8 +101,7 @@ static int32_t tmtc_transaction_packet(
             break;
         }
 
-        sock = danp_socket(DANP_TYPE_DGRAM);
-        if (!sock)
+        if (transport->open(&sock, 0) < 0)
         {
             ret = -1; // Socket creation failed
             LOG_ERR("Failed to create socket");
@@ -61,21 +109,32 @@ static int32_t tmtc_transaction_packet(
         }
         is_sock_created = true;
 
-        sent_len = danp_send_packet_to(sock, rqst_pkt, dest_id, dest_port);
+#if defined(CONFIG_CFL_LATENCY)
+        *sent_us = cfl_latency_now_us();
+#endif
+        sent_len = transport->send_to(sock, rqst_pkt, dest_id, dest_port);
         if (sent_len < 0)
         {
             ret = -3; // Send failed
             LOG_ERR("Failed to send request packet");
             break;
         }
+        CFL_TRACE_STAMP(trace, CFL_TRACE_SENT);
 
-        *received_pkt = danp_recv_packet(sock, timeout);
+        *received_pkt = transport->recv_from(sock, &src_node, &src_port, timeout);
         if (NULL == *received_pkt)
         {
-            LOG_ERR("Failed to receive status packet");
+            CFL_LOG_RATELIMITED(LOG_ERR, "Failed to receive status packet");
             ret = -4; // Receive failed
             break;
         }
+#if defined(CONFIG_CFL_LATENCY)
+        *recv_us = cfl_latency_now_us();
+#else
+        (void)sent_us;
+        (void)recv_us;
+#endif
+        CFL_TRACE_STAMP(trace, CFL_TRACE_RECV);
 
         ret = (size_t)1; // Actual packet received
 
@@ -84,9 +143,9 @@ static int32_t tmtc_transaction_packet(
         break;
     }
 
-    if (is_sock_created && sock)
+    if (is_sock_created)
     {
-        danp_close(sock);
+        transport->close(sock);
     }
 
     return ret;
@@ -108,9 +167,13 @@ int32_t cfl_transaction(
     cfl_message_t *status_msg = NULL;
     cfl_message_t *rply_msg = NULL;
     cfl_message_t *received_msg = NULL;
-    uint32_t received_status = 0;
+    cfl_ext_status_t received_status = {0};
     uint16_t received_len = 0;
-    
+    uint64_t times_us[4] = {0};
+    cfl_trace_record_t *trace = CFL_TRACE_BEGIN(CFL_TRACE_KIND_TRANSACTION, dest_id);
+
+    CFL_TRACE_SET_CMD(trace, cmd_id);
+
     for (;;)
     {
         rqst_pkt = danp_buffer_get();
@@ -124,18 +187,46 @@ int32_t cfl_transaction(
         rqst_msg->sync = CFL_SYNC_WORD;
         rqst_msg->version = CFL_VERSION;
         rqst_msg->flags = CFL_F_RQST;
+#if defined(CONFIG_CFL_LATENCY)
+        /* Asks for the serving times, the request then goes out in the full format */
+        rqst_msg->flags |= CFL_EXT_F_TIMESTAMP;
+#endif
         rqst_msg->cmd_id = cmd_id;
-        rqst_msg->seq = 0;
+        rqst_msg->seq = cfl_next_seq();
         rqst_msg->length = request_len;
         memcpy(rqst_msg->data, request, rqst_msg->length);
         rqst_pkt->length = CFL_HEADER_SIZE + rqst_msg->length;
-
-        ret = tmtc_transaction_packet(dest_id, CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT, rqst_pkt, &received_pkt, timeout);
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+        if (cfl_compact_peer_enabled(dest_id))
+        {
+            (void)cfl_compact_pack(rqst_pkt);
+        }
+#endif
+        CFL_TRACE_STAMP(trace, CFL_TRACE_ALLOC);
+
+        ret = tmtc_transaction_packet(
+            dest_id,
+            CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT,
+            rqst_pkt,
+            &received_pkt,
+            timeout,
+            trace,
+            &times_us[0],
+            &times_us[3]);
         if (ret < 0)
         {
             break;
         }
 
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+        if (cfl_compact_expand(received_pkt) < 0)
+        {
+            LOG_ERR("Malformed compact header in response");
+            ret = -2;
+            break;
+        }
+#endif
+
         received_msg = (cfl_message_t *)received_pkt->payload;
         received_len = received_pkt->length;
 
@@ -146,24 +237,43 @@ int32_t cfl_transaction(
             break;
         }
 
+#if defined(CONFIG_CFL_LATENCY)
+        /* Responders that predate timestamps answer without them */
+        ret = cfl_latency_strip(received_pkt, &times_us[1], &times_us[2]);
+        if (ret < 0)
+        {
+            LOG_ERR("Malformed timestamps in response");
+            ret = -2;
+            break;
+        }
+        if (ret > 0)
+        {
+            cfl_latency_record(dest_id, times_us[0], times_us[1], times_us[2], times_us[3]);
+        }
+#endif
+
         if (received_msg->flags & CFL_F_NACK)
         {
             status_msg = received_msg;
-            memcpy(&received_status, &status_msg->data[0], sizeof(received_status));
-            LOG_ERR("Received NACK: [cmd_id]=%d [status]=%d", received_msg->cmd_id, received_status);
+            (void)cfl_ext_status_decode(status_msg->data, status_msg->length, &received_status);
+            CFL_LOG_RATELIMITED(
+                LOG_ERR,
+                "Received NACK: [cmd_id]=%d [status]=%d",
+                received_msg->cmd_id,
+                received_status.status);
             ret = -5;
             break;
         }
         else if (received_msg->flags & CFL_F_ACK)
         {
-            LOG_INF("Received ACK: [cmd_id]=%d", received_msg->cmd_id);
+            LOG_DBG("Received ACK: [cmd_id]=%d", received_msg->cmd_id);
             status_msg = received_msg;
             ret = 0;
             break;
         }
         else if (received_msg->flags & CFL_F_RPLY)
         {
-            LOG_INF("Received reply: [cmd_id]=%d", received_msg->cmd_id);
+            LOG_DBG("Received reply: [cmd_id]=%d", received_msg->cmd_id);
             rply_msg = received_msg;
         }
         else
@@ -204,5 +314,8 @@ int32_t cfl_transaction(
         danp_buffer_free(received_pkt);
     }
 
+    CFL_TRACE_STAMP(trace, CFL_TRACE_DONE);
+    CFL_TRACE_END(trace);
+
     return ret;
 }
@@ -0,0 +1,299 @@
+/* cfl_budget.c - Per-command handler execution budgets */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl_log.h"
+#include "cfl/services/cfl_budget.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define BUDGET_CMD_COUNT (CONFIG_CFL_BUDGET_CMDS)
+
+/* Types */
+
+typedef struct budget_entry_s
+{
+    bool used;
+    bool quarantined;
+    uint16_t cmd_id;
+    uint32_t budget_us;
+    uint32_t budget_cycles;
+    uint32_t calls;
+    uint64_t total_cycles;
+    uint32_t max_cycles;
+    uint32_t overruns;
+    uint32_t stalls;
+    uint32_t refused;
+    uint32_t strikes;
+    uint32_t quarantine_end_ms;
+} budget_entry_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static budget_entry_t entries[BUDGET_CMD_COUNT];
+
+/* Functions */
+
+static void entry_set_budget(budget_entry_t *entry, uint32_t budget_us)
+{
+    entry->budget_us = (budget_us != 0) ? budget_us : CONFIG_CFL_BUDGET_DEFAULT_US;
+    entry->budget_cycles = k_us_to_cyc_ceil32(entry->budget_us);
+}
+
+static budget_entry_t *find_entry(uint16_t cmd_id)
+{
+    for (size_t i = 0; i < BUDGET_CMD_COUNT; i++)
+    {
+        if (entries[i].used && entries[i].cmd_id == cmd_id)
+        {
+            return &entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Commands are tracked from their first invocation, later ones go unmeasured when full */
+static budget_entry_t *find_or_add_entry(uint16_t cmd_id)
+{
+    budget_entry_t *entry = find_entry(cmd_id);
+
+    for (size_t i = 0; entry == NULL && i < BUDGET_CMD_COUNT; i++)
+    {
+        if (!entries[i].used)
+        {
+            entry = &entries[i];
+            memset(entry, 0, sizeof(*entry));
+            entry->used = true;
+            entry->cmd_id = cmd_id;
+            entry_set_budget(entry, 0);
+        }
+    }
+
+    return entry;
+}
+
+#if defined(CONFIG_CFL_BUDGET_WATCHDOG)
+/* Runs in ISR context while the handler is still executing */
+static void watchdog_expired(struct k_timer *timer)
+{
+    cfl_budget_watch_t *watch = (cfl_budget_watch_t *)k_timer_user_data_get(timer);
+    budget_entry_t *entry = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    entry = find_entry(watch->cmd_id);
+    if (entry != NULL)
+    {
+        entry->stalls++;
+    }
+
+    k_spin_unlock(&lock, key);
+
+    LOG_WRN("Handler of command %d still running past its budget", watch->cmd_id);
+}
+#endif
+
+int32_t cfl_budget_begin(cfl_budget_watch_t *watch, uint16_t cmd_id)
+{
+    budget_entry_t *entry = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    watch->cmd_id = cmd_id;
+    watch->budget_cycles = 0;
+
+    entry = find_or_add_entry(cmd_id);
+    if (entry != NULL)
+    {
+        if (entry->quarantined &&
+            (int32_t)(k_uptime_get_32() - entry->quarantine_end_ms) < 0)
+        {
+            entry->refused++;
+            k_spin_unlock(&lock, key);
+            return -EBUSY;
+        }
+
+        entry->quarantined = false;
+        watch->budget_cycles = entry->budget_cycles;
+    }
+
+    k_spin_unlock(&lock, key);
+
+#if defined(CONFIG_CFL_BUDGET_WATCHDOG)
+    if (watch->budget_cycles != 0)
+    {
+        k_timer_init(&watch->timer, watchdog_expired, NULL);
+        k_timer_user_data_set(&watch->timer, watch);
+        k_timer_start(&watch->timer, K_CYC(watch->budget_cycles), K_NO_WAIT);
+    }
+#endif
+
+    watch->start = k_cycle_get_32();
+
+    return 0;
+}
+
+bool cfl_budget_end(cfl_budget_watch_t *watch)
+{
+    uint32_t cycles = k_cycle_get_32() - watch->start;
+    bool overrun = (watch->budget_cycles != 0) && (cycles > watch->budget_cycles);
+    bool quarantined = false;
+    budget_entry_t *entry = NULL;
+    k_spinlock_key_t key;
+
+#if defined(CONFIG_CFL_BUDGET_WATCHDOG)
+    if (watch->budget_cycles != 0)
+    {
+        k_timer_stop(&watch->timer);
+    }
+#endif
+
+    key = k_spin_lock(&lock);
+    entry = find_entry(watch->cmd_id);
+    if (entry != NULL)
+    {
+        entry->calls++;
+        entry->total_cycles += cycles;
+        if (cycles > entry->max_cycles)
+        {
+            entry->max_cycles = cycles;
+        }
+
+        if (!overrun)
+        {
+            entry->strikes = 0;
+        }
+        else
+        {
+            entry->overruns++;
+            entry->strikes++;
+            if (CONFIG_CFL_BUDGET_STRIKES > 0 && entry->strikes >= CONFIG_CFL_BUDGET_STRIKES)
+            {
+                entry->quarantined = true;
+                entry->quarantine_end_ms = k_uptime_get_32() + CONFIG_CFL_BUDGET_QUARANTINE_MS;
+                entry->strikes = 0;
+                quarantined = true;
+            }
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    if (overrun)
+    {
+        CFL_LOG_RATELIMITED(
+            LOG_WRN,
+            "Handler of command %d took %u us, over its budget",
+            watch->cmd_id,
+            k_cyc_to_us_floor32(cycles));
+    }
+
+    if (quarantined)
+    {
+        LOG_ERR(
+            "Command %d quarantined for %d ms after %d overruns in a row",
+            watch->cmd_id,
+            CONFIG_CFL_BUDGET_QUARANTINE_MS,
+            CONFIG_CFL_BUDGET_STRIKES);
+    }
+
+    return overrun;
+}
+
+int32_t cfl_budget_set(uint16_t cmd_id, uint32_t budget_us)
+{
+    int32_t ret = 0;
+    budget_entry_t *entry = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    entry = find_or_add_entry(cmd_id);
+    if (entry == NULL)
+    {
+        ret = -ENOMEM;
+    }
+    else
+    {
+        entry_set_budget(entry, budget_us);
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (ret < 0)
+    {
+        LOG_ERR("No free budget slot for command %d", cmd_id);
+    }
+
+    return ret;
+}
+
+int32_t cfl_budget_get(size_t index, cfl_budget_stats_t *stats)
+{
+    int32_t ret = 0;
+    const budget_entry_t *entry = NULL;
+    k_spinlock_key_t key;
+
+    if (stats == NULL || index >= BUDGET_CMD_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    entry = &entries[index];
+    if (!entry->used)
+    {
+        ret = -ENOENT;
+    }
+    else
+    {
+        stats->cmd_id = entry->cmd_id;
+        stats->budget_us = (entry->budget_cycles != 0) ? entry->budget_us : 0;
+        stats->calls = entry->calls;
+        stats->avg_cycles =
+            (entry->calls != 0) ? (uint32_t)(entry->total_cycles / entry->calls) : 0;
+        stats->max_cycles = entry->max_cycles;
+        stats->overruns = entry->overruns;
+        stats->stalls = entry->stalls;
+        stats->refused = entry->refused;
+        stats->quarantined =
+            entry->quarantined && (int32_t)(k_uptime_get_32() - entry->quarantine_end_ms) < 0;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+void cfl_budget_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (size_t i = 0; i < BUDGET_CMD_COUNT; i++)
+    {
+        budget_entry_t *entry = &entries[i];
+
+        entry->quarantined = false;
+        entry->calls = 0;
+        entry->total_cycles = 0;
+        entry->max_cycles = 0;
+        entry->overruns = 0;
+        entry->stalls = 0;
+        entry->refused = 0;
+        entry->strikes = 0;
+    }
+
+    k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,93 @@
+/* cfl_ext_int.h - Handlers of the reserved CFL commands */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_EXT_INT_H
+#define INC_CFL_EXT_INT_H
+
+/* Includes */
+
+#include <stdint.h>
+
+#include "zephyr/tmtc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+/**
+ * Same contract as a tmtc handler, plus the source node since reserved commands
+ * usually act on behalf of the sender.
+ */
+typedef int32_t (*cfl_ext_handler_t)(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+
+typedef struct cfl_ext_entry_s
+{
+    uint16_t cmd_id;
+    cfl_ext_handler_t handler;
+} cfl_ext_entry_t;
+
+/* External Declarations */
+
+#if defined(CONFIG_CFL_PUBSUB)
+extern int32_t cfl_pubsub_handle_subscribe(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+
+extern int32_t cfl_pubsub_handle_unsubscribe(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+#endif
+
+#if defined(CONFIG_CFL_SCHED)
+extern int32_t cfl_sched_handle_schedule(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+
+extern int32_t cfl_sched_handle_cancel(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+#endif
+
+#if defined(CONFIG_CFL_XFER)
+extern int32_t cfl_xfer_handle_open(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+
+extern int32_t cfl_xfer_handle_data(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+
+extern int32_t cfl_xfer_handle_status(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+
+extern int32_t cfl_xfer_handle_close(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_EXT_INT_H */
@@ -0,0 +1,454 @@
+/* cfl_pubsub.c - Telemetry subscriptions with server-side sampling */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_ext.h"
+#include "cfl/cfl_ext_codec.h"
+#include "cfl/cfl_thread.h"
+#include "cfl/cfl_utilities.h"
+#include "cfl/services/cfl_pubsub.h"
+#include "cfl/services/cfl_service_danp.h"
+#include "cfl_log.h"
+#include "danp/danp_buffer.h"
+#include "services/cfl_ext_int.h"
+#include "services/cfl_service_danp_int.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define PUBSUB_SUB_COUNT (CONFIG_CFL_PUBSUB_MAX_SUBS)
+
+/* Types */
+
+typedef struct pubsub_entry_s
+{
+    bool used;
+    uint16_t node;
+    uint16_t port;
+    uint16_t cmd_id;
+    uint32_t period_ms;
+    uint32_t next_ms;
+    uint32_t renewed_ms;
+    uint32_t pushes;
+    uint32_t failures;
+} pubsub_entry_t;
+
+typedef struct pubsub_dest_s
+{
+    size_t index;
+    uint16_t node;
+    uint16_t port;
+} pubsub_dest_t;
+
+/* Forward Declarations */
+
+static void publish_handler(struct k_work *work);
+
+/* Variables */
+
+static struct k_spinlock lock;
+static pubsub_entry_t subs[PUBSUB_SUB_COUNT];
+static K_WORK_DELAYABLE_DEFINE(publish_work, publish_handler);
+
+/* Functions */
+
+static bool lapsed(const pubsub_entry_t *sub, uint32_t now)
+{
+    return CONFIG_CFL_PUBSUB_LEASE_MS != 0 &&
+           (now - sub->renewed_ms) >= (uint32_t)CONFIG_CFL_PUBSUB_LEASE_MS;
+}
+
+static pubsub_entry_t *find_sub(uint16_t node, uint16_t port, uint16_t cmd_id)
+{
+    for (size_t i = 0; i < PUBSUB_SUB_COUNT; i++)
+    {
+        if (subs[i].used && subs[i].node == node && subs[i].port == port &&
+            subs[i].cmd_id == cmd_id)
+        {
+            return &subs[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void reschedule(void)
+{
+    bool any = false;
+    int32_t delay = INT32_MAX;
+    uint32_t now = k_uptime_get_32();
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (size_t i = 0; i < PUBSUB_SUB_COUNT; i++)
+    {
+        if (subs[i].used)
+        {
+            any = true;
+            delay = MIN(delay, (int32_t)(subs[i].next_ms - now));
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (any)
+    {
+        (void)k_work_reschedule_for_queue(
+            cfl_thread_workq(), &publish_work, K_MSEC(MAX(delay, 0)));
+    }
+}
+
+/* Pick one due command and every subscriber it is due for, advancing their deadlines */
+static size_t collect_due(uint32_t now, uint16_t *cmd_id, pubsub_dest_t *dests)
+{
+    size_t count = 0;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (size_t i = 0; i < PUBSUB_SUB_COUNT; i++)
+    {
+        pubsub_entry_t *sub = &subs[i];
+
+        if (!sub->used || (int32_t)(now - sub->next_ms) < 0)
+        {
+            continue;
+        }
+
+        /* Checked when due, a lapsed entry is dropped before its next push */
+        if (lapsed(sub, now))
+        {
+            LOG_DBG("Subscription of node %d to %d lapsed", sub->node, sub->cmd_id);
+            sub->used = false;
+            continue;
+        }
+
+        if (count == 0)
+        {
+            *cmd_id = sub->cmd_id;
+        }
+        else if (sub->cmd_id != *cmd_id)
+        {
+            continue;
+        }
+
+        dests[count].index = i;
+        dests[count].node = sub->node;
+        dests[count].port = sub->port;
+        count++;
+
+        sub->next_ms += sub->period_ms;
+        /* Skip missed periods instead of bursting to catch up */
+        if ((int32_t)(now - sub->next_ms) >= 0)
+        {
+            sub->next_ms = now + sub->period_ms;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+
+    return count;
+}
+
+static void account(const pubsub_dest_t *dest, uint16_t cmd_id, bool ok)
+{
+    pubsub_entry_t *sub = &subs[dest->index];
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    /* The slot may have been reused while the sample was taken */
+    if (sub->used && sub->node == dest->node && sub->cmd_id == cmd_id)
+    {
+        if (ok)
+        {
+            sub->pushes++;
+        }
+        else
+        {
+            sub->failures++;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+/* Run the telemetry handler as if a request without data had been received */
+static int32_t sample(uint16_t cmd_id, danp_packet_t **sample_pkt)
+{
+    cfl_message_t rqst_msg = {0};
+
+    rqst_msg.sync = CFL_SYNC_WORD;
+    rqst_msg.version = CFL_VERSION;
+    rqst_msg.flags = CFL_F_RQST;
+    rqst_msg.cmd_id = cmd_id;
+
+    return cfl_service_danp_execute(0, &rqst_msg, sample_pkt);
+}
+
+static void publish(uint16_t cmd_id, const pubsub_dest_t *dests, size_t count)
+{
+    int32_t ret = 0;
+    danp_packet_t *sample_pkt = NULL;
+    const uint8_t *data = NULL;
+    uint16_t data_len = 0;
+
+    ret = sample(cmd_id, &sample_pkt);
+    if (ret < 0)
+    {
+        CFL_LOG_RATELIMITED(LOG_ERR, "Sampling command %d failed: %d", cmd_id, ret);
+        for (size_t i = 0; i < count; i++)
+        {
+            account(&dests[i], cmd_id, false);
+        }
+        return;
+    }
+
+    if (sample_pkt != NULL)
+    {
+        data = &sample_pkt->payload[CFL_HEADER_SIZE];
+        data_len = sample_pkt->length - CFL_HEADER_SIZE;
+    }
+
+    /* One sample, fanned out to every due subscriber */
+    for (size_t i = 0; i < count; i++)
+    {
+        ret = cfl_service_danp_send_push(dests[i].node, dests[i].port, cmd_id, data, data_len);
+        account(&dests[i], cmd_id, ret >= 0);
+    }
+
+    if (sample_pkt != NULL)
+    {
+        danp_buffer_free(sample_pkt);
+    }
+}
+
+static void publish_handler(struct k_work *work)
+{
+    pubsub_dest_t dests[PUBSUB_SUB_COUNT];
+    uint16_t cmd_id = 0;
+    size_t count = 0;
+    uint32_t now = k_uptime_get_32();
+
+    ARG_UNUSED(work);
+
+    for (;;)
+    {
+        count = collect_due(now, &cmd_id, dests);
+        if (count == 0)
+        {
+            break;
+        }
+        publish(cmd_id, dests, count);
+    }
+
+    reschedule();
+}
+
+int32_t cfl_pubsub_handle_subscribe(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply)
+{
+    int32_t ret = 0;
+    cfl_ext_subscribe_t req = {0};
+    pubsub_entry_t *sub = NULL;
+    uint16_t cmd_id = 0;
+    uint16_t port = 0;
+    uint32_t period_ms = 0;
+    uint32_t now = 0;
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(rply);
+
+    ret = cfl_ext_subscribe_decode(rqst->data + rqst->hdr_len, rqst->len - rqst->hdr_len, &req);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    cmd_id = req.cmd_id;
+    port = req.port;
+    period_ms = req.period_ms;
+
+    if (port == 0)
+    {
+        port = CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT;
+    }
+
+    /* Same lookup as the samples will go through, runtime handlers included */
+    if (cmd_id >= CFL_EXT_CMD_BASE || !cfl_service_danp_has_handler(cmd_id))
+    {
+        return -ENOENT;
+    }
+
+    if (period_ms < CONFIG_CFL_PUBSUB_MIN_PERIOD_MS)
+    {
+        return -EINVAL;
+    }
+
+    now = k_uptime_get_32();
+    key = k_spin_lock(&lock);
+
+    sub = find_sub(src_node, port, cmd_id);
+    for (size_t i = 0; sub == NULL && i < PUBSUB_SUB_COUNT; i++)
+    {
+        if (!subs[i].used || lapsed(&subs[i], now))
+        {
+            sub = &subs[i];
+            memset(sub, 0, sizeof(*sub));
+            sub->used = true;
+            sub->node = src_node;
+            sub->port = port;
+            sub->cmd_id = cmd_id;
+        }
+    }
+
+    if (sub == NULL)
+    {
+        ret = -ENOMEM;
+    }
+    else
+    {
+        sub->period_ms = period_ms;
+        sub->next_ms = now;
+        sub->renewed_ms = now;
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (ret < 0)
+    {
+        LOG_ERR("Subscriber table full, node %d command %d rejected", src_node, cmd_id);
+        return ret;
+    }
+
+    LOG_DBG("Node %d subscribed to %d every %u ms", src_node, cmd_id, period_ms);
+    reschedule();
+
+    return 0;
+}
+
+int32_t cfl_pubsub_handle_unsubscribe(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply)
+{
+    int32_t ret = 0;
+    cfl_ext_unsubscribe_t req = {0};
+    pubsub_entry_t *sub = NULL;
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(rply);
+
+    ret = cfl_ext_unsubscribe_decode(rqst->data + rqst->hdr_len, rqst->len - rqst->hdr_len, &req);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (req.port == 0)
+    {
+        req.port = CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT;
+    }
+
+    ret = -ENOENT;
+    key = k_spin_lock(&lock);
+    sub = find_sub(src_node, req.port, req.cmd_id);
+    if (sub != NULL)
+    {
+        sub->used = false;
+        ret = 0;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+int32_t cfl_pubsub_subscribe(
+    uint16_t dest_id,
+    uint16_t cmd_id,
+    uint32_t period_ms,
+    uint32_t timeout)
+{
+    int32_t ret = 0;
+    uint8_t payload[CFL_EXT_SUBSCRIBE_SIZE];
+    const cfl_ext_subscribe_t req = {
+        .cmd_id = cmd_id,
+        .port = CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT,
+        .period_ms = period_ms,
+    };
+
+    (void)cfl_ext_subscribe_encode(payload, sizeof(payload), &req);
+
+    ret = cfl_transaction(
+        dest_id, CFL_EXT_CMD_SUBSCRIBE, payload, sizeof(payload), NULL, 0, timeout);
+
+    return (ret < 0) ? ret : 0;
+}
+
+int32_t cfl_pubsub_unsubscribe(uint16_t dest_id, uint16_t cmd_id, uint32_t timeout)
+{
+    int32_t ret = 0;
+    uint8_t payload[CFL_EXT_UNSUBSCRIBE_SIZE];
+    const cfl_ext_unsubscribe_t req = {
+        .cmd_id = cmd_id,
+        .port = CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT,
+    };
+
+    (void)cfl_ext_unsubscribe_encode(payload, sizeof(payload), &req);
+
+    ret = cfl_transaction(
+        dest_id, CFL_EXT_CMD_UNSUBSCRIBE, payload, sizeof(payload), NULL, 0, timeout);
+
+    return (ret < 0) ? ret : 0;
+}
+
+int32_t cfl_pubsub_get(size_t index, cfl_pubsub_stats_t *stats)
+{
+    int32_t ret = 0;
+    k_spinlock_key_t key;
+
+    if (stats == NULL || index >= PUBSUB_SUB_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    if (!subs[index].used)
+    {
+        ret = -ENOENT;
+    }
+    else
+    {
+        stats->node = subs[index].node;
+        stats->port = subs[index].port;
+        stats->cmd_id = subs[index].cmd_id;
+        stats->period_ms = subs[index].period_ms;
+        stats->pushes = subs[index].pushes;
+        stats->failures = subs[index].failures;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+void cfl_pubsub_clear(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    memset(subs, 0, sizeof(subs));
+
+    k_spin_unlock(&lock, key);
+
+    (void)k_work_cancel_delayable(&publish_work);
+}
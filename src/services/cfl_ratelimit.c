@@ -0,0 +1,313 @@
+/* cfl_ratelimit.c - Per-source and per-command rate limiting */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/services/cfl_ratelimit.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+/* Tokens are kept in thousandths so refill works in whole milliseconds */
+#define RATELIMIT_TOKEN_SCALE (1000U)
+
+#define RATELIMIT_NODE_COUNT (CONFIG_CFL_SERVICE_RATE_LIMIT_NODES)
+#define RATELIMIT_CMD_COUNT  (CONFIG_CFL_SERVICE_RATE_LIMIT_CMDS)
+
+/* Types */
+
+typedef struct ratelimit_bucket_s
+{
+    bool used;
+    uint16_t id;
+    uint32_t rate;
+    uint32_t burst;
+    uint32_t tokens;
+    uint32_t last_ms;
+    uint32_t passed;
+    uint32_t limited;
+} ratelimit_bucket_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static ratelimit_bucket_t node_buckets[RATELIMIT_NODE_COUNT];
+#if RATELIMIT_CMD_COUNT > 0
+static ratelimit_bucket_t cmd_buckets[RATELIMIT_CMD_COUNT];
+#endif
+
+/* Functions */
+
+static void bucket_init(
+    ratelimit_bucket_t *bucket,
+    uint16_t id,
+    uint32_t rate,
+    uint32_t burst,
+    uint32_t now)
+{
+    memset(bucket, 0, sizeof(*bucket));
+    bucket->used = true;
+    bucket->id = id;
+    bucket->rate = rate;
+    bucket->burst = burst;
+    bucket->tokens = burst * RATELIMIT_TOKEN_SCALE;
+    bucket->last_ms = now;
+}
+
+static void bucket_refill(ratelimit_bucket_t *bucket, uint32_t now)
+{
+    uint32_t capacity = bucket->burst * RATELIMIT_TOKEN_SCALE;
+    uint32_t elapsed = now - bucket->last_ms;
+
+    bucket->last_ms = now;
+
+    if (bucket->rate == 0)
+    {
+        bucket->tokens = capacity;
+        return;
+    }
+
+    /* Clamp first so elapsed * rate cannot overflow after long idle periods */
+    if (elapsed >= (capacity / bucket->rate) + 1)
+    {
+        bucket->tokens = capacity;
+        return;
+    }
+
+    bucket->tokens += elapsed * bucket->rate;
+    if (bucket->tokens > capacity)
+    {
+        bucket->tokens = capacity;
+    }
+}
+
+/* Refills the bucket, counts a refusal if it has no token left */
+static bool bucket_check(ratelimit_bucket_t *bucket, uint32_t now)
+{
+    bucket_refill(bucket, now);
+
+    if (bucket->tokens < RATELIMIT_TOKEN_SCALE)
+    {
+        bucket->limited++;
+        return false;
+    }
+
+    return true;
+}
+
+static void bucket_take(ratelimit_bucket_t *bucket)
+{
+    bucket->tokens -= RATELIMIT_TOKEN_SCALE;
+    bucket->passed++;
+}
+
+static ratelimit_bucket_t *find_node_bucket(uint16_t src_node, uint32_t now)
+{
+    ratelimit_bucket_t *victim = &node_buckets[0];
+
+    for (size_t i = 0; i < RATELIMIT_NODE_COUNT; i++)
+    {
+        ratelimit_bucket_t *bucket = &node_buckets[i];
+
+        if (bucket->used && bucket->id == src_node)
+        {
+            return bucket;
+        }
+
+        /* Prefer a free slot, otherwise evict the least recently seen node */
+        if (!bucket->used)
+        {
+            if (victim->used)
+            {
+                victim = bucket;
+            }
+        }
+        else if (victim->used && (int32_t)(bucket->last_ms - victim->last_ms) < 0)
+        {
+            victim = bucket;
+        }
+    }
+
+    bucket_init(
+        victim,
+        src_node,
+        CONFIG_CFL_SERVICE_RATE_LIMIT_RATE,
+        CONFIG_CFL_SERVICE_RATE_LIMIT_BURST,
+        now);
+    return victim;
+}
+
+#if RATELIMIT_CMD_COUNT > 0
+static ratelimit_bucket_t *find_cmd_bucket(uint16_t cmd_id)
+{
+    for (size_t i = 0; i < RATELIMIT_CMD_COUNT; i++)
+    {
+        if (cmd_buckets[i].used && cmd_buckets[i].id == cmd_id)
+        {
+            return &cmd_buckets[i];
+        }
+    }
+
+    return NULL;
+}
+#endif
+
+static int32_t get_stats(
+    const ratelimit_bucket_t *table,
+    size_t count,
+    size_t index,
+    cfl_ratelimit_stats_t *stats)
+{
+    int32_t ret = 0;
+    k_spinlock_key_t key;
+
+    if (stats == NULL || index >= count)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    if (!table[index].used)
+    {
+        ret = -ENOENT;
+    }
+    else
+    {
+        stats->id = table[index].id;
+        stats->tokens = table[index].tokens / RATELIMIT_TOKEN_SCALE;
+        stats->passed = table[index].passed;
+        stats->limited = table[index].limited;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+bool cfl_ratelimit_allow(uint16_t src_node, uint16_t cmd_id)
+{
+    bool allowed = false;
+    uint32_t now = k_uptime_get_32();
+    ratelimit_bucket_t *node_bucket = NULL;
+    ratelimit_bucket_t *cmd_bucket = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    /* The node first: a flooding node must not drain the command bucket shared with others */
+    node_bucket = find_node_bucket(src_node, now);
+#if RATELIMIT_CMD_COUNT > 0
+    cmd_bucket = find_cmd_bucket(cmd_id);
+#else
+    (void)cmd_id;
+#endif
+
+    if (bucket_check(node_bucket, now) && (cmd_bucket == NULL || bucket_check(cmd_bucket, now)))
+    {
+        /* Tokens are only taken once both buckets allow the message */
+        bucket_take(node_bucket);
+        if (cmd_bucket != NULL)
+        {
+            bucket_take(cmd_bucket);
+        }
+        allowed = true;
+    }
+
+    k_spin_unlock(&lock, key);
+
+    return allowed;
+}
+
+int32_t cfl_ratelimit_set_cmd(uint16_t cmd_id, uint32_t rate, uint32_t burst)
+{
+#if RATELIMIT_CMD_COUNT > 0
+    int32_t ret = 0;
+    ratelimit_bucket_t *bucket = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    bucket = find_cmd_bucket(cmd_id);
+    if (rate == 0)
+    {
+        if (bucket != NULL)
+        {
+            bucket->used = false;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; bucket == NULL && i < RATELIMIT_CMD_COUNT; i++)
+        {
+            if (!cmd_buckets[i].used)
+            {
+                bucket = &cmd_buckets[i];
+            }
+        }
+
+        if (bucket == NULL)
+        {
+            ret = -ENOMEM;
+        }
+        else
+        {
+            bucket_init(bucket, cmd_id, rate, burst, k_uptime_get_32());
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (ret < 0)
+    {
+        LOG_ERR("No free rate limit slot for command %d", cmd_id);
+    }
+
+    return ret;
+#else
+    (void)cmd_id;
+    (void)rate;
+    (void)burst;
+    return -ENOTSUP;
+#endif
+}
+
+int32_t cfl_ratelimit_get_node(size_t index, cfl_ratelimit_stats_t *stats)
+{
+    return get_stats(node_buckets, RATELIMIT_NODE_COUNT, index, stats);
+}
+
+int32_t cfl_ratelimit_get_cmd(size_t index, cfl_ratelimit_stats_t *stats)
+{
+#if RATELIMIT_CMD_COUNT > 0
+    return get_stats(cmd_buckets, RATELIMIT_CMD_COUNT, index, stats);
+#else
+    (void)index;
+    (void)stats;
+    return -EINVAL;
+#endif
+}
+
+void cfl_ratelimit_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    memset(node_buckets, 0, sizeof(node_buckets));
+#if RATELIMIT_CMD_COUNT > 0
+    for (size_t i = 0; i < RATELIMIT_CMD_COUNT; i++)
+    {
+        cmd_buckets[i].passed = 0;
+        cmd_buckets[i].limited = 0;
+    }
+#endif
+
+    k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,265 @@
+/* cfl_registry.c - Runtime command handler registration */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl_ext.h"
+#include "cfl/services/cfl_registry.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define REGISTRY_MAX (CONFIG_CFL_REGISTRY_MAX)
+
+/* Types */
+
+/*
+ * Two copies of the table. Lookups read the published one and count themselves
+ * in its readers; updates rewrite the other copy, publish it, then wait for
+ * the readers of the old one to leave before it may be rewritten in turn.
+ */
+typedef struct registry_table_s
+{
+    size_t count;
+    cfl_registry_entry_t entries[REGISTRY_MAX];
+} registry_table_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static registry_table_t tables[2];
+static atomic_t readers[2];
+static atomic_t published = ATOMIC_INIT(0);
+static atomic_t retries = ATOMIC_INIT(0);
+
+/* Serializes updates, never taken on the dispatch path */
+static K_MUTEX_DEFINE(update_lock);
+static uint32_t version;
+static uint32_t waits_ms;
+
+/* Functions */
+
+/* Index of the first entry with an ID not below cmd_id */
+static size_t lower_bound(const registry_table_t *table, uint16_t cmd_id)
+{
+    size_t low = 0;
+    size_t high = table->count;
+    size_t mid = 0;
+
+    while (low < high)
+    {
+        mid = low + ((high - low) / 2);
+        if (table->entries[mid].cmd_id < cmd_id)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/* Pins the published table, returns its index */
+static uint32_t enter(void)
+{
+    uint32_t index = 0;
+
+    for (;;)
+    {
+        index = (uint32_t)atomic_get(&published);
+        (void)atomic_inc(&readers[index]);
+
+        /* Counted before the check, an update seeing no readers cannot miss this one */
+        if ((uint32_t)atomic_get(&published) == index)
+        {
+            return index;
+        }
+
+        (void)atomic_dec(&readers[index]);
+        (void)atomic_inc(&retries);
+    }
+}
+
+static void wait_readers(uint32_t table)
+{
+    int64_t start = k_uptime_get();
+
+    while (atomic_get(&readers[table]) != 0)
+    {
+        k_sleep(K_MSEC(1));
+    }
+
+    waits_ms += (uint32_t)(k_uptime_get() - start);
+}
+
+/* Publishes the spare table, to be called with the update lock held */
+static void publish(uint32_t next)
+{
+    uint32_t current = 1U - next;
+
+    (void)atomic_set(&published, (atomic_val_t)next);
+    version++;
+
+    /* Lookups still reading the old table finish before it is reused */
+    wait_readers(current);
+}
+
+int32_t cfl_registry_register(uint16_t cmd_id, cfl_registry_handler_t handler, void *ctx)
+{
+    const registry_table_t *current = NULL;
+    registry_table_t *next = NULL;
+    uint32_t next_index = 0;
+    size_t pos = 0;
+    int32_t ret = 0;
+
+    if (handler == NULL || cmd_id >= CFL_EXT_CMD_BASE)
+    {
+        return -EINVAL;
+    }
+
+    (void)k_mutex_lock(&update_lock, K_FOREVER);
+
+    for (;;)
+    {
+        next_index = 1U - (uint32_t)atomic_get(&published);
+        current = &tables[1U - next_index];
+        next = &tables[next_index];
+
+        pos = lower_bound(current, cmd_id);
+        if (pos < current->count && current->entries[pos].cmd_id == cmd_id)
+        {
+            ret = -EEXIST;
+            break;
+        }
+
+        if (current->count >= REGISTRY_MAX)
+        {
+            ret = -ENOMEM;
+            break;
+        }
+
+        memcpy(next->entries, current->entries, pos * sizeof(next->entries[0]));
+        next->entries[pos] = (cfl_registry_entry_t){
+            .cmd_id = cmd_id,
+            .handler = handler,
+            .ctx = ctx,
+        };
+        memcpy(
+            &next->entries[pos + 1],
+            &current->entries[pos],
+            (current->count - pos) * sizeof(next->entries[0]));
+        next->count = current->count + 1;
+
+        publish(next_index);
+        LOG_DBG("Registered handler for command %u", cmd_id);
+        break;
+    }
+
+    (void)k_mutex_unlock(&update_lock);
+
+    return ret;
+}
+
+int32_t cfl_registry_unregister(uint16_t cmd_id)
+{
+    const registry_table_t *current = NULL;
+    registry_table_t *next = NULL;
+    uint32_t next_index = 0;
+    size_t pos = 0;
+    int32_t ret = 0;
+
+    (void)k_mutex_lock(&update_lock, K_FOREVER);
+
+    for (;;)
+    {
+        next_index = 1U - (uint32_t)atomic_get(&published);
+        current = &tables[1U - next_index];
+        next = &tables[next_index];
+
+        pos = lower_bound(current, cmd_id);
+        if (pos >= current->count || current->entries[pos].cmd_id != cmd_id)
+        {
+            ret = -ENOENT;
+            break;
+        }
+
+        memcpy(next->entries, current->entries, pos * sizeof(next->entries[0]));
+        memcpy(
+            &next->entries[pos],
+            &current->entries[pos + 1],
+            (current->count - pos - 1) * sizeof(next->entries[0]));
+        next->count = current->count - 1;
+
+        publish(next_index);
+        LOG_DBG("Unregistered handler for command %u", cmd_id);
+        break;
+    }
+
+    (void)k_mutex_unlock(&update_lock);
+
+    return ret;
+}
+
+int32_t cfl_registry_get(size_t index, cfl_registry_entry_t *entry)
+{
+    uint32_t ref = enter();
+    const registry_table_t *table = &tables[ref];
+    int32_t ret = -EINVAL;
+
+    if (index < table->count)
+    {
+        *entry = table->entries[index];
+        ret = 0;
+    }
+
+    (void)atomic_dec(&readers[ref]);
+
+    return ret;
+}
+
+void cfl_registry_get_stats(cfl_registry_stats_t *stats)
+{
+    (void)k_mutex_lock(&update_lock, K_FOREVER);
+    stats->entries = (uint32_t)tables[atomic_get(&published)].count;
+    stats->version = version;
+    stats->retries = (uint32_t)atomic_get(&retries);
+    stats->waits_ms = waits_ms;
+    (void)k_mutex_unlock(&update_lock);
+}
+
+const cfl_registry_entry_t *cfl_registry_acquire(uint16_t cmd_id, uint32_t *ref)
+{
+    uint32_t index = enter();
+    const registry_table_t *table = &tables[index];
+    size_t pos = lower_bound(table, cmd_id);
+
+    if (pos < table->count && table->entries[pos].cmd_id == cmd_id)
+    {
+        *ref = index;
+        return &table->entries[pos];
+    }
+
+    (void)atomic_dec(&readers[index]);
+    return NULL;
+}
+
+void cfl_registry_release(uint32_t ref)
+{
+    (void)atomic_dec(&readers[ref]);
+}
@@ -0,0 +1,314 @@
+/* cfl_router.c - Command range routing between nodes */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_compact.h"
+#include "cfl/cfl_utilities.h"
+#include "cfl/services/cfl_router.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define ROUTER_ROUTE_COUNT   (CONFIG_CFL_ROUTER_ROUTES)
+#define ROUTER_PENDING_COUNT (CONFIG_CFL_ROUTER_PENDING)
+
+#define ROUTER_REPLY_FLAGS (CFL_F_ACK | CFL_F_NACK | CFL_F_RPLY)
+
+/* Types */
+
+typedef struct router_route_entry_s
+{
+    bool used;
+    cfl_route_t route;
+} router_route_entry_t;
+
+/* A forwarded request waiting for its reply, keyed by next hop and router sequence */
+typedef struct router_pending_s
+{
+    bool used;
+    bool compact;
+    uint16_t src_node;
+    uint16_t src_port;
+    uint16_t src_seq;
+    uint16_t dst_node;
+    uint16_t seq;
+    uint16_t cmd_id;
+    uint32_t deadline_ms;
+} router_pending_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static router_route_entry_t routes[ROUTER_ROUTE_COUNT];
+static router_pending_t pending[ROUTER_PENDING_COUNT];
+static cfl_router_stats_t stats;
+
+/* Functions */
+
+static const cfl_route_t *find_route(uint16_t cmd_id)
+{
+    for (size_t i = 0; i < ROUTER_ROUTE_COUNT; i++)
+    {
+        if (routes[i].used && cmd_id >= routes[i].route.cmd_min &&
+            cmd_id <= routes[i].route.cmd_max)
+        {
+            return &routes[i].route;
+        }
+    }
+
+    return NULL;
+}
+
+/* Expired entries are reclaimed here instead of by a timer */
+static router_pending_t *alloc_pending(uint32_t now)
+{
+    router_pending_t *found = NULL;
+
+    for (size_t i = 0; i < ROUTER_PENDING_COUNT; i++)
+    {
+        router_pending_t *entry = &pending[i];
+
+        if (entry->used && (int32_t)(now - entry->deadline_ms) >= 0)
+        {
+            entry->used = false;
+            stats.expired++;
+            stats.pending--;
+        }
+
+        if (!entry->used && found == NULL)
+        {
+            found = entry;
+        }
+    }
+
+    return found;
+}
+
+static bool hop_compact(uint16_t node)
+{
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+    return cfl_compact_peer_enabled(node);
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+int32_t cfl_router_add(const cfl_route_t *route)
+{
+    int32_t ret = -ENOMEM;
+    k_spinlock_key_t key;
+
+    if (route == NULL || route->cmd_min > route->cmd_max)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    for (size_t i = 0; i < ROUTER_ROUTE_COUNT; i++)
+    {
+        if (!routes[i].used)
+        {
+            routes[i].used = true;
+            routes[i].route = *route;
+            ret = 0;
+            break;
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    if (ret < 0)
+    {
+        LOG_ERR("No free route slot for commands %d-%d", route->cmd_min, route->cmd_max);
+    }
+
+    return ret;
+}
+
+int32_t cfl_router_remove(uint16_t cmd_min, uint16_t cmd_max)
+{
+    int32_t ret = -ENOENT;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (size_t i = 0; i < ROUTER_ROUTE_COUNT; i++)
+    {
+        if (routes[i].used && routes[i].route.cmd_min == cmd_min &&
+            routes[i].route.cmd_max == cmd_max)
+        {
+            routes[i].used = false;
+            ret = 0;
+        }
+    }
+
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+int32_t cfl_router_get_route(size_t index, cfl_route_t *route)
+{
+    int32_t ret = 0;
+    k_spinlock_key_t key;
+
+    if (route == NULL || index >= ROUTER_ROUTE_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    if (!routes[index].used)
+    {
+        ret = -ENOENT;
+    }
+    else
+    {
+        *route = routes[index].route;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+int32_t cfl_router_get_stats(cfl_router_stats_t *out)
+{
+    k_spinlock_key_t key;
+
+    if (out == NULL)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    *out = stats;
+    k_spin_unlock(&lock, key);
+
+    return 0;
+}
+
+int32_t cfl_router_forward(
+    uint16_t src_node,
+    uint16_t src_port,
+    bool compact,
+    cfl_message_t *msg,
+    cfl_router_hop_t *next)
+{
+    int32_t ret = 0;
+    const cfl_route_t *route = NULL;
+    router_pending_t *entry = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (;;)
+    {
+        route = find_route(msg->cmd_id);
+        if (route == NULL)
+        {
+            ret = -ENOENT;
+            break;
+        }
+
+        /* Two gateways routing the same range to each other would bounce it forever */
+        if (route->dst_node == src_node)
+        {
+            stats.looped++;
+            ret = -ELOOP;
+            break;
+        }
+
+        next->node = route->dst_node;
+        next->port = route->dst_port;
+
+        if (msg->flags & CFL_F_RQST)
+        {
+            entry = alloc_pending(k_uptime_get_32());
+            if (entry == NULL)
+            {
+                stats.overflow++;
+                ret = -EBUSY;
+                break;
+            }
+
+            entry->used = true;
+            entry->compact = compact;
+            entry->src_node = src_node;
+            entry->src_port = src_port;
+            entry->src_seq = msg->seq;
+            entry->dst_node = route->dst_node;
+            entry->seq = cfl_next_seq();
+            entry->cmd_id = msg->cmd_id;
+            entry->deadline_ms = k_uptime_get_32() + CONFIG_CFL_ROUTER_TIMEOUT_MS;
+            stats.pending++;
+
+            msg->seq = entry->seq;
+        }
+
+        stats.forwarded++;
+        break;
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (ret == 0)
+    {
+        next->compact = hop_compact(next->node);
+    }
+
+    return ret;
+}
+
+int32_t cfl_router_return(uint16_t src_node, cfl_message_t *msg, cfl_router_hop_t *next)
+{
+    int32_t ret = -ENOENT;
+    k_spinlock_key_t key;
+
+    if ((msg->flags & ROUTER_REPLY_FLAGS) == 0)
+    {
+        return -ENOENT;
+    }
+
+    key = k_spin_lock(&lock);
+    for (size_t i = 0; i < ROUTER_PENDING_COUNT; i++)
+    {
+        router_pending_t *entry = &pending[i];
+
+        if (!entry->used || entry->dst_node != src_node || entry->seq != msg->seq ||
+            entry->cmd_id != msg->cmd_id)
+        {
+            continue;
+        }
+
+        /* ACK, NACK and reply all complete the request */
+        msg->seq = entry->src_seq;
+        next->node = entry->src_node;
+        next->port = entry->src_port;
+        next->compact = entry->compact;
+        entry->used = false;
+        stats.pending--;
+        stats.replies++;
+        ret = 0;
+        break;
+    }
+
+    if (ret < 0)
+    {
+        stats.unmatched++;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
@@ -0,0 +1,507 @@
+/* cfl_sched.c - Time-tagged command queue */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_ext.h"
+#include "cfl/cfl_ext_codec.h"
+#include "cfl/cfl_thread.h"
+#include "cfl/services/cfl_sched.h"
+#include "cfl_log.h"
+#include "services/cfl_ext_int.h"
+#include "services/cfl_service_danp_int.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define SCHED_COUNT    (CONFIG_CFL_SCHED_MAX)
+#define SCHED_MAX_DATA (CONFIG_CFL_SCHED_MAX_DATA)
+
+BUILD_ASSERT(SCHED_COUNT <= UINT16_MAX, "Queue slots must fit in the 16-bit part of an ID");
+
+#define SCHED_STATE_FREE    (0U)
+#define SCHED_STATE_QUEUED  (1U) /* In the heap, may be cancelled */
+#define SCHED_STATE_RUNNING (2U) /* Popped, handler running without the lock */
+
+/* Types */
+
+typedef struct sched_entry_s
+{
+    uint8_t state;
+    uint16_t generation;
+    uint16_t heap_pos;
+    uint16_t src_node;
+    uint32_t order; /* Insertion order, keeps commands with the same time FIFO */
+    int64_t exec_at_ms;
+    uint8_t rqst[CFL_HEADER_SIZE + SCHED_MAX_DATA] __aligned(4);
+} sched_entry_t;
+
+/* Forward Declarations */
+
+static void sched_handler(struct k_work *work);
+
+/* Variables */
+
+static struct k_spinlock lock;
+static sched_entry_t entries[SCHED_COUNT];
+/* Min-heap of entry indices ordered by execution time */
+static uint16_t heap[SCHED_COUNT];
+static size_t heap_len;
+/* Stack of free entry indices */
+static uint16_t free_slots[SCHED_COUNT];
+static size_t free_len;
+static bool initialized;
+static uint32_t next_order;
+static cfl_sched_stats_t stats;
+static K_WORK_DELAYABLE_DEFINE(sched_work, sched_handler);
+
+/* Functions */
+
+static void init_locked(void)
+{
+    if (initialized)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < SCHED_COUNT; i++)
+    {
+        free_slots[i] = (uint16_t)(SCHED_COUNT - 1 - i);
+    }
+    free_len = SCHED_COUNT;
+    initialized = true;
+}
+
+static bool runs_before(uint16_t a, uint16_t b)
+{
+    const sched_entry_t *ea = &entries[a];
+    const sched_entry_t *eb = &entries[b];
+
+    if (ea->exec_at_ms != eb->exec_at_ms)
+    {
+        return ea->exec_at_ms < eb->exec_at_ms;
+    }
+
+    return (int32_t)(ea->order - eb->order) < 0;
+}
+
+static void heap_swap(size_t i, size_t j)
+{
+    uint16_t tmp = heap[i];
+
+    heap[i] = heap[j];
+    heap[j] = tmp;
+    entries[heap[i]].heap_pos = (uint16_t)i;
+    entries[heap[j]].heap_pos = (uint16_t)j;
+}
+
+static void sift_up(size_t pos)
+{
+    while (pos > 0)
+    {
+        size_t parent = (pos - 1) / 2;
+
+        if (!runs_before(heap[pos], heap[parent]))
+        {
+            break;
+        }
+        heap_swap(pos, parent);
+        pos = parent;
+    }
+}
+
+static void sift_down(size_t pos)
+{
+    for (;;)
+    {
+        size_t left = 2 * pos + 1;
+        size_t right = left + 1;
+        size_t first = pos;
+
+        if (left < heap_len && runs_before(heap[left], heap[first]))
+        {
+            first = left;
+        }
+        if (right < heap_len && runs_before(heap[right], heap[first]))
+        {
+            first = right;
+        }
+        if (first == pos)
+        {
+            break;
+        }
+        heap_swap(pos, first);
+        pos = first;
+    }
+}
+
+static void heap_push(uint16_t slot)
+{
+    heap[heap_len] = slot;
+    entries[slot].heap_pos = (uint16_t)heap_len;
+    heap_len++;
+    sift_up(heap_len - 1);
+}
+
+static void heap_remove(size_t pos)
+{
+    heap_len--;
+    if (pos == heap_len)
+    {
+        return;
+    }
+
+    /* Move the last element into the hole, it may need to go either way */
+    heap[pos] = heap[heap_len];
+    entries[heap[pos]].heap_pos = (uint16_t)pos;
+    sift_up(pos);
+    sift_down(entries[heap[pos]].heap_pos);
+}
+
+static void release_locked(uint16_t slot)
+{
+    entries[slot].state = SCHED_STATE_FREE;
+    entries[slot].generation++;
+    free_slots[free_len++] = slot;
+}
+
+/* Arm the single wake-up for the earliest command */
+static void reschedule(void)
+{
+    bool any = false;
+    int64_t delay = 0;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (heap_len > 0)
+    {
+        any = true;
+        delay = entries[heap[0]].exec_at_ms - k_uptime_get();
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (!any)
+    {
+        (void)k_work_cancel_delayable(&sched_work);
+        return;
+    }
+
+    /* Far future commands are re-armed when this wake-up fires */
+    delay = CLAMP(delay, 0, INT32_MAX);
+    (void)k_work_reschedule_for_queue(cfl_thread_workq(), &sched_work, K_MSEC(delay));
+}
+
+static void sched_handler(struct k_work *work)
+{
+    int32_t ret = 0;
+    uint16_t slot = 0;
+    sched_entry_t *entry = NULL;
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(work);
+
+    for (;;)
+    {
+        key = k_spin_lock(&lock);
+        if (heap_len == 0 || entries[heap[0]].exec_at_ms > k_uptime_get())
+        {
+            k_spin_unlock(&lock, key);
+            break;
+        }
+        slot = heap[0];
+        heap_remove(0);
+        entry = &entries[slot];
+        entry->state = SCHED_STATE_RUNNING;
+        stats.queued--;
+        k_spin_unlock(&lock, key);
+
+        /* The entry is owned by this thread until released, no copy needed */
+        ret = cfl_service_danp_execute(entry->src_node, (cfl_message_t *)entry->rqst, NULL);
+        if (ret < 0)
+        {
+            CFL_LOG_RATELIMITED(
+                LOG_ERR,
+                "Scheduled command %d failed: %d",
+                ((cfl_message_t *)entry->rqst)->cmd_id,
+                ret);
+        }
+
+        key = k_spin_lock(&lock);
+        if (ret < 0)
+        {
+            stats.failed++;
+        }
+        else
+        {
+            stats.executed++;
+        }
+        release_locked(slot);
+        k_spin_unlock(&lock, key);
+    }
+
+    reschedule();
+}
+
+static int32_t add_command(
+    uint16_t src_node,
+    int64_t exec_at_ms,
+    uint16_t cmd_id,
+    const uint8_t *data,
+    uint16_t data_len,
+    uint32_t *id)
+{
+    uint16_t slot = 0;
+    bool is_first = false;
+    sched_entry_t *entry = NULL;
+    cfl_message_t *msg = NULL;
+    k_spinlock_key_t key;
+
+    if (data_len > SCHED_MAX_DATA)
+    {
+        return -EMSGSIZE;
+    }
+
+    if (data_len > 0 && data == NULL)
+    {
+        return -EINVAL;
+    }
+
+    /* Reserved commands could requeue themselves, unknown ones would only fail when due */
+    if (cmd_id >= CFL_EXT_CMD_BASE || !cfl_service_danp_has_handler(cmd_id))
+    {
+        return -ENOENT;
+    }
+
+    key = k_spin_lock(&lock);
+    init_locked();
+
+    if (free_len == 0)
+    {
+        stats.rejected++;
+        k_spin_unlock(&lock, key);
+        LOG_ERR("Command queue full, command %d rejected", cmd_id);
+        return -ENOMEM;
+    }
+
+    slot = free_slots[--free_len];
+    entry = &entries[slot];
+    entry->state = SCHED_STATE_QUEUED;
+    entry->src_node = src_node;
+    entry->order = next_order++;
+    entry->exec_at_ms = exec_at_ms;
+
+    msg = (cfl_message_t *)entry->rqst;
+    msg->sync = CFL_SYNC_WORD;
+    msg->version = CFL_VERSION;
+    msg->flags = CFL_F_RQST;
+    msg->cmd_id = cmd_id;
+    msg->seq = 0;
+    msg->length = data_len;
+    if (data_len > 0)
+    {
+        memcpy(msg->data, data, data_len);
+    }
+
+    heap_push(slot);
+    is_first = (heap[0] == slot);
+    stats.queued++;
+
+    if (id != NULL)
+    {
+        *id = ((uint32_t)entry->generation << 16) | slot;
+    }
+
+    k_spin_unlock(&lock, key);
+
+    /* Only a new earliest command moves the wake-up */
+    if (is_first)
+    {
+        reschedule();
+    }
+
+    return 0;
+}
+
+int32_t cfl_sched_add(
+    int64_t exec_at_ms,
+    uint16_t cmd_id,
+    const uint8_t *data,
+    uint16_t data_len,
+    uint32_t *id)
+{
+    return add_command(0, exec_at_ms, cmd_id, data, data_len, id);
+}
+
+/* Only the node that queued a command may cancel it, the local API (node 0) any */
+static int32_t cancel_command(uint16_t src_node, uint32_t id)
+{
+    int32_t ret = -ENOENT;
+    uint16_t slot = (uint16_t)(id & 0xFFFFU);
+    bool was_first = false;
+    k_spinlock_key_t key;
+
+    if (slot >= SCHED_COUNT)
+    {
+        return -ENOENT;
+    }
+
+    key = k_spin_lock(&lock);
+    if (entries[slot].state == SCHED_STATE_QUEUED &&
+        entries[slot].generation == (uint16_t)(id >> 16))
+    {
+        if (src_node != 0 && entries[slot].src_node != src_node)
+        {
+            ret = -EPERM;
+        }
+        else
+        {
+            was_first = (entries[slot].heap_pos == 0);
+            heap_remove(entries[slot].heap_pos);
+            release_locked(slot);
+            stats.queued--;
+            ret = 0;
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    if (was_first)
+    {
+        reschedule();
+    }
+
+    return ret;
+}
+
+int32_t cfl_sched_cancel(uint32_t id)
+{
+    return cancel_command(0, id);
+}
+
+size_t cfl_sched_flush(void)
+{
+    size_t dropped = 0;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    while (heap_len > 0)
+    {
+        uint16_t slot = heap[--heap_len];
+
+        release_locked(slot);
+        dropped++;
+    }
+    stats.queued = 0;
+
+    k_spin_unlock(&lock, key);
+
+    (void)k_work_cancel_delayable(&sched_work);
+
+    return dropped;
+}
+
+int32_t cfl_sched_get(size_t index, cfl_sched_info_t *info)
+{
+    int32_t ret = 0;
+    const sched_entry_t *entry = NULL;
+    const cfl_message_t *msg = NULL;
+    k_spinlock_key_t key;
+
+    if (info == NULL || index >= SCHED_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    entry = &entries[index];
+    if (entry->state != SCHED_STATE_QUEUED)
+    {
+        ret = -ENOENT;
+    }
+    else
+    {
+        msg = (const cfl_message_t *)entry->rqst;
+        info->id = ((uint32_t)entry->generation << 16) | index;
+        info->exec_at_ms = entry->exec_at_ms;
+        info->src_node = entry->src_node;
+        info->cmd_id = msg->cmd_id;
+        info->data_len = msg->length;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+void cfl_sched_get_stats(cfl_sched_stats_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    *out = stats;
+
+    k_spin_unlock(&lock, key);
+}
+
+int32_t cfl_sched_handle_schedule(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply)
+{
+    int32_t ret = 0;
+    cfl_ext_schedule_t req = {0};
+    cfl_ext_schedule_reply_t reply = {0};
+    uint8_t *buffer = NULL;
+
+    ret = cfl_ext_schedule_decode(rqst->data + rqst->hdr_len, rqst->len - rqst->hdr_len, &req);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ret = add_command(src_node, req.exec_at_ms, req.cmd_id, req.data, req.data_len, &reply.id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* Without a reply buffer the sender still gets an ACK, just no ID */
+    buffer = rply->ops.malloc(rply->hdr_len + CFL_EXT_SCHEDULE_REPLY_SIZE);
+    if (buffer != NULL)
+    {
+        ret = cfl_ext_schedule_reply_encode(
+            &buffer[rply->hdr_len], CFL_EXT_SCHEDULE_REPLY_SIZE, &reply);
+        rply->data = buffer;
+        rply->len = rply->hdr_len + ret;
+    }
+
+    return 0;
+}
+
+int32_t cfl_sched_handle_cancel(
+    uint16_t src_node,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply)
+{
+    int32_t ret = 0;
+    cfl_ext_schedule_cancel_t req = {0};
+
+    ARG_UNUSED(rply);
+
+    ret = cfl_ext_schedule_cancel_decode(
+        rqst->data + rqst->hdr_len, rqst->len - rqst->hdr_len, &req);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    return cancel_command(src_node, req.id);
+}
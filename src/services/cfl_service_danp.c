@@ -9,108 +9,1018 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "zephyr/init.h"
+#include "zephyr/kernel.h"
 #include "zephyr/logging/log.h"
 #include "zephyr/logging/log_instance.h"
 #include "zephyr/tmtc.h"
 
 #include "cfl/cfl.h"
+#include "cfl/cfl_buf.h"
+#include "cfl/cfl_capture.h"
+#include "cfl/cfl_compact.h"
+#include "cfl/cfl_ext.h"
+#include "cfl/cfl_ext_codec.h"
+#include "cfl/cfl_latency.h"
+#include "cfl/cfl_seq.h"
+#include "cfl/cfl_spsc.h"
+#include "cfl/cfl_trace.h"
+#include "cfl/cfl_transport.h"
+#include "cfl/cfl_utilities.h"
+#include "cfl_log.h"
+#include "cfl/services/cfl_budget.h"
+#include "cfl/services/cfl_ratelimit.h"
+#include "cfl/services/cfl_registry.h"
+#include "cfl/services/cfl_router.h"
 #include "cfl/services/cfl_service_danp.h"
+#include "cfl/services/cfl_session.h"
+#include "cfl/services/cfl_stream.h"
+#include "services/cfl_ext_int.h"
+#include "services/cfl_service_danp_int.h"
 #include "danp/danp.h"
 #include "danp/danp_buffer.h"
 #include "danp/danp_types.h"
-#include "osal/osal_thread.h"
-#include "osal/osal_time.h"
 
 /* Private Definitions */
 
-LOG_MODULE_DECLARE(cfl);
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
 
 LOG_INSTANCE_REGISTER(cfl, service, CONFIG_CFL_LOG_LEVEL);
 
+/* Per-message traces are compiled out unless explicitly requested */
+#if defined(CONFIG_CFL_LOG_HOT_PATH)
 #define CFL_SERVICE_LOG_VER(...) LOG_INST_DBG(LOG_INSTANCE_PTR(cfl, service), __VA_ARGS__)
+#else
+#define CFL_SERVICE_LOG_VER(...)                                                                   \
+    do                                                                                             \
+    {                                                                                              \
+    } while (0)
+#endif
 #define CFL_SERVICE_LOG_DBG(...) LOG_INST_DBG(LOG_INSTANCE_PTR(cfl, service), __VA_ARGS__)
 #define CFL_SERVICE_LOG_INF(...) LOG_INST_INF(LOG_INSTANCE_PTR(cfl, service), __VA_ARGS__)
 #define CFL_SERVICE_LOG_WRN(...) LOG_INST_WRN(LOG_INSTANCE_PTR(cfl, service), __VA_ARGS__)
 #define CFL_SERVICE_LOG_ERR(...) LOG_INST_ERR(LOG_INSTANCE_PTR(cfl, service), __VA_ARGS__)
+#define CFL_SERVICE_LOG_ERR_RL(...) CFL_LOG_RATELIMITED(CFL_SERVICE_LOG_ERR, __VA_ARGS__)
+
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+#define CFL_SERVICE_DEFERRED_COUNT (CONFIG_CFL_SERVICE_DEFERRED_MAX)
+#endif
+
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+#define PUSH_ACK_PEERS    (CONFIG_CFL_SERVICE_PUSH_ACK_PEERS)
+#define PUSH_ACK_WINDOW   (CONFIG_CFL_SERVICE_PUSH_ACK_WINDOW)
+#define PUSH_ACK_MAX_DATA (CONFIG_CFL_SERVICE_PUSH_ACK_MAX_DATA)
+#endif
+
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+#define CFL_SERVICE_RX_RING_SIZE (CONFIG_CFL_SERVICE_RX_RING_SIZE)
+#define CFL_SERVICE_RX_BATCH     (CONFIG_CFL_SERVICE_RX_BATCH)
+
+/* The source address travels with the packet in the ring tag */
+#define RX_RING_TAG(_node, _port) (((uint32_t)(_node) << 16) | (uint32_t)(_port))
+#define RX_RING_TAG_NODE(_tag)    ((uint16_t)((_tag) >> 16))
+#define RX_RING_TAG_PORT(_tag)    ((uint16_t)((_tag) & 0xFFFFU))
+
+/* A queued packet may grow by compact header expansion or become its status reply */
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+#define RX_EXPAND_GROWTH (CFL_HEADER_SIZE - CFL_COMPACT_HEADER_MIN)
+#else
+#define RX_EXPAND_GROWTH (0U)
+#endif
+#define RX_QUEUED_CAPACITY(_len)                                                               \
+    MAX((_len) + RX_EXPAND_GROWTH, CFL_HEADER_SIZE + CFL_EXT_STATUS_SIZE)
+#endif
 
 /* Private Types */
 
+typedef struct cfl_service_danp_current_s
+{
+    uint16_t src_node;
+    uint16_t src_port;
+    uint16_t cmd_id;
+    uint16_t seq;
+    bool is_request;
+    bool compact;
+    bool deferred;
+    /* Thread running the handler, sched and pubsub run handlers on other threads too */
+    k_tid_t dispatcher;
+    /* Sent on by the router, the packet now belongs to DANP */
+    bool forwarded;
+    /* Received on a stream connection, answers can only go back on it */
+    bool stream;
+    /* The request asked for the times it was served, see CFL_EXT_F_TIMESTAMP */
+    bool timestamp;
+    uint64_t rx_us;
+    uint16_t deferred_slot;
+    cfl_trace_record_t *trace;
+} cfl_service_danp_current_t;
+
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+typedef struct cfl_service_danp_pending_s
+{
+    bool in_use;
+    uint16_t generation;
+    uint16_t dst_node;
+    uint16_t dst_port;
+    uint16_t cmd_id;
+    uint16_t seq;
+    bool compact;
+    uint32_t deadline_ms;
+} cfl_service_danp_pending_t;
+#endif
+
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+/* Reliable push traffic with one node, in both directions */
+typedef struct cfl_service_danp_peer_s
+{
+    bool in_use;
+    uint16_t node;
+    uint16_t tx_seq;   /* Sequence number of our next reliable push to the node */
+    uint16_t rx_port;  /* Port the last reliable push came from */
+    cfl_seq_range_t rx; /* Pushes received and not acknowledged yet */
+    uint32_t rx_deadline_ms;
+    uint32_t last_used_ms;
+} cfl_service_danp_peer_t;
+
+/* A sent reliable push, kept until a cumulative ACK covers it */
+typedef struct cfl_service_danp_unacked_s
+{
+    bool in_use;
+    uint8_t retries;
+    uint16_t dst_node;
+    uint16_t dst_port;
+    uint16_t seq;
+    uint16_t length; /* Header included */
+    uint32_t deadline_ms;
+    uint8_t msg[CFL_HEADER_SIZE + PUSH_ACK_MAX_DATA] __aligned(4);
+} cfl_service_danp_unacked_t;
+#endif
+
+/* Handler found for a message, one of ext, entry and tmtc is set */
+typedef struct cfl_service_danp_handler_s
+{
+    cfl_ext_handler_t ext;
+#if defined(CONFIG_CFL_REGISTRY)
+    const cfl_registry_entry_t *entry;
+    uint32_t ref;
+#endif
+    const struct tmtc_cmd_handler *tmtc;
+} cfl_service_danp_handler_t;
+
 typedef struct cfl_service_danp_ctx_s
 {
-    bool initialized;
-    volatile bool running;
-    uint16_t local_port;
-    danp_socket_t *socket;
-    osal_thread_handle_t rx_task_handle;
-} cfl_service_danp_ctx_t;
+    bool initialized;
+    volatile bool running;
+    uint16_t local_port;
+    const cfl_transport_ops_t *transport;
+    void *socket;
+    struct k_thread rx_thread;
+    k_tid_t rx_tid;
+    k_thread_stack_t *rx_stack_dynamic;
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+    struct k_thread proc_thread;
+    k_tid_t proc_tid;
+    cfl_spsc_t rx_ring;
+    struct k_sem rx_ready;
+    atomic_t proc_waiting;
+#endif
+    cfl_service_danp_stats_t stats;
+    /* Message being dispatched, only touched by the thread serving packets */
+    cfl_service_danp_current_t current;
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+    struct k_spinlock pending_lock;
+    cfl_service_danp_pending_t pending[CFL_SERVICE_DEFERRED_COUNT];
+#endif
+} cfl_service_danp_ctx_t;
+
+/* Private Variables */
+
+static cfl_service_danp_ctx_t context;
+
+static K_THREAD_STACK_DEFINE(rx_stack, CFL_DANP_RX_TASK_STACK_SIZE);
+
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+BUILD_ASSERT(IS_POWER_OF_TWO(CFL_SERVICE_RX_RING_SIZE), "RX ring size must be a power of two");
+
+static K_THREAD_STACK_DEFINE(proc_stack, CONFIG_CFL_SERVICE_PROC_STACK_SIZE);
+static cfl_spsc_entry_t rx_ring_slots[CFL_SERVICE_RX_RING_SIZE];
+#endif
+
+/*
+ * Handlers run one at a time: the RX path, the stream server and the work
+ * queue items of cfl_service_danp_execute() all dispatch under this lock
+ */
+static K_MUTEX_DEFINE(dispatch_lock);
+
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+static void push_ack_handler(struct k_work *work);
+
+/* Outside the context so they survive its reset, shared with senders on any thread */
+static struct k_spinlock push_ack_lock;
+static cfl_service_danp_peer_t peers[PUSH_ACK_PEERS];
+static cfl_service_danp_unacked_t unacked[PUSH_ACK_WINDOW];
+/*
+ * Reliable pushes sent to any node. A peer entry starts numbering from it, so
+ * a node evicted and seen again never gets a number it was sent before.
+ */
+static uint16_t push_tx_total;
+static K_WORK_DELAYABLE_DEFINE(push_ack_work, push_ack_handler);
+#endif
+
+/* Reserved commands served by CFL itself, terminated by a NULL handler */
+static const cfl_ext_entry_t ext_handlers[] = {
+#if defined(CONFIG_CFL_PUBSUB)
+    {CFL_EXT_CMD_SUBSCRIBE, cfl_pubsub_handle_subscribe},
+    {CFL_EXT_CMD_UNSUBSCRIBE, cfl_pubsub_handle_unsubscribe},
+#endif
+#if defined(CONFIG_CFL_SCHED)
+    {CFL_EXT_CMD_SCHEDULE, cfl_sched_handle_schedule},
+    {CFL_EXT_CMD_SCHEDULE_CANCEL, cfl_sched_handle_cancel},
+#endif
+#if defined(CONFIG_CFL_XFER)
+    {CFL_EXT_CMD_XFER_OPEN, cfl_xfer_handle_open},
+    {CFL_EXT_CMD_XFER_DATA, cfl_xfer_handle_data},
+    {CFL_EXT_CMD_XFER_STATUS, cfl_xfer_handle_status},
+    {CFL_EXT_CMD_XFER_CLOSE, cfl_xfer_handle_close},
+#endif
+    {0, NULL},
+};
+
+/* Private Helper Functions */
+
+static void write_status_message(
+    danp_packet_t *pkt,
+    uint8_t flags,
+    uint16_t msg_id,
+    uint16_t msg_seq,
+    int32_t error_code)
+{
+    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
+    const cfl_ext_status_t status = {.status = error_code};
+
+    msg->sync = CFL_SYNC_WORD;
+    msg->version = CFL_VERSION;
+    msg->flags = flags;
+    msg->cmd_id = msg_id;
+    msg->seq = msg_seq;
+    msg->length = 0;
+    if (flags & CFL_F_NACK)
+    {
+        msg->length = cfl_ext_status_encode(msg->data, CFL_EXT_STATUS_SIZE, &status);
+    }
+    pkt->length = CFL_HEADER_SIZE + msg->length;
+}
+
+danp_packet_t *cfl_create_nack_packet(uint16_t msg_id, uint16_t msg_seq, int32_t error_code)
+{
+    danp_packet_t *pkt = danp_buffer_get();
+    if (pkt == NULL)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Failed to allocate NACK packet");
+        return NULL;
+    }
+
+    write_status_message(pkt, CFL_F_NACK, msg_id, msg_seq, error_code);
+
+    return pkt;
+}
+
+danp_packet_t *cfl_create_ack_packet(uint16_t msg_id, uint16_t msg_seq)
+{
+    danp_packet_t *pkt = danp_buffer_get();
+    if (pkt == NULL)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Failed to allocate ACK packet");
+        return NULL;
+    }
+
+    write_status_message(pkt, CFL_F_ACK, msg_id, msg_seq, 0);
+
+    return pkt;
+}
+
+/* Turn a request into its ACK/NACK without allocating a new buffer */
+static danp_packet_t *rewrite_as_status(danp_packet_t *rqst_pkt, uint8_t flags, int32_t error_code)
+{
+    const cfl_message_t *rqst_msg = (const cfl_message_t *)rqst_pkt->payload;
+    uint16_t msg_id = rqst_msg->cmd_id;
+    uint16_t msg_seq = rqst_msg->seq;
+
+    write_status_message(rqst_pkt, flags, msg_id, msg_seq, error_code);
+
+    return rqst_pkt;
+}
+
+/* Best effort, a packet that cannot be packed is still valid in the full format */
+static void pack_if_compact(danp_packet_t *pkt, bool compact)
+{
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+    if (compact && pkt != NULL)
+    {
+        (void)cfl_compact_pack(pkt);
+    }
+#else
+    (void)pkt;
+    (void)compact;
+#endif
+}
+
+static danp_packet_t *create_reply_packet(
+    uint16_t msg_id,
+    uint16_t msg_seq,
+    danp_packet_t *pkt)
+{
+    if (pkt == NULL)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Failed to allocate reply packet");
+        return NULL;
+    }
+
+    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
+    msg->sync = CFL_SYNC_WORD;
+    msg->version = CFL_VERSION;
+    msg->flags = CFL_F_RPLY;
+    msg->cmd_id = msg_id;
+    msg->seq = msg_seq;
+    msg->length = pkt->length - CFL_HEADER_SIZE;
+
+    return pkt;
+}
+
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+static bool take_pending(uint16_t slot, uint16_t generation, cfl_service_danp_pending_t *out)
+{
+    bool found = false;
+    cfl_service_danp_pending_t *pending = &context.pending[slot];
+    k_spinlock_key_t key = k_spin_lock(&context.pending_lock);
+
+    if (pending->in_use && pending->generation == generation)
+    {
+        *out = *pending;
+        pending->in_use = false;
+        found = true;
+    }
+
+    k_spin_unlock(&context.pending_lock, key);
+
+    return found;
+}
+
+static void release_pending(uint16_t slot)
+{
+    k_spinlock_key_t key = k_spin_lock(&context.pending_lock);
+    context.pending[slot].in_use = false;
+    k_spin_unlock(&context.pending_lock, key);
+}
+
+static void expire_pending(void)
+{
+    uint32_t now = k_uptime_get_32();
+
+    for (uint16_t i = 0; i < CFL_SERVICE_DEFERRED_COUNT; i++)
+    {
+        cfl_service_danp_pending_t *pending = &context.pending[i];
+        cfl_service_danp_pending_t expired = {0};
+        danp_packet_t *pkt = NULL;
+        k_spinlock_key_t key = k_spin_lock(&context.pending_lock);
+
+        if (pending->in_use && (int32_t)(now - pending->deadline_ms) >= 0)
+        {
+            expired = *pending;
+            pending->in_use = false;
+        }
+
+        k_spin_unlock(&context.pending_lock, key);
+
+        if (!expired.in_use)
+        {
+            continue;
+        }
+
+        CFL_SERVICE_LOG_WRN("Deferred reply timed out for request ID: %d", expired.cmd_id);
+        pkt = cfl_create_nack_packet(expired.cmd_id, expired.seq, -ETIMEDOUT);
+        if (pkt != NULL)
+        {
+            pack_if_compact(pkt, expired.compact);
+            context.transport->send_to(context.socket, pkt, expired.dst_node, expired.dst_port);
+        }
+    }
+}
+#endif
+
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+static void write_push_ack(danp_packet_t *pkt, uint16_t first_seq, uint16_t count)
+{
+    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
+    const cfl_ext_push_ack_t ack = {.first_seq = first_seq, .count = count};
+
+    msg->sync = CFL_SYNC_WORD;
+    msg->version = CFL_VERSION;
+    msg->flags = CFL_F_ACK;
+    msg->cmd_id = CFL_EXT_CMD_PUSH_ACK;
+    msg->seq = (uint16_t)(first_seq + count - 1U);
+    msg->length = (uint16_t)cfl_ext_push_ack_encode(msg->data, CFL_EXT_PUSH_ACK_SIZE, &ack);
+    pkt->length = CFL_HEADER_SIZE + msg->length;
+}
+
+static bool has_unacked_locked(uint16_t node)
+{
+    for (size_t i = 0; i < PUSH_ACK_WINDOW; i++)
+    {
+        if (unacked[i].in_use && unacked[i].dst_node == node)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Peers with a range owed or pushes not acknowledged yet are never evicted,
+ * the least recently used idle one is
+ */
+static cfl_service_danp_peer_t *find_peer_locked(uint16_t node, uint32_t now)
+{
+    cfl_service_danp_peer_t *free_peer = NULL;
+    cfl_service_danp_peer_t *idle_peer = NULL;
+
+    for (size_t i = 0; i < PUSH_ACK_PEERS; i++)
+    {
+        cfl_service_danp_peer_t *peer = &peers[i];
+
+        if (peer->in_use && peer->node == node)
+        {
+            peer->last_used_ms = now;
+            return peer;
+        }
+
+        if (!peer->in_use)
+        {
+            free_peer = (free_peer == NULL) ? peer : free_peer;
+        }
+        else if (peer->rx.count == 0 &&
+                 (idle_peer == NULL ||
+                  (int32_t)(peer->last_used_ms - idle_peer->last_used_ms) < 0) &&
+                 !has_unacked_locked(peer->node))
+        {
+            idle_peer = peer;
+        }
+    }
+
+    free_peer = (free_peer != NULL) ? free_peer : idle_peer;
+    if (free_peer != NULL)
+    {
+        memset(free_peer, 0, sizeof(*free_peer));
+        free_peer->in_use = true;
+        free_peer->node = node;
+        free_peer->tx_seq = push_tx_total;
+        free_peer->last_used_ms = now;
+    }
+
+    return free_peer;
+}
+
+/* Arm the single wake-up for the earliest ACK or retransmission due */
+static void push_ack_reschedule(void)
+{
+    bool any = false;
+    int32_t delay = INT32_MAX;
+    uint32_t now = k_uptime_get_32();
+    k_spinlock_key_t key = k_spin_lock(&push_ack_lock);
+
+    for (size_t i = 0; i < PUSH_ACK_PEERS; i++)
+    {
+        if (peers[i].in_use && peers[i].rx.count != 0)
+        {
+            any = true;
+            delay = MIN(delay, (int32_t)(peers[i].rx_deadline_ms - now));
+        }
+    }
+
+    for (size_t i = 0; i < PUSH_ACK_WINDOW; i++)
+    {
+        if (unacked[i].in_use)
+        {
+            any = true;
+            delay = MIN(delay, (int32_t)(unacked[i].deadline_ms - now));
+        }
+    }
+
+    k_spin_unlock(&push_ack_lock, key);
+
+    if (!any)
+    {
+        (void)k_work_cancel_delayable(&push_ack_work);
+        return;
+    }
+
+    (void)k_work_reschedule_for_queue(cfl_thread_workq(), &push_ack_work, K_MSEC(MAX(delay, 0)));
+}
+
+static void send_push_ack(uint16_t node, uint16_t port, uint16_t first_seq, uint16_t count)
+{
+    danp_packet_t *pkt = danp_buffer_get();
+
+    if (pkt == NULL)
+    {
+        /* The sender retransmits and the pushes are acknowledged again */
+        CFL_SERVICE_LOG_ERR_RL("No buffer for the cumulative ACK to node %d", node);
+        return;
+    }
+
+    write_push_ack(pkt, first_seq, count);
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+    pack_if_compact(pkt, cfl_compact_peer_enabled(node));
+#endif
+    context.transport->send_to(context.socket, pkt, node, port);
+}
+
+/*
+ * Adds a received reliable push to the range owed to its sender. Returns true
+ * with the range to acknowledge right away when the push does not continue the
+ * range or completes CONFIG_CFL_SERVICE_PUSH_ACK_COUNT pushes.
+ */
+static bool note_reliable_push(
+    uint16_t node,
+    uint16_t port,
+    uint16_t seq,
+    uint16_t *first_seq,
+    uint16_t *count)
+{
+    bool flush = false;
+    bool started = false;
+    uint32_t now = k_uptime_get_32();
+    cfl_service_danp_peer_t *peer = NULL;
+    k_spinlock_key_t key = k_spin_lock(&push_ack_lock);
+
+    peer = find_peer_locked(node, now);
+    if (peer == NULL)
+    {
+        /* Every peer owes a range, acknowledge this push on its own */
+        *first_seq = seq;
+        *count = 1;
+        flush = true;
+    }
+    else
+    {
+        /* A gap or a push received again closes the range */
+        if (!cfl_seq_range_add(&peer->rx, seq))
+        {
+            *first_seq = peer->rx.first;
+            *count = peer->rx.count;
+            flush = true;
+            peer->rx.count = 0;
+            (void)cfl_seq_range_add(&peer->rx, seq);
+        }
+
+        if (peer->rx.count == 1)
+        {
+            peer->rx_deadline_ms = now + CONFIG_CFL_SERVICE_PUSH_ACK_DELAY_MS;
+            started = true;
+        }
+        peer->rx_port = port;
+
+        if (!flush && peer->rx.count >= CONFIG_CFL_SERVICE_PUSH_ACK_COUNT)
+        {
+            *first_seq = peer->rx.first;
+            *count = peer->rx.count;
+            flush = true;
+            peer->rx.count = 0;
+            started = false;
+        }
+    }
+
+    if (flush)
+    {
+        context.stats.push_acks++;
+        context.stats.push_acked += *count;
+    }
+
+    k_spin_unlock(&push_ack_lock, key);
+
+    if (started)
+    {
+        push_ack_reschedule();
+    }
+
+    return flush;
+}
+
+/* The push was handled, answer with its cumulative ACK when one is due now */
+static danp_packet_t *ack_reliable_push(
+    uint16_t src_node,
+    uint16_t src_port,
+    uint16_t seq,
+    danp_packet_t *rqst_pkt)
+{
+    uint16_t first_seq = 0;
+    uint16_t count = 0;
+
+    if (!note_reliable_push(src_node, src_port, seq, &first_seq, &count))
+    {
+        return NULL;
+    }
+
+    /* Written over the push like any status reply, no buffer is allocated */
+    write_push_ack(rqst_pkt, first_seq, count);
+
+    return rqst_pkt;
+}
+
+/*
+ * Number a reliable push for its destination, keep it until a cumulative ACK
+ * covers it and send the first attempt
+ */
+static int32_t queue_push_reliable(
+    uint16_t dst_node,
+    uint16_t dst_port,
+    uint16_t id,
+    const uint8_t *payload,
+    uint16_t payload_len)
+{
+    int32_t ret = 0;
+    uint32_t now = 0;
+    danp_packet_t *pkt = NULL;
+    cfl_message_t *msg = NULL;
+    cfl_service_danp_peer_t *peer = NULL;
+    cfl_service_danp_unacked_t *entry = NULL;
+    k_spinlock_key_t key;
+
+    if (payload_len > PUSH_ACK_MAX_DATA)
+    {
+        return -EMSGSIZE;
+    }
+
+    /* Taken before the lock, a failure only leaves the push to its first retransmission */
+    pkt = danp_buffer_get();
+
+    now = k_uptime_get_32();
+    key = k_spin_lock(&push_ack_lock);
+
+    for (;;)
+    {
+        for (size_t i = 0; i < PUSH_ACK_WINDOW; i++)
+        {
+            if (!unacked[i].in_use)
+            {
+                entry = &unacked[i];
+                break;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            ret = -EBUSY;
+            break;
+        }
+
+        peer = find_peer_locked(dst_node, now);
+        if (peer == NULL)
+        {
+            ret = -ENOMEM;
+            break;
+        }
+
+        /* Kept as sent, so a retransmission is a copy of the first attempt */
+        msg = (cfl_message_t *)entry->msg;
+        msg->sync = CFL_SYNC_WORD;
+        msg->version = CFL_VERSION;
+        msg->flags = CFL_EXT_F_PUSH_RELIABLE;
+        msg->cmd_id = id;
+        msg->seq = peer->tx_seq++;
+        push_tx_total++;
+        msg->length = payload_len;
+        if (payload_len > 0)
+        {
+            memcpy(msg->data, payload, payload_len);
+        }
+
+        entry->in_use = true;
+        entry->retries = 0;
+        entry->dst_node = dst_node;
+        entry->dst_port = dst_port;
+        entry->seq = msg->seq;
+        entry->length = CFL_HEADER_SIZE + payload_len;
+        entry->deadline_ms = now + CONFIG_CFL_SERVICE_PUSH_ACK_RETRY_MS;
+
+        if (pkt != NULL)
+        {
+            memcpy(pkt->payload, entry->msg, entry->length);
+            pkt->length = entry->length;
+        }
+        break;
+    }
+
+    k_spin_unlock(&push_ack_lock, key);
+
+    if (ret < 0)
+    {
+        if (pkt != NULL)
+        {
+            danp_buffer_free(pkt);
+        }
+        return ret;
+    }
+
+    if (pkt == NULL)
+    {
+        /* Stored already, the first retransmission sends it */
+        CFL_SERVICE_LOG_ERR_RL("Failed to allocate packet buffer");
+    }
+    else
+    {
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+        pack_if_compact(pkt, cfl_compact_peer_enabled(dst_node));
+#endif
+        context.transport->send_to(context.socket, pkt, dst_node, dst_port);
+    }
+
+    push_ack_reschedule();
+
+    return 0;
+}
+
+static int32_t release_acked_pushes(uint16_t src_node, const cfl_message_t *msg)
+{
+    cfl_ext_push_ack_t ack = {0};
+    cfl_seq_range_t range = {0};
+    uint32_t released = 0;
+    k_spinlock_key_t key;
+
+    if (cfl_ext_push_ack_decode(msg->data, msg->length, &ack) < 0)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Malformed cumulative ACK from node %d", src_node);
+        context.stats.rx_invalid++;
+        return -EBADMSG;
+    }
+
+    range.first = ack.first_seq;
+    range.count = ack.count;
+    key = k_spin_lock(&push_ack_lock);
+    for (size_t i = 0; i < PUSH_ACK_WINDOW; i++)
+    {
+        cfl_service_danp_unacked_t *entry = &unacked[i];
+
+        if (entry->in_use && entry->dst_node == src_node &&
+            cfl_seq_range_covers(&range, entry->seq))
+        {
+            entry->in_use = false;
+            released++;
+        }
+    }
+    k_spin_unlock(&push_ack_lock, key);
+
+    CFL_SERVICE_LOG_VER(
+        "Cumulative ACK from node %d released %u pushes", src_node, (uint32_t)released);
+
+    return 0;
+}
+
+static void push_ack_handler(struct k_work *work)
+{
+    uint32_t now = k_uptime_get_32();
+    uint8_t msg[CFL_HEADER_SIZE + PUSH_ACK_MAX_DATA] __aligned(4);
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(work);
+
+    if (!context.initialized)
+    {
+        return;
+    }
+
+    /* Ranges that did not fill up in time */
+    for (size_t i = 0; i < PUSH_ACK_PEERS; i++)
+    {
+        cfl_service_danp_peer_t *peer = &peers[i];
+        uint16_t node = 0;
+        uint16_t port = 0;
+        uint16_t first_seq = 0;
+        uint16_t count = 0;
+
+        key = k_spin_lock(&push_ack_lock);
+        if (peer->in_use && peer->rx.count != 0 && (int32_t)(now - peer->rx_deadline_ms) >= 0)
+        {
+            node = peer->node;
+            port = peer->rx_port;
+            first_seq = peer->rx.first;
+            count = peer->rx.count;
+            peer->rx.count = 0;
+            context.stats.push_acks++;
+            context.stats.push_acked += count;
+        }
+        k_spin_unlock(&push_ack_lock, key);
+
+        if (count != 0)
+        {
+            send_push_ack(node, port, first_seq, count);
+        }
+    }
+
+    /* Pushes no cumulative ACK covered in time */
+    for (size_t i = 0; i < PUSH_ACK_WINDOW; i++)
+    {
+        cfl_service_danp_unacked_t *entry = &unacked[i];
+        danp_packet_t *pkt = NULL;
+        uint16_t dst_node = 0;
+        uint16_t dst_port = 0;
+        uint16_t length = 0;
+        uint16_t seq = 0;
+        bool lost = false;
+
+        key = k_spin_lock(&push_ack_lock);
+        if (entry->in_use && (int32_t)(now - entry->deadline_ms) >= 0)
+        {
+            if (entry->retries >= CONFIG_CFL_SERVICE_PUSH_ACK_RETRIES)
+            {
+                entry->in_use = false;
+                context.stats.push_lost++;
+                lost = true;
+                dst_node = entry->dst_node;
+                seq = entry->seq;
+            }
+            else
+            {
+                entry->retries++;
+                entry->deadline_ms = now + CONFIG_CFL_SERVICE_PUSH_ACK_RETRY_MS;
+                dst_node = entry->dst_node;
+                dst_port = entry->dst_port;
+                length = entry->length;
+                memcpy(msg, entry->msg, length);
+                context.stats.push_retries++;
+            }
+        }
+        k_spin_unlock(&push_ack_lock, key);
+
+        if (lost)
+        {
+            CFL_SERVICE_LOG_WRN(
+                "Reliable push %d to node %d not acknowledged, giving up", seq, dst_node);
+        }
+
+        if (length == 0)
+        {
+            continue;
+        }
+
+        pkt = danp_buffer_get();
+        if (pkt == NULL)
+        {
+            /* Tried again on the next retry */
+            CFL_SERVICE_LOG_ERR_RL("No buffer to retransmit a push to node %d", dst_node);
+            continue;
+        }
+
+        memcpy(pkt->payload, msg, length);
+        pkt->length = length;
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+        pack_if_compact(pkt, cfl_compact_peer_enabled(dst_node));
+#endif
+        context.transport->send_to(context.socket, pkt, dst_node, dst_port);
+    }
+
+    push_ack_reschedule();
+}
+
+static void push_ack_reset(void)
+{
+    k_spinlock_key_t key;
 
-/* Private Variables */
+    (void)k_work_cancel_delayable(&push_ack_work);
 
-static cfl_service_danp_ctx_t context;
+    key = k_spin_lock(&push_ack_lock);
+    memset(peers, 0, sizeof(peers));
+    memset(unacked, 0, sizeof(unacked));
+    k_spin_unlock(&push_ack_lock, key);
+}
 
-/* Private Helper Functions */
+/* Like request numbers, push numbers of a restarted node must not resume where they were */
+static int push_ack_seed(void)
+{
+    push_tx_total = (uint16_t)cfl_random32();
+
+    return 0;
+}
+
+SYS_INIT(push_ack_seed, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif
 
-static danp_packet_t *create_nack_packet(uint16_t msg_id, uint16_t msg_seq, int32_t error_code)
+static cfl_ext_handler_t find_ext_handler(uint16_t cmd_id)
 {
-    danp_packet_t *pkt = danp_buffer_get();
-    if (pkt == NULL)
+    if (cmd_id < CFL_EXT_CMD_BASE)
     {
-        CFL_SERVICE_LOG_ERR("Failed to allocate NACK packet");
         return NULL;
     }
 
-    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
-    msg->sync = CFL_SYNC_WORD;
-    msg->version = CFL_VERSION;
-    msg->flags = CFL_F_NACK;
-    msg->cmd_id = msg_id;
-    msg->seq = msg_seq;
-    msg->length = sizeof(error_code);
-    memcpy(msg->data, &error_code, msg->length);
-    pkt->length = CFL_HEADER_SIZE + msg->length;
+    for (const cfl_ext_entry_t *entry = ext_handlers; entry->handler != NULL; entry++)
+    {
+        if (entry->cmd_id == cmd_id)
+        {
+            return entry->handler;
+        }
+    }
 
-    return pkt;
+    return NULL;
 }
 
-static danp_packet_t *create_ack_packet(uint16_t msg_id, uint16_t msg_seq)
+/* Reserved commands first, then runtime registrations, then the static tmtc set */
+static bool find_handler(uint16_t cmd_id, cfl_service_danp_handler_t *handler)
 {
-    danp_packet_t *pkt = danp_buffer_get();
-    if (pkt == NULL)
+    memset(handler, 0, sizeof(*handler));
+
+    handler->ext = find_ext_handler(cmd_id);
+    if (NULL != handler->ext)
     {
-        CFL_SERVICE_LOG_ERR("Failed to allocate ACK packet");
-        return NULL;
+        return true;
     }
 
-    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
-    msg->sync = CFL_SYNC_WORD;
-    msg->version = CFL_VERSION;
-    msg->flags = CFL_F_ACK;
-    msg->cmd_id = msg_id;
-    msg->seq = msg_seq;
-    msg->length = 0;
-    pkt->length = CFL_HEADER_SIZE + msg->length;
+#if defined(CONFIG_CFL_REGISTRY)
+    handler->entry = cfl_registry_acquire(cmd_id, &handler->ref);
+    if (NULL != handler->entry)
+    {
+        return true;
+    }
+#endif
 
-    return pkt;
+    handler->tmtc = tmtc_get_cmd_handler(cmd_id);
+    return NULL != handler->tmtc;
 }
 
-static danp_packet_t *create_reply_packet(
-    uint16_t msg_id,
-    uint16_t msg_seq,
-    danp_packet_t *pkt)
+/* Lets a runtime handler be unregistered again, once it no longer runs */
+static void put_handler(const cfl_service_danp_handler_t *handler)
 {
-    if (pkt == NULL)
+#if defined(CONFIG_CFL_REGISTRY)
+    if (NULL != handler->entry)
     {
-        CFL_SERVICE_LOG_ERR("Failed to allocate reply packet");
-        return NULL;
+        cfl_registry_release(handler->ref);
     }
+#else
+    ARG_UNUSED(handler);
+#endif
+}
 
-    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
-    msg->sync = CFL_SYNC_WORD;
-    msg->version = CFL_VERSION;
-    msg->flags = CFL_F_RPLY;
-    msg->cmd_id = msg_id;
-    msg->seq = msg_seq;
-    msg->length = pkt->length - CFL_HEADER_SIZE;
+/*
+ * DANP does not tell the node of a stream peer, handlers see CFL_STREAM_SRC_NODE
+ * for all of them. Reserved commands keep state per requesting node, to push
+ * to it or to tell transfers apart, so they are refused on streams.
+ */
+static bool stream_allows(const cfl_service_danp_handler_t *handler)
+{
+    if (context.current.stream && NULL != handler->ext)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Reserved command refused on a stream, its node is unknown");
+        return false;
+    }
+
+    return true;
+}
+
+static int32_t call_handler(
+    uint16_t src_node,
+    const cfl_service_danp_handler_t *handler,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply)
+{
+    if (NULL != handler->ext)
+    {
+        return handler->ext(src_node, rqst, rply);
+    }
+
+#if defined(CONFIG_CFL_REGISTRY)
+    if (NULL != handler->entry)
+    {
+        return handler->entry->handler(handler->entry->ctx, src_node, rqst, rply);
+    }
+#endif
+
+    return tmtc_run_handler(handler->tmtc, rqst, rply);
+}
+
+static int32_t run_handler(
+    uint16_t src_node,
+    const cfl_service_danp_handler_t *handler,
+    struct tmtc_args *rqst,
+    struct tmtc_args *rply)
+{
+#if defined(CONFIG_CFL_BUDGET)
+    int32_t ret = 0;
+    cfl_budget_watch_t watch;
+
+    ret = cfl_budget_begin(&watch, ((const cfl_message_t *)rqst->data)->cmd_id);
+    if (ret < 0)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Handler refused, command is quarantined");
+        return ret;
+    }
+
+    ret = call_handler(src_node, handler, rqst, rply);
+    (void)cfl_budget_end(&watch);
+
+    return ret;
+#else
+    return call_handler(src_node, handler, rqst, rply);
+#endif
 }
 
 static uint8_t *custom_malloc(size_t size)
@@ -129,7 +1039,7 @@ static uint8_t *custom_malloc(size_t size)
         pkt = danp_buffer_get();
         if (NULL == pkt)
         {
-            CFL_SERVICE_LOG_ERR("Failed to allocate packet for custom malloc");
+            CFL_SERVICE_LOG_ERR_RL("Failed to allocate packet for custom malloc");
             return NULL;
         }
 
@@ -168,49 +1078,75 @@ static int32_t handle_request_message(
     danp_packet_t **status_pkt)
 {
     int32_t ret = 0;
-    const struct tmtc_cmd_handler *handler = NULL;
+    cfl_service_danp_handler_t handler;
+    bool found = false;
     struct tmtc_args rqst = {0};
     struct tmtc_args rply = {0};
 
-    CFL_SERVICE_LOG_DBG("Handling request message");
+    CFL_SERVICE_LOG_VER("Handling request message");
 
     /* Find handler for this request ID */
-    handler = tmtc_get_cmd_handler(rqst_msg->cmd_id);
-    if (NULL == handler)
+    found = find_handler(rqst_msg->cmd_id, &handler);
+    CFL_TRACE_STAMP(context.current.trace, CFL_TRACE_LOOKUP);
+    if (!found)
     {
         ret = -EINVAL;
-        CFL_SERVICE_LOG_ERR("No handler found for request ID: %d", rqst_msg->cmd_id);
+        CFL_SERVICE_LOG_ERR_RL("No handler found for request ID: %d", rqst_msg->cmd_id);
         /* No handler - send NACK */
-        *status_pkt = create_nack_packet(rqst_msg->cmd_id, rqst_msg->seq, ret);
-        if (*status_pkt == NULL)
-        {
-            ret = -ENOMEM;
-        }
+        *status_pkt = rewrite_as_status(rqst_pkt, CFL_F_NACK, ret);
+        return ret;
+    }
+
+    if (!stream_allows(&handler))
+    {
+        put_handler(&handler);
+        ret = -ENOTSUP;
+        *status_pkt = rewrite_as_status(rqst_pkt, CFL_F_NACK, ret);
         return ret;
     }
 
-    CFL_SERVICE_LOG_DBG("Executing handler for request ID: %d", rqst_msg->cmd_id);
+    CFL_SERVICE_LOG_VER("Executing handler for request ID: %d", rqst_msg->cmd_id);
     setup_tmtc_args(&rqst, &rply, rqst_msg, rqst_pkt->length);
 
-    ret = tmtc_run_handler(handler, &rqst, &rply);
+    ret = run_handler(context.current.src_node, &handler, &rqst, &rply);
+    put_handler(&handler);
+    CFL_TRACE_STAMP(context.current.trace, CFL_TRACE_EXEC);
+
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+    if (context.current.deferred)
+    {
+        if (NULL != rply.data)
+        {
+            CFL_SERVICE_LOG_WRN("Deferred handler returned reply data, dropping it");
+            danp_buffer_free((danp_packet_t *)(rply.data - offsetof(danp_packet_t, payload)));
+            rply.data = NULL;
+        }
+
+        if (ret >= 0)
+        {
+            /* Final status is sent by cfl_service_danp_complete() */
+            CFL_SERVICE_LOG_VER("Reply deferred for request ID: %d", rqst_msg->cmd_id);
+            return ret;
+        }
+
+        release_pending(context.current.deferred_slot);
+    }
+#endif
+
     if (ret < 0)
     {
-        CFL_SERVICE_LOG_ERR("Handler execution failed with error: %d", ret);
-        *status_pkt = create_nack_packet(rqst_msg->cmd_id, rqst_msg->seq, ret);
-        if (*status_pkt == NULL)
+        CFL_SERVICE_LOG_ERR_RL("Handler execution failed with error: %d", ret);
+        if (NULL != rply.data)
         {
-            ret = -ENOMEM;
+            danp_buffer_free((danp_packet_t *)(rply.data - offsetof(danp_packet_t, payload)));
         }
+        *status_pkt = rewrite_as_status(rqst_pkt, CFL_F_NACK, ret);
         return ret;
     }
 
     if (NULL == rply.data)
     {
-        *status_pkt = create_ack_packet(rqst_msg->cmd_id, rqst_msg->seq);
-        if (*status_pkt == NULL)
-        {
-            ret = -ENOMEM;
-        }
+        *status_pkt = rewrite_as_status(rqst_pkt, CFL_F_ACK, 0);
     }
     else
     {
@@ -227,25 +1163,35 @@ static int32_t handle_request_message(
 static int32_t handle_push_message(danp_packet_t *rqst_pkt, cfl_message_t *rqst_msg)
 {
     int32_t ret = 0;
-    const struct tmtc_cmd_handler *handler = NULL;
+    cfl_service_danp_handler_t handler;
+    bool found = false;
     struct tmtc_args rqst = {0};
     struct tmtc_args rply = {0};
 
-    CFL_SERVICE_LOG_DBG("Handling push message");
+    CFL_SERVICE_LOG_VER("Handling push message");
 
     /* Find handler for this push ID */
-    handler = tmtc_get_cmd_handler(rqst_msg->cmd_id);
-    if (NULL == handler)
+    found = find_handler(rqst_msg->cmd_id, &handler);
+    CFL_TRACE_STAMP(context.current.trace, CFL_TRACE_LOOKUP);
+    if (!found)
     {
-        CFL_SERVICE_LOG_ERR("No handler found for push ID: %d", rqst_msg->cmd_id);
+        CFL_SERVICE_LOG_ERR_RL("No handler found for push ID: %d", rqst_msg->cmd_id);
         /* No handler - ignore push */
         return ret;
     }
 
-    CFL_SERVICE_LOG_DBG("Executing handler for push ID: %d", rqst_msg->cmd_id);
+    if (!stream_allows(&handler))
+    {
+        put_handler(&handler);
+        return -ENOTSUP;
+    }
+
+    CFL_SERVICE_LOG_VER("Executing handler for push ID: %d", rqst_msg->cmd_id);
     setup_tmtc_args(&rqst, &rply, rqst_msg, rqst_pkt->length);
 
-    ret = tmtc_run_handler(handler, &rqst, &rply);
+    ret = run_handler(context.current.src_node, &handler, &rqst, &rply);
+    put_handler(&handler);
+    CFL_TRACE_STAMP(context.current.trace, CFL_TRACE_EXEC);
 
     /* Push messages do not expect a reply */
     if (NULL != rply.data)
@@ -256,18 +1202,115 @@ static int32_t handle_push_message(danp_packet_t *rqst_pkt, cfl_message_t *rqst_
     return ret;
 }
 
+#if defined(CONFIG_CFL_ROUTER)
+/* Returns true if the router took care of the message, either sent on, refused or dropped */
+static bool route_message(
+    uint16_t src_node,
+    uint16_t src_port,
+    danp_packet_t *pkt,
+    cfl_message_t *msg,
+    danp_packet_t **status_pkt)
+{
+    int32_t ret = 0;
+    cfl_router_hop_t next = {0};
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+    bool reliable = (msg->flags & CFL_EXT_F_PUSH_RELIABLE) == CFL_EXT_F_PUSH_RELIABLE;
+    uint16_t seq = msg->seq;
+    uint16_t first_seq = 0;
+    uint16_t count = 0;
+
+    /* Cumulative ACKs only concern the neighbour that sent them */
+    if (msg->cmd_id == CFL_EXT_CMD_PUSH_ACK && !(msg->flags & (CFL_F_RQST | CFL_F_PUSH)))
+    {
+        return false;
+    }
+#endif
+
+    /* A reliable push carries CFL_F_ACK too, it is not a reply */
+    if (!(msg->flags & CFL_F_PUSH) && (msg->flags & (CFL_F_ACK | CFL_F_NACK | CFL_F_RPLY)))
+    {
+        ret = cfl_router_return(src_node, msg, &next);
+    }
+    else
+    {
+        ret = cfl_router_forward(src_node, src_port, context.current.compact, msg, &next);
+    }
+
+    if (ret == -ENOENT)
+    {
+        return false;
+    }
+
+    /* Stamped by the far node, the client would file its clock under this one */
+    if (ret == 0 && (msg->flags & CFL_F_RQST))
+    {
+        msg->flags &= (uint8_t)~CFL_EXT_F_TIMESTAMP;
+    }
+
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+    /*
+     * Acknowledged hop by hop: this node retransmits to the next hop under its
+     * own numbering and only acknowledges the sender once the push is held
+     */
+    if (ret == 0 && reliable)
+    {
+        ret = queue_push_reliable(next.node, next.port, msg->cmd_id, msg->data, msg->length);
+        if (ret < 0)
+        {
+            /* Not acknowledged, the sender retransmits it */
+            CFL_SERVICE_LOG_ERR_RL(
+                "Failed to route reliable push %d from node %d: %d", seq, src_node, ret);
+            return true;
+        }
+
+        if (note_reliable_push(src_node, src_port, seq, &first_seq, &count))
+        {
+            send_push_ack(src_node, src_port, first_seq, count);
+        }
+        return true;
+    }
+#endif
+
+    if (ret < 0)
+    {
+        CFL_SERVICE_LOG_ERR_RL(
+            "Failed to route ID %d from node %d: %d", msg->cmd_id, src_node, ret);
+        if (msg->flags & CFL_F_RQST)
+        {
+            *status_pkt = rewrite_as_status(pkt, CFL_F_NACK, ret);
+        }
+        return true;
+    }
+
+    /* The packet goes out as received, only the header sequence may have changed */
+    CFL_SERVICE_LOG_VER("Routing ID %d to node %d port %d", msg->cmd_id, next.node, next.port);
+    pack_if_compact(pkt, next.compact);
+    CFL_CAPTURE_PACKET(CFL_CAPTURE_DIR_TX, next.node, next.port, pkt);
+    pkt = CFL_BUF_TO_DANP(pkt);
+    if (pkt != NULL)
+    {
+        context.transport->send_to(context.socket, pkt, next.node, next.port);
+    }
+    context.current.forwarded = true;
+
+    return true;
+}
+#endif
+
 static int32_t send_cfl_message(
     uint16_t dst_node,
     uint16_t dst_port,
     uint16_t id,
     uint8_t flags,
     const uint8_t *payload,
-    uint16_t payload_len)
+    uint16_t payload_len,
+    uint16_t *seq_out)
 {
     int32_t ret = 0;
     danp_packet_t *pkt = NULL;
     cfl_message_t *msg = NULL;
     int32_t sent_len = 0;
+    uint16_t seq = 0;
 
     if (!context.initialized)
     {
@@ -293,125 +1336,588 @@ static int32_t send_cfl_message(
     msg->version = CFL_VERSION;
     msg->flags = flags;
     msg->cmd_id = id;
-    msg->seq = 0; /* Sequence number tracking not implemented */
+    /* Numbered like cfl_transaction() requests, so receivers can drop duplicates */
+    seq = (flags & CFL_F_RQST) ? cfl_next_seq() : 0;
+    msg->seq = seq;
     msg->length = payload_len;
     if (msg->length > 0)
     {
         memcpy(msg->data, payload, msg->length);
     }
     pkt->length = CFL_HEADER_SIZE + msg->length;
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+    pack_if_compact(pkt, cfl_compact_peer_enabled(dst_node));
+#endif
 
-    sent_len = danp_send_packet_to(context.socket, pkt, dst_node, dst_port);
+    sent_len = context.transport->send_to(context.socket, pkt, dst_node, dst_port);
     if (sent_len < 0)
     {
-        CFL_SERVICE_LOG_ERR("Failed to send packet");
+        CFL_SERVICE_LOG_ERR_RL("Failed to send packet");
         return -EIO;
     }
 
-    CFL_SERVICE_LOG_DBG("Sent message to node %d port %d, id %d", dst_node, dst_port, id);
+    if (seq_out != NULL)
+    {
+        *seq_out = seq;
+    }
+
+    CFL_SERVICE_LOG_VER("Sent message to node %d port %d, id %d", dst_node, dst_port, id);
+    return ret;
+}
+
+static int32_t dispatch_message(
+    uint16_t src_node,
+    uint16_t src_port,
+    danp_packet_t *rqst_pkt,
+    danp_packet_t **rply_pkt,
+    danp_packet_t **status_pkt)
+{
+    int32_t ret = 0;
+    cfl_message_t *rqst_msg = NULL;
+#if defined(CONFIG_CFL_SESSION)
+    cfl_session_verdict_t verdict = CFL_SESSION_NEW;
+#endif
+
+    if (rqst_pkt == NULL || rqst_pkt->length < CFL_HEADER_SIZE)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Request packet is NULL or too short");
+        context.stats.rx_invalid++;
+        return -EINVAL;
+    }
+
+    rqst_msg = (cfl_message_t *)rqst_pkt->payload;
+
+    /* Validate complete message including CRC */
+    if (rqst_pkt->length != (CFL_HEADER_SIZE + rqst_msg->length))
+    {
+        CFL_SERVICE_LOG_ERR_RL("Incomplete message received");
+        context.stats.rx_invalid++;
+        return -EINVAL;
+    }
+
+    CFL_TRACE_SET_CMD(context.current.trace, rqst_msg->cmd_id);
+
+#if defined(CONFIG_CFL_LATENCY)
+    /* Stream responses are written by the stream server and go out unstamped */
+    context.current.timestamp = !context.current.stream && (rqst_msg->flags & CFL_F_RQST) &&
+                                (rqst_msg->flags & CFL_EXT_F_TIMESTAMP);
+#endif
+
+#if defined(CONFIG_CFL_SESSION)
+    /* Dropped before any routing or handler work, a stream delivers each frame once */
+    verdict = context.current.stream ? CFL_SESSION_NEW
+                                     : cfl_session_accept(src_node, src_port, rqst_msg);
+    if (verdict != CFL_SESSION_NEW)
+    {
+        CFL_SERVICE_LOG_VER(
+            "%s message from node %d, seq: %d",
+            (verdict == CFL_SESSION_STALE) ? "Stale" : "Duplicate",
+            src_node,
+            rqst_msg->seq);
+        context.stats.duplicates++;
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+        /* The ACK of the first copy was lost, the sender waits for another one. A stale
+         * push was never received, acknowledging it would lose it. */
+        if (verdict == CFL_SESSION_DUPLICATE && (rqst_msg->flags & CFL_F_PUSH) &&
+            (rqst_msg->flags & CFL_F_ACK))
+        {
+            *status_pkt = ack_reliable_push(src_node, src_port, rqst_msg->seq, rqst_pkt);
+        }
+#endif
+        /* Answered, so the client fails at once rather than after its timeout */
+        if (rqst_msg->flags & CFL_F_RQST)
+        {
+            *status_pkt = rewrite_as_status(rqst_pkt, CFL_F_NACK, -EALREADY);
+        }
+        return -EALREADY;
+    }
+#endif
+
+#if defined(CONFIG_CFL_SERVICE_RATE_LIMIT)
+    /* Throttled before routing too, a gateway must not relay a flood to the next hop.
+     * Responses answer traffic this node sent, they are never limited. */
+    if ((rqst_msg->flags & (CFL_F_RQST | CFL_F_PUSH)) &&
+        !cfl_ratelimit_allow(src_node, rqst_msg->cmd_id))
+    {
+        CFL_SERVICE_LOG_VER(
+            "Rate limited message from node %d, ID: %d", src_node, rqst_msg->cmd_id);
+        context.stats.rate_limited++;
+#if defined(CONFIG_CFL_SERVICE_RATE_LIMIT_NACK)
+        if (rqst_msg->flags & CFL_F_RQST)
+        {
+            *status_pkt = rewrite_as_status(rqst_pkt, CFL_F_NACK, -EBUSY);
+        }
+#endif
+        return -EBUSY;
+    }
+#else
+    (void)src_node;
+#endif
+
+#if defined(CONFIG_CFL_ROUTER)
+    if (!context.current.stream &&
+        route_message(src_node, src_port, rqst_pkt, rqst_msg, status_pkt))
+    {
+        return 0;
+    }
+#endif
+
+    context.current.src_node = src_node;
+    context.current.src_port = src_port;
+    context.current.cmd_id = rqst_msg->cmd_id;
+    context.current.seq = rqst_msg->seq;
+    context.current.is_request = (rqst_msg->flags & CFL_F_RQST) != 0;
+    context.current.deferred = false;
+    context.current.dispatcher = k_current_get();
+
+    /* Handle based on message type */
+    if (rqst_msg->flags & CFL_F_RQST)
+    {
+        context.stats.rx_requests++;
+        ret = handle_request_message(rqst_pkt, rqst_msg, rply_pkt, status_pkt);
+    }
+    else if (rqst_msg->flags & CFL_F_PUSH)
+    {
+        context.stats.rx_pushes++;
+        ret = handle_push_message(rqst_pkt, rqst_msg);
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+        /* Acknowledged once received, whatever the handler made of it. A stream
+         * delivers reliably already and has no port for a delayed ACK. */
+        if ((rqst_msg->flags & CFL_F_ACK) && !context.current.stream)
+        {
+            *status_pkt =
+                ack_reliable_push(src_node, src_port, context.current.seq, rqst_pkt);
+        }
+#endif
+    }
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+    else if ((rqst_msg->flags & CFL_F_ACK) && rqst_msg->cmd_id == CFL_EXT_CMD_PUSH_ACK)
+    {
+        ret = release_acked_pushes(src_node, rqst_msg);
+    }
+#endif
+    else
+    {
+        CFL_SERVICE_LOG_ERR_RL("Unknown message flag");
+        context.stats.rx_invalid++;
+        ret = -EINVAL;
+    }
+
+    context.current.is_request = false;
+    context.current.dispatcher = NULL;
+
     return ret;
 }
 
 /* Public Functions */
 
-static int32_t cfl_process_message(
+int32_t cfl_process_message(
+    uint16_t src_node,
+    uint16_t src_port,
     danp_packet_t *rqst_pkt,
     danp_packet_t **rply_pkt,
     danp_packet_t **status_pkt)
 {
     int32_t ret = 0;
-    cfl_message_t *rqst_msg = NULL;
 
-    CFL_SERVICE_LOG_DBG("Processing message");
+    CFL_SERVICE_LOG_VER("Processing message");
 
-    if (rqst_pkt == NULL || rqst_pkt->length < CFL_HEADER_SIZE)
+    context.current.compact = false;
+    context.current.forwarded = false;
+    context.current.timestamp = false;
+#if defined(CONFIG_CFL_COMPACT_HEADER)
+    ret = cfl_compact_expand(rqst_pkt);
+    if (ret < 0)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Malformed compact header from node %d", src_node);
+        context.stats.rx_invalid++;
+        return ret;
+    }
+
+    if (ret > 0)
+    {
+        /* A peer sending compact frames accepts them too */
+        context.stats.rx_compact++;
+        context.current.compact = true;
+        cfl_compact_learn_peer(src_node);
+    }
+#endif
+
+    ret = dispatch_message(src_node, src_port, rqst_pkt, rply_pkt, status_pkt);
+
+    /* Replies mirror the header format of the request */
+    pack_if_compact(*status_pkt, context.current.compact);
+    pack_if_compact(*rply_pkt, context.current.compact);
+
+    CFL_SERVICE_LOG_VER("Message processing completed with result: %d", ret);
+    return ret;
+}
+
+/* Appends the serving times to a response if its request asked for them */
+static void stamp_response(cfl_service_danp_ctx_t *ctx, danp_packet_t *pkt)
+{
+#if defined(CONFIG_CFL_LATENCY)
+    /* Sent without them when they do not fit, the client only misses a sample */
+    if (ctx->current.timestamp && cfl_latency_stamp(pkt, ctx->current.rx_us) < 0)
+    {
+        CFL_SERVICE_LOG_VER("No room for timestamps in response");
+    }
+#else
+    (void)ctx;
+    (void)pkt;
+#endif
+}
+
+/* Dispatches one received packet and sends its responses */
+static void serve_packet(
+    cfl_service_danp_ctx_t *ctx,
+    danp_packet_t *rqst_pkt,
+    uint16_t src_node,
+    uint16_t src_port)
+{
+    danp_packet_t *rply_pkt = NULL;
+    danp_packet_t *status_pkt = NULL;
+
+    (void)k_mutex_lock(&dispatch_lock, K_FOREVER);
+    CFL_SERVICE_LOG_VER("Received packet from node: %d, port: %d", src_node, src_port);
+    ctx->current.trace = CFL_TRACE_BEGIN(CFL_TRACE_KIND_SERVICE, src_node);
+#if defined(CONFIG_CFL_LATENCY)
+    ctx->current.rx_us = cfl_latency_now_us();
+#endif
+    ctx->stats.rx_packets++;
+    /* Captured first, processing may rewrite the request into its status reply */
+    CFL_CAPTURE_PACKET(CFL_CAPTURE_DIR_RX, src_node, src_port, rqst_pkt);
+    cfl_process_message(src_node, src_port, rqst_pkt, &rply_pkt, &status_pkt);
+    CFL_TRACE_STAMP(ctx->current.trace, CFL_TRACE_BUILD);
+
+    /* Status replies reuse the request buffer and routed packets are already sent */
+    if (status_pkt != rqst_pkt && !ctx->current.forwarded)
+    {
+        CFL_BUF_FREE(rqst_pkt);
+    }
+
+    if (NULL != status_pkt)
+    {
+        CFL_SERVICE_LOG_VER("Sending status packet to node: %d, port: %d", src_node, src_port);
+        CFL_CAPTURE_PACKET(CFL_CAPTURE_DIR_TX, src_node, src_port, status_pkt);
+        /* A request queued in a small buffer is copied out only now, to be sent */
+        status_pkt = CFL_BUF_TO_DANP(status_pkt);
+        if (NULL != status_pkt)
+        {
+            stamp_response(ctx, status_pkt);
+            ctx->transport->send_to(ctx->socket, status_pkt, src_node, src_port);
+        }
+    }
+
+    if (NULL != rply_pkt)
+    {
+        CFL_SERVICE_LOG_VER("Sending reply packet to node: %d, port: %d", src_node, src_port);
+        CFL_CAPTURE_PACKET(CFL_CAPTURE_DIR_TX, src_node, src_port, rply_pkt);
+        stamp_response(ctx, rply_pkt);
+        ctx->transport->send_to(ctx->socket, rply_pkt, src_node, src_port);
+    }
+
+    if (NULL != ctx->current.trace)
+    {
+        CFL_TRACE_STAMP(ctx->current.trace, CFL_TRACE_TX);
+        CFL_TRACE_END(ctx->current.trace);
+        ctx->current.trace = NULL;
+    }
+    (void)k_mutex_unlock(&dispatch_lock);
+}
+
+#if defined(CONFIG_CFL_STREAM)
+int32_t cfl_service_danp_serve_stream(
+    uint16_t src_node,
+    danp_packet_t *rqst_pkt,
+    danp_packet_t **rply_pkt,
+    danp_packet_t **status_pkt)
+{
+    int32_t ret = 0;
+
+    /* Running already while the service is still being initialized */
+    if (!context.running)
     {
-        CFL_SERVICE_LOG_ERR("Request packet is NULL or too short");
-        return -EINVAL;
+        danp_buffer_free(rqst_pkt);
+        return -EAGAIN;
     }
 
-    rqst_msg = (cfl_message_t *)rqst_pkt->payload;
+    (void)k_mutex_lock(&dispatch_lock, K_FOREVER);
 
-    /* Validate complete message including CRC */
-    if (rqst_pkt->length != (CFL_HEADER_SIZE + rqst_msg->length))
+    context.stats.rx_packets++;
+    context.current.stream = true;
+    ret = cfl_process_message(src_node, 0, rqst_pkt, rply_pkt, status_pkt);
+    context.current.stream = false;
+
+    if (*status_pkt != rqst_pkt && !context.current.forwarded)
     {
-        CFL_SERVICE_LOG_ERR("Incomplete message received");
-        return -EINVAL;
+        danp_buffer_free(rqst_pkt);
     }
 
-    /* Handle based on message type */
-    if (rqst_msg->flags & CFL_F_RQST)
+    (void)k_mutex_unlock(&dispatch_lock);
+
+    return ret;
+}
+#endif
+
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+static void enqueue_packet(
+    cfl_service_danp_ctx_t *ctx,
+    danp_packet_t *pkt,
+    uint16_t src_node,
+    uint16_t src_port)
+{
+    /* Short packets wait in a small buffer and give their DANP buffer back at once */
+    pkt = CFL_BUF_SHRINK(pkt, RX_QUEUED_CAPACITY(pkt->length));
+
+    if (cfl_spsc_push(&ctx->rx_ring, pkt, RX_RING_TAG(src_node, src_port)) < 0)
     {
-        ret = handle_request_message(rqst_pkt, rqst_msg, rply_pkt, status_pkt);
+        ctx->stats.rx_dropped++;
+        CFL_SERVICE_LOG_ERR_RL("RX ring full, packet from node %d dropped", src_node);
+        CFL_BUF_FREE(pkt);
+        return;
     }
-    else if (rqst_msg->flags & CFL_F_PUSH)
+
+    /* Only pay for a wake-up when the processing thread is going to sleep */
+    if (atomic_cas(&ctx->proc_waiting, 1, 0))
     {
-        ret = handle_push_message(rqst_pkt, rqst_msg);
+        k_sem_give(&ctx->rx_ready);
     }
-    else
+}
+
+static void cfl_service_danp_proc_task(void *arg, void *unused1, void *unused2)
+{
+    cfl_service_danp_ctx_t *ctx = (cfl_service_danp_ctx_t *)arg;
+    cfl_spsc_entry_t batch[CFL_SERVICE_RX_BATCH];
+    size_t count = 0;
+
+    while (ctx->running)
     {
-        CFL_SERVICE_LOG_ERR("Unknown message flag");
-        ret = -EINVAL;
+        count = cfl_spsc_pop_batch(&ctx->rx_ring, batch, ARRAY_SIZE(batch));
+        for (size_t i = 0; i < count; i++)
+        {
+            serve_packet(
+                ctx,
+                (danp_packet_t *)batch[i].ptr,
+                RX_RING_TAG_NODE(batch[i].tag),
+                RX_RING_TAG_PORT(batch[i].tag));
+        }
+
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+        expire_pending();
+#endif
+
+        if (count == 0)
+        {
+            atomic_set(&ctx->proc_waiting, 1);
+            /* Checked again after announcing the sleep, a push may have raced the empty pop */
+            if (cfl_spsc_count(&ctx->rx_ring) == 0)
+            {
+                (void)k_sem_take(&ctx->rx_ready, K_MSEC(CFL_DANP_RX_TIMEOUT_MS));
+            }
+            atomic_set(&ctx->proc_waiting, 0);
+        }
     }
 
-    CFL_SERVICE_LOG_DBG("Message processing completed with result: %d", ret);
-    return ret;
+    ARG_UNUSED(unused1);
+    ARG_UNUSED(unused2);
+
+    CFL_SERVICE_LOG_DBG("Processing task exiting");
 }
+#endif
 
-static void cfl_service_danp_rx_task(void *arg)
+static void cfl_service_danp_rx_task(void *arg, void *unused1, void *unused2)
 {
     cfl_service_danp_ctx_t *ctx = (cfl_service_danp_ctx_t *)arg;
     danp_packet_t *rqst_pkt = NULL;
-    danp_packet_t *rply_pkt = NULL;
-    danp_packet_t *status_pkt = NULL;
     uint16_t src_node = 0;
     uint16_t src_port = 0;
 
     while (ctx->running)
     {
+        rqst_pkt = ctx->transport->recv_from(
+            ctx->socket, &src_node, &src_port, CFL_DANP_RX_TIMEOUT_MS);
+
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+        if (NULL != rqst_pkt)
+        {
+            enqueue_packet(ctx, rqst_pkt, src_node, src_port);
+        }
+#else
         if (NULL != rqst_pkt)
         {
-            CFL_SERVICE_LOG_DBG("Freeing previous request packet");
-            danp_buffer_free(rqst_pkt);
-            rqst_pkt = NULL;
+            serve_packet(ctx, rqst_pkt, src_node, src_port);
         }
 
-        rply_pkt = NULL;
-        status_pkt = NULL;
-        rqst_pkt = danp_recv_packet_from(ctx->socket, &src_node, &src_port, CFL_DANP_RX_TIMEOUT_MS);
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+        expire_pending();
+#endif
+#endif
+    }
 
-        if (NULL != rqst_pkt)
+    ARG_UNUSED(unused1);
+    ARG_UNUSED(unused2);
+
+    CFL_SERVICE_LOG_DBG("RX task exiting");
+}
+
+static void free_rx_stack(void)
+{
+#if defined(CONFIG_DYNAMIC_THREAD)
+    if (context.rx_stack_dynamic != NULL)
+    {
+        (void)k_thread_stack_free(context.rx_stack_dynamic);
+        context.rx_stack_dynamic = NULL;
+    }
+#endif
+}
+
+/* Created suspended so the CPU mask can be applied before it first runs */
+static int32_t start_rx_thread(const cfl_thread_attr_t *attr)
+{
+    int32_t ret = 0;
+    k_thread_stack_t *stack = rx_stack;
+    size_t stack_size = K_THREAD_STACK_SIZEOF(rx_stack);
+    int32_t priority = CFL_DANP_RX_TASK_PRIORITY;
+    uint32_t cpu_mask = CONFIG_CFL_SERVICE_RX_CPU_MASK;
+
+    if (attr != NULL)
+    {
+        priority = attr->priority;
+        cpu_mask = attr->cpu_mask;
+        if (attr->stack_size != 0)
         {
-            CFL_SERVICE_LOG_DBG("Received packet from node: %d, port: %d", src_node, src_port);
-            cfl_process_message(rqst_pkt, &rply_pkt, &status_pkt);
+            stack_size = attr->stack_size;
         }
+    }
 
-        if (NULL != status_pkt)
+    if (stack_size > K_THREAD_STACK_SIZEOF(rx_stack))
+    {
+#if defined(CONFIG_DYNAMIC_THREAD)
+        stack = k_thread_stack_alloc(stack_size, 0);
+        if (stack == NULL)
         {
-            CFL_SERVICE_LOG_DBG("Sending status packet to node: %d, port: %d", src_node, src_port);
-            danp_send_packet_to(ctx->socket, status_pkt, src_node, src_port);
+            CFL_SERVICE_LOG_ERR("Failed to allocate RX stack of %u bytes", (uint32_t)stack_size);
+            return -ENOMEM;
         }
+        context.rx_stack_dynamic = stack;
+#else
+        CFL_SERVICE_LOG_ERR(
+            "RX stack larger than %u bytes needs CONFIG_DYNAMIC_THREAD",
+            (uint32_t)K_THREAD_STACK_SIZEOF(rx_stack));
+        return -EINVAL;
+#endif
+    }
+
+    context.rx_tid = k_thread_create(
+        &context.rx_thread,
+        stack,
+        stack_size,
+        cfl_service_danp_rx_task,
+        &context,
+        NULL,
+        NULL,
+        priority,
+        0,
+        K_FOREVER);
+    k_thread_name_set(context.rx_tid, "cfl_rx");
+
+    ret = cfl_thread_set_cpu_mask(context.rx_tid, cpu_mask);
+    if (ret < 0)
+    {
+        CFL_SERVICE_LOG_ERR("Failed to set RX thread CPU mask 0x%x: %d", cpu_mask, ret);
+        k_thread_abort(context.rx_tid);
+        context.rx_tid = NULL;
+        free_rx_stack();
+        return ret;
+    }
+
+    k_thread_start(context.rx_tid);
+
+    return 0;
+}
 
-        if (NULL != rply_pkt)
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+static int32_t start_proc_thread(const cfl_thread_attr_t *attr)
+{
+    int32_t ret = 0;
+    size_t stack_size = K_THREAD_STACK_SIZEOF(proc_stack);
+    int32_t priority = CONFIG_CFL_SERVICE_PROC_PRIORITY;
+    uint32_t cpu_mask = CONFIG_CFL_SERVICE_PROC_CPU_MASK;
+
+    if (attr != NULL)
+    {
+        priority = attr->priority;
+        cpu_mask = attr->cpu_mask;
+        if (attr->stack_size > stack_size)
         {
-            CFL_SERVICE_LOG_DBG("Sending reply packet to node: %d, port: %d", src_node, src_port);
-            danp_send_packet_to(ctx->socket, rply_pkt, src_node, src_port);
+            CFL_SERVICE_LOG_ERR(
+                "Processing stack larger than %u bytes, raise CONFIG_CFL_SERVICE_PROC_STACK_SIZE",
+                (uint32_t)stack_size);
+            return -EINVAL;
         }
     }
 
-    CFL_SERVICE_LOG_DBG("RX task exiting");
-    osal_thread_delete(context.rx_task_handle);
+    (void)cfl_spsc_init(&context.rx_ring, rx_ring_slots, CFL_SERVICE_RX_RING_SIZE);
+    k_sem_init(&context.rx_ready, 0, 1);
+    atomic_set(&context.proc_waiting, 0);
+
+    context.proc_tid = k_thread_create(
+        &context.proc_thread,
+        proc_stack,
+        stack_size,
+        cfl_service_danp_proc_task,
+        &context,
+        NULL,
+        NULL,
+        priority,
+        0,
+        K_FOREVER);
+    k_thread_name_set(context.proc_tid, "cfl_proc");
+
+    ret = cfl_thread_set_cpu_mask(context.proc_tid, cpu_mask);
+    if (ret < 0)
+    {
+        CFL_SERVICE_LOG_ERR("Failed to set processing thread CPU mask 0x%x: %d", cpu_mask, ret);
+        k_thread_abort(context.proc_tid);
+        context.proc_tid = NULL;
+        return ret;
+    }
+
+    k_thread_start(context.proc_tid);
+
+    return 0;
+}
+
+static void stop_proc_thread(void)
+{
+    cfl_spsc_entry_t entry;
+
+    if (context.proc_tid == NULL)
+    {
+        return;
+    }
+
+    context.running = false;
+    k_sem_give(&context.rx_ready);
+    if (k_thread_join(&context.proc_thread, K_MSEC(CFL_DANP_RX_TIMEOUT_MS * 2)) != 0)
+    {
+        CFL_SERVICE_LOG_WRN("Processing task did not stop in time, aborting it");
+        k_thread_abort(context.proc_tid);
+    }
+    context.proc_tid = NULL;
+
+    /* The RX task is gone as well, release what it queued after the last pop */
+    while (cfl_spsc_pop_batch(&context.rx_ring, &entry, 1) == 1)
+    {
+        CFL_BUF_FREE((danp_packet_t *)entry.ptr);
+    }
 }
+#endif
 
 int32_t cfl_service_danp_init(const cfl_service_danp_config_t *config)
 {
     int32_t ret = 0;
-    bool is_socket_created = false;
-    osal_thread_attr_t task_attr = {
-        .name = "cfl_rx",
-        .priority = CFL_DANP_RX_TASK_PRIORITY,
-        .stack_size = CFL_DANP_RX_TASK_STACK_SIZE,
-    };
 
     for (;;)
     {
@@ -431,34 +1937,47 @@ int32_t cfl_service_danp_init(const cfl_service_danp_config_t *config)
 
         memset(&context, 0, sizeof(context));
         context.local_port = config->port_id;
+        context.transport = (config->transport != NULL) ? config->transport : cfl_transport_get();
 
-        context.socket = danp_socket(DANP_TYPE_DGRAM);
-        if (context.socket == NULL)
+        ret = context.transport->open(&context.socket, context.local_port);
+        if (ret < 0)
         {
-            CFL_SERVICE_LOG_ERR("Failed to create socket");
-            ret = -ENOMEM;
+            CFL_SERVICE_LOG_ERR("Failed to open %s socket: %d", context.transport->name, ret);
+            context.socket = NULL;
             break;
         }
-        is_socket_created = true;
+        context.running = true;
 
-        ret = danp_bind(context.socket, context.local_port);
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+        /* Started first so the ring has a consumer before packets arrive */
+        ret = start_proc_thread(config->proc_thread);
         if (ret < 0)
         {
-            CFL_SERVICE_LOG_ERR("Failed to bind socket");
-            ret = -EADDRNOTAVAIL;
+            CFL_SERVICE_LOG_ERR("Failed to create processing task");
             break;
         }
-        context.running = true;
+#endif
 
-        context.rx_task_handle = osal_thread_create(cfl_service_danp_rx_task, &context, &task_attr);
-        if (context.rx_task_handle == NULL)
+#if defined(CONFIG_CFL_STREAM)
+        ret = cfl_stream_server_start();
+        if (ret < 0)
+        {
+            CFL_SERVICE_LOG_ERR("Failed to start the stream server");
+            break;
+        }
+#endif
+
+        ret = start_rx_thread(config->rx_thread);
+        if (ret < 0)
         {
             CFL_SERVICE_LOG_ERR("Failed to create RX task");
-            ret = -ENOMEM;
             break;
         }
 
-        CFL_SERVICE_LOG_INF("CFL service over DANP initialized on port %d", context.local_port);
+        CFL_SERVICE_LOG_INF(
+            "CFL service over %s initialized on port %d",
+            context.transport->name,
+            context.local_port);
 
         context.initialized = true;
         break;
@@ -466,10 +1985,17 @@ int32_t cfl_service_danp_init(const cfl_service_danp_config_t *config)
 
     if (0 != ret)
     {
-        if (is_socket_created && context.socket != NULL)
+#if defined(CONFIG_CFL_STREAM)
+        cfl_stream_server_stop();
+#endif
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+        stop_proc_thread();
+#endif
+
+        if (context.socket != NULL)
         {
             CFL_SERVICE_LOG_DBG("Closing socket due to initialization failure");
-            danp_close(context.socket);
+            context.transport->close(context.socket);
             context.socket = NULL;
         }
 
@@ -497,15 +2023,37 @@ int32_t cfl_service_danp_deinit(void)
 
         CFL_SERVICE_LOG_DBG("Signaling RX task to stop");
         context.running = false;
-        osal_delay_ms(CFL_DANP_RX_TIMEOUT_MS * 2);
+        if (k_thread_join(&context.rx_thread, K_MSEC(CFL_DANP_RX_TIMEOUT_MS * 2)) != 0)
+        {
+            CFL_SERVICE_LOG_WRN("RX task did not stop in time, aborting it");
+            k_thread_abort(context.rx_tid);
+        }
+        free_rx_stack();
+
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+        CFL_SERVICE_LOG_DBG("Signaling processing task to stop");
+        stop_proc_thread();
+#endif
+
+#if defined(CONFIG_CFL_STREAM)
+        CFL_SERVICE_LOG_DBG("Stopping the stream server");
+        cfl_stream_server_stop();
+#endif
 
         if (context.socket != NULL)
         {
             CFL_SERVICE_LOG_DBG("Closing socket");
-            danp_close(context.socket);
+            context.transport->close(context.socket);
             context.socket = NULL;
         }
 
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+        push_ack_reset();
+#endif
+#if defined(CONFIG_CFL_SESSION)
+        cfl_session_reset();
+#endif
+
         memset(&context, 0, sizeof(context));
         break;
     }
@@ -513,6 +2061,227 @@ int32_t cfl_service_danp_deinit(void)
     return ret;
 }
 
+k_tid_t cfl_service_danp_rx_thread(void)
+{
+    return context.initialized ? context.rx_tid : NULL;
+}
+
+k_tid_t cfl_service_danp_proc_thread(void)
+{
+#if defined(CONFIG_CFL_SERVICE_RX_SPLIT)
+    return context.initialized ? context.proc_tid : NULL;
+#else
+    return NULL;
+#endif
+}
+
+int32_t cfl_service_danp_get_stats(cfl_service_danp_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return -EINVAL;
+    }
+
+    *stats = context.stats;
+    return 0;
+}
+
+int32_t cfl_service_danp_defer(cfl_service_danp_token_t *token)
+{
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+    int32_t ret = -ENOMEM;
+    cfl_service_danp_current_t *current = &context.current;
+    k_spinlock_key_t key;
+
+    if (token == NULL)
+    {
+        return -EINVAL;
+    }
+
+    /* A handler run by cfl_service_danp_execute() would see the message of another thread */
+    if (!current->is_request || current->deferred || current->dispatcher != k_current_get())
+    {
+        CFL_SERVICE_LOG_ERR("Defer is only allowed once from a request handler");
+        return -EINVAL;
+    }
+
+    if (current->stream)
+    {
+        /* The connection may be gone by the time the reply is ready */
+        return -ENOTSUP;
+    }
+
+    key = k_spin_lock(&context.pending_lock);
+    for (uint16_t i = 0; i < CFL_SERVICE_DEFERRED_COUNT; i++)
+    {
+        cfl_service_danp_pending_t *pending = &context.pending[i];
+
+        if (pending->in_use)
+        {
+            continue;
+        }
+
+        pending->in_use = true;
+        pending->generation++;
+        pending->dst_node = current->src_node;
+        pending->dst_port = current->src_port;
+        pending->cmd_id = current->cmd_id;
+        pending->seq = current->seq;
+        pending->compact = current->compact;
+        pending->deadline_ms = k_uptime_get_32() + CONFIG_CFL_SERVICE_DEFERRED_TIMEOUT_MS;
+
+        token->slot = i;
+        token->generation = pending->generation;
+        current->deferred = true;
+        current->deferred_slot = i;
+        ret = 0;
+        break;
+    }
+    k_spin_unlock(&context.pending_lock, key);
+
+    if (ret < 0)
+    {
+        CFL_SERVICE_LOG_ERR("No free deferred reply slot");
+    }
+
+    return ret;
+#else
+    (void)token;
+    return -ENOTSUP;
+#endif
+}
+
+int32_t cfl_service_danp_complete(
+    const cfl_service_danp_token_t *token,
+    int32_t status,
+    const uint8_t *payload,
+    uint16_t payload_len)
+{
+#if defined(CONFIG_CFL_SERVICE_DEFERRED_REPLY)
+    cfl_service_danp_pending_t pending = {0};
+    danp_packet_t *pkt = NULL;
+    cfl_message_t *msg = NULL;
+
+    if (token == NULL || token->slot >= CFL_SERVICE_DEFERRED_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    if (payload_len > 0 && payload == NULL)
+    {
+        CFL_SERVICE_LOG_ERR("Payload is NULL but length is non-zero");
+        return -EINVAL;
+    }
+
+    if (payload_len > (DANP_MAX_PACKET_SIZE - CFL_HEADER_SIZE))
+    {
+        CFL_SERVICE_LOG_ERR("Deferred reply too large: %d", payload_len);
+        return -EMSGSIZE;
+    }
+
+    if (!context.initialized)
+    {
+        CFL_SERVICE_LOG_ERR("Service not initialized");
+        return -EAGAIN;
+    }
+
+    if (!take_pending(token->slot, token->generation, &pending))
+    {
+        CFL_SERVICE_LOG_ERR("Deferred reply token is stale");
+        return -ENOENT;
+    }
+
+    if (status < 0)
+    {
+        pkt = cfl_create_nack_packet(pending.cmd_id, pending.seq, status);
+    }
+    else if (payload_len == 0)
+    {
+        pkt = cfl_create_ack_packet(pending.cmd_id, pending.seq);
+    }
+    else
+    {
+        pkt = danp_buffer_get();
+        if (pkt != NULL)
+        {
+            msg = (cfl_message_t *)pkt->payload;
+            memcpy(msg->data, payload, payload_len);
+            pkt->length = CFL_HEADER_SIZE + payload_len;
+            create_reply_packet(pending.cmd_id, pending.seq, pkt);
+        }
+    }
+
+    if (pkt == NULL)
+    {
+        CFL_SERVICE_LOG_ERR("Failed to allocate deferred reply packet");
+        return -ENOMEM;
+    }
+
+    pack_if_compact(pkt, pending.compact);
+
+    if (context.transport->send_to(context.socket, pkt, pending.dst_node, pending.dst_port) < 0)
+    {
+        CFL_SERVICE_LOG_ERR("Failed to send deferred reply");
+        return -EIO;
+    }
+
+    return 0;
+#else
+    (void)token;
+    (void)status;
+    (void)payload;
+    (void)payload_len;
+    return -ENOTSUP;
+#endif
+}
+
+int32_t cfl_service_danp_execute(uint16_t src_node, cfl_message_t *msg, danp_packet_t **rply_pkt)
+{
+    int32_t ret = 0;
+    cfl_service_danp_handler_t handler;
+    struct tmtc_args rqst = {0};
+    struct tmtc_args rply = {0};
+    danp_packet_t *pkt = NULL;
+
+    if (!find_handler(msg->cmd_id, &handler))
+    {
+        return -ENOENT;
+    }
+
+    setup_tmtc_args(&rqst, &rply, msg, CFL_HEADER_SIZE + msg->length);
+    /* Recursive, a handler may execute another command from the dispatcher itself */
+    (void)k_mutex_lock(&dispatch_lock, K_FOREVER);
+    ret = run_handler(src_node, &handler, &rqst, &rply);
+    (void)k_mutex_unlock(&dispatch_lock);
+    put_handler(&handler);
+
+    if (NULL != rply.data)
+    {
+        pkt = (danp_packet_t *)(rply.data - offsetof(danp_packet_t, payload));
+        pkt->length = rply.len;
+        if (ret < 0 || rply_pkt == NULL || rply.len < CFL_HEADER_SIZE)
+        {
+            danp_buffer_free(pkt);
+        }
+        else
+        {
+            *rply_pkt = pkt;
+        }
+    }
+
+    return ret;
+}
+
+bool cfl_service_danp_has_handler(uint16_t cmd_id)
+{
+    cfl_service_danp_handler_t handler;
+    bool found = find_handler(cmd_id, &handler);
+
+    put_handler(&handler);
+
+    return found;
+}
+
 int32_t cfl_service_danp_send_request(
     uint16_t dst_node,
     uint16_t dst_port,
@@ -521,8 +2290,7 @@ int32_t cfl_service_danp_send_request(
     uint16_t payload_len,
     uint16_t *seq_out)
 {
-    (void)seq_out; /* Sequence number tracking not implemented */
-    return send_cfl_message(dst_node, dst_port, id, CFL_F_RQST, payload, payload_len);
+    return send_cfl_message(dst_node, dst_port, id, CFL_F_RQST, payload, payload_len, seq_out);
 }
 
 int32_t cfl_service_danp_send_push(
@@ -532,5 +2300,37 @@ int32_t cfl_service_danp_send_push(
     const uint8_t *payload,
     uint16_t payload_len)
 {
-    return send_cfl_message(dst_node, dst_port, id, CFL_F_PUSH, payload, payload_len);
-}
\ No newline at end of file
+    return send_cfl_message(dst_node, dst_port, id, CFL_F_PUSH, payload, payload_len, NULL);
+}
+
+#if defined(CONFIG_CFL_SERVICE_PUSH_ACK)
+int32_t cfl_service_danp_send_push_reliable(
+    uint16_t dst_node,
+    uint16_t dst_port,
+    uint16_t id,
+    const uint8_t *payload,
+    uint16_t payload_len)
+{
+    int32_t ret = 0;
+
+    if (!context.initialized)
+    {
+        CFL_SERVICE_LOG_ERR("Service not initialized");
+        return -EAGAIN;
+    }
+
+    if (payload_len > 0 && payload == NULL)
+    {
+        CFL_SERVICE_LOG_ERR("Payload is NULL but length is non-zero");
+        return -EINVAL;
+    }
+
+    ret = queue_push_reliable(dst_node, dst_port, id, payload, payload_len);
+    if (ret < 0)
+    {
+        CFL_SERVICE_LOG_ERR_RL("Reliable push to node %d refused: %d", dst_node, ret);
+    }
+
+    return ret;
+}
+#endif
\ No newline at end of file
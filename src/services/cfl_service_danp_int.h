@@ -0,0 +1,119 @@
+/* cfl_service_danp_int.h - CFL Service over DANP internal interface */
+
+/* All Rights Reserved */
+
+#ifndef INC_CFL_SERVICE_DANP_INT_H
+#define INC_CFL_SERVICE_DANP_INT_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cfl/cfl.h"
+#include "danp/danp_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* External Declarations */
+
+/**
+ * @brief Validate and dispatch one received message
+ *
+ * This is the body of the service RX loop, exposed for benchmarks and tests.
+ * Packets stay owned by the caller. ACK and NACK status replies are written
+ * over the request packet, so when *status_pkt == rqst_pkt the request buffer
+ * is consumed by sending the status and must not be freed separately.
+ * With CONFIG_CFL_ROUTER, packets matching a route are sent on from here and
+ * consumed as well, so the benchmarks and tests calling this run without routes.
+ *
+ * @param src_node   Source node address
+ * @param src_port   Source port
+ * @param rqst_pkt   Received packet
+ * @param rply_pkt   Output reply packet, left untouched if there is none
+ * @param status_pkt Output ACK/NACK packet, left untouched if there is none
+ * @return Handler result or negative error code
+ */
+extern int32_t cfl_process_message(
+    uint16_t src_node,
+    uint16_t src_port,
+    danp_packet_t *rqst_pkt,
+    danp_packet_t **rply_pkt,
+    danp_packet_t **status_pkt);
+
+/**
+ * @brief Allocate an ACK for a request
+ * @param msg_id  Command ID of the request
+ * @param msg_seq Sequence number of the request
+ * @return Packet owned by the caller, NULL if no DANP buffer is available
+ */
+extern danp_packet_t *cfl_create_ack_packet(uint16_t msg_id, uint16_t msg_seq);
+
+/**
+ * @brief Allocate a NACK for a request
+ * @param msg_id     Command ID of the request
+ * @param msg_seq    Sequence number of the request
+ * @param error_code Negative error code carried in the payload
+ * @return Packet owned by the caller, NULL if no DANP buffer is available
+ */
+extern danp_packet_t *cfl_create_nack_packet(uint16_t msg_id, uint16_t msg_seq, int32_t error_code);
+
+/**
+ * @brief Run the handler of a locally built message outside the RX path
+ *
+ * Used by CFL features that invoke handlers on their own schedule. The
+ * handler runs one at a time with the ones dispatched by the service and
+ * cannot defer its reply from here.
+ *
+ * @param src_node Node the message is executed on behalf of
+ * @param msg      Complete request message, header followed by msg->length bytes
+ * @param rply_pkt Output reply packet holding a full CFL header, left untouched
+ *                 if the handler produced none. NULL to discard the reply.
+ * @return Handler result or -ENOENT if no handler is registered
+ */
+extern int32_t cfl_service_danp_execute(
+    uint16_t src_node,
+    cfl_message_t *msg,
+    danp_packet_t **rply_pkt);
+
+/**
+ * @brief Check that a command has a handler, looked up as for dispatch
+ * @param cmd_id Command ID
+ * @return true if a reserved, runtime or tmtc handler serves the command
+ */
+extern bool cfl_service_danp_has_handler(uint16_t cmd_id);
+
+/**
+ * @brief Dispatch a message received by the stream server
+ *
+ * Serialized with the datagram RX path. Handlers cannot defer their reply and
+ * the router is bypassed, a stream ends at the node that accepted it.
+ *
+ * @param src_node   Source node reported to handlers
+ * @param rqst_pkt   Received message with a full header, consumed
+ * @param rply_pkt   Output reply packet owned by the caller, left untouched if there is none
+ * @param status_pkt Output ACK/NACK packet owned by the caller, left untouched if there is none
+ * @return Handler result or negative error code
+ */
+extern int32_t cfl_service_danp_serve_stream(
+    uint16_t src_node,
+    danp_packet_t *rqst_pkt,
+    danp_packet_t **rply_pkt,
+    danp_packet_t **status_pkt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CFL_SERVICE_DANP_INT_H */
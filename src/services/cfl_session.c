@@ -0,0 +1,202 @@
+/* cfl_session.c - Per-peer session state and duplicate detection */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cfl/services/cfl_session.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define SESSION_PEERS (CONFIG_CFL_SESSION_PEERS)
+
+/* Types */
+
+typedef struct session_s
+{
+    bool used;
+    uint16_t node;
+    uint16_t port;
+    uint32_t last_ms;
+    uint32_t rx_msgs;
+    uint32_t rx_bytes;
+    uint32_t duplicates;
+    uint32_t stale;
+    cfl_seq_window_t rqst;
+    cfl_seq_window_t push;
+} session_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static session_t sessions[SESSION_PEERS];
+static cfl_session_stats_t stats;
+
+/* Functions */
+
+static cfl_session_verdict_t window_check(cfl_seq_window_t *window, uint16_t seq)
+{
+    cfl_seq_verdict_t verdict = cfl_seq_window_check(window, seq, CONFIG_CFL_SESSION_RESYNC);
+
+    if (verdict == CFL_SEQ_DUPLICATE)
+    {
+        return CFL_SESSION_DUPLICATE;
+    }
+
+    if (verdict == CFL_SEQ_STALE)
+    {
+        return CFL_SESSION_STALE;
+    }
+
+    if (verdict == CFL_SEQ_RESYNC)
+    {
+        stats.resyncs++;
+    }
+
+    return CFL_SESSION_NEW;
+}
+
+/* Session of node, or the unused or least recently active one started for it */
+static session_t *find_session_locked(uint16_t node, uint32_t now)
+{
+    session_t *oldest = NULL;
+
+    for (size_t i = 0; i < SESSION_PEERS; i++)
+    {
+        if (sessions[i].used && sessions[i].node == node)
+        {
+            return &sessions[i];
+        }
+
+        if (oldest == NULL || !sessions[i].used ||
+            (oldest->used && (now - sessions[i].last_ms) > (now - oldest->last_ms)))
+        {
+            oldest = &sessions[i];
+        }
+    }
+
+    if (oldest->used)
+    {
+        stats.evicted++;
+    }
+    stats.created++;
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->used = true;
+    oldest->node = node;
+
+    return oldest;
+}
+
+cfl_session_verdict_t cfl_session_accept(
+    uint16_t node,
+    uint16_t port,
+    const cfl_message_t *msg)
+{
+    uint32_t now = k_uptime_get_32();
+    cfl_session_verdict_t verdict = CFL_SESSION_NEW;
+    session_t *session = NULL;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    session = find_session_locked(node, now);
+
+    /* A peer silent for long has likely restarted its sequence numbers */
+    if ((now - session->last_ms) > CONFIG_CFL_SESSION_IDLE_MS)
+    {
+        session->rqst.valid = false;
+        session->push.valid = false;
+    }
+
+    session->port = port;
+    session->last_ms = now;
+    session->rx_msgs++;
+    session->rx_bytes += CFL_HEADER_SIZE + msg->length;
+
+    /* Older senders number every request 0, those cannot be told apart */
+    if ((msg->flags & CFL_F_RQST) && msg->seq != 0)
+    {
+        verdict = window_check(&session->rqst, msg->seq);
+    }
+    else if ((msg->flags & CFL_F_PUSH) && (msg->flags & CFL_F_ACK))
+    {
+        verdict = window_check(&session->push, msg->seq);
+    }
+
+    if (verdict == CFL_SESSION_DUPLICATE)
+    {
+        session->duplicates++;
+        stats.duplicates++;
+    }
+    else if (verdict == CFL_SESSION_STALE)
+    {
+        session->stale++;
+        stats.stale++;
+    }
+
+    k_spin_unlock(&lock, key);
+
+    return verdict;
+}
+
+int32_t cfl_session_get(size_t index, cfl_session_info_t *info)
+{
+    const session_t *session = NULL;
+    k_spinlock_key_t key;
+
+    if (index >= SESSION_PEERS)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    session = &sessions[index];
+    if (!session->used)
+    {
+        k_spin_unlock(&lock, key);
+        return -ENOENT;
+    }
+
+    info->node = session->node;
+    info->port = session->port;
+    info->idle_ms = k_uptime_get_32() - session->last_ms;
+    info->rx_msgs = session->rx_msgs;
+    info->rx_bytes = session->rx_bytes;
+    info->duplicates = session->duplicates;
+    info->stale = session->stale;
+    info->rqst_top = session->rqst.top;
+    info->push_top = session->push.top;
+    k_spin_unlock(&lock, key);
+
+    return 0;
+}
+
+void cfl_session_get_stats(cfl_session_stats_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    *out = stats;
+    k_spin_unlock(&lock, key);
+}
+
+void cfl_session_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    memset(sessions, 0, sizeof(sessions));
+    memset(&stats, 0, sizeof(stats));
+    k_spin_unlock(&lock, key);
+}
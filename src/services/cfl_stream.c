@@ -0,0 +1,578 @@
+/* cfl_stream.c - CFL framing over DANP stream sockets */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "danp/danp.h"
+#include "danp/danp_buffer.h"
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_ext_codec.h"
+#include "cfl/cfl_utilities.h"
+#include "cfl_log.h"
+#include "cfl/services/cfl_stream.h"
+#include "services/cfl_service_danp_int.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define STREAM_POLL_MS  (CONFIG_CFL_STREAM_POLL_MS)
+#define STREAM_MAX_DATA (DANP_MAX_PACKET_SIZE - CFL_HEADER_SIZE)
+
+BUILD_ASSERT(
+    CONFIG_CFL_STREAM_PORT != CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT,
+    "CONFIG_CFL_STREAM_PORT collides with the service port");
+#if defined(CONFIG_CFL_ASYNC)
+BUILD_ASSERT(
+    CONFIG_CFL_STREAM_PORT != CONFIG_CFL_ASYNC_PORT,
+    "CONFIG_CFL_STREAM_PORT collides with CONFIG_CFL_ASYNC_PORT");
+#endif
+
+/* Types */
+
+typedef struct stream_server_s
+{
+    bool running;
+    danp_socket_t *listener;
+    danp_socket_t *conn;
+    k_tid_t tid;
+    struct k_thread thread;
+} stream_server_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static K_THREAD_STACK_DEFINE(server_stack, CONFIG_CFL_STREAM_STACK_SIZE);
+static stream_server_t server;
+static struct k_spinlock stats_lock;
+static cfl_stream_stats_t stats;
+
+/* Functions */
+
+/*
+ * Reads exactly len bytes. Returns -EAGAIN when nothing arrived within the
+ * timeout, -ETIMEDOUT when the peer stopped in the middle.
+ */
+static int32_t read_exact(danp_socket_t *sock, uint8_t *buf, uint16_t len, uint32_t timeout)
+{
+    uint16_t done = 0;
+    int32_t ret = 0;
+
+    while (done < len)
+    {
+        ret = danp_recv(sock, &buf[done], (uint16_t)(len - done), timeout);
+        if (ret == 0)
+        {
+            return -ECONNRESET;
+        }
+
+        if (ret < 0)
+        {
+            return (done == 0) ? -EAGAIN : -ETIMEDOUT;
+        }
+
+        done += (uint16_t)ret;
+    }
+
+    return 0;
+}
+
+static int32_t write_all(danp_socket_t *sock, const uint8_t *buf, uint16_t len)
+{
+    uint16_t done = 0;
+    int32_t ret = 0;
+
+    while (done < len)
+    {
+        ret = danp_send(sock, &buf[done], (uint16_t)(len - done));
+        if (ret <= 0)
+        {
+            return -ECONNRESET;
+        }
+
+        done += (uint16_t)ret;
+    }
+
+    return 0;
+}
+
+/*
+ * Frames are full CFL messages back to back. After a corrupted frame the
+ * reader slides one byte at a time until a sync word lines up again, the
+ * length field cannot be trusted before that.
+ */
+static int32_t read_frame(
+    danp_socket_t *sock,
+    danp_packet_t *pkt,
+    uint32_t timeout,
+    uint32_t *skipped)
+{
+    cfl_message_t *msg = (cfl_message_t *)pkt->payload;
+    int32_t ret = 0;
+
+    ret = read_exact(sock, pkt->payload, CFL_HEADER_SIZE, timeout);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    while (msg->sync != CFL_SYNC_WORD || msg->version != CFL_VERSION)
+    {
+        if (++(*skipped) > DANP_MAX_PACKET_SIZE)
+        {
+            return -EBADMSG;
+        }
+
+        memmove(pkt->payload, &pkt->payload[1], CFL_HEADER_SIZE - 1U);
+        ret = read_exact(sock, &pkt->payload[CFL_HEADER_SIZE - 1U], 1, timeout);
+        if (ret < 0)
+        {
+            return (ret == -EAGAIN) ? -ETIMEDOUT : ret;
+        }
+    }
+
+    if (msg->length > STREAM_MAX_DATA)
+    {
+        return -EMSGSIZE;
+    }
+
+    ret = read_exact(sock, msg->data, msg->length, timeout);
+    if (ret < 0)
+    {
+        return (ret == -EAGAIN) ? -ETIMEDOUT : ret;
+    }
+
+    pkt->length = CFL_HEADER_SIZE + msg->length;
+
+    return 0;
+}
+
+static int32_t write_message(
+    danp_socket_t *sock,
+    uint8_t flags,
+    uint16_t cmd_id,
+    uint16_t seq,
+    const uint8_t *payload,
+    uint16_t payload_len)
+{
+    const cfl_message_t header = {
+        .sync = CFL_SYNC_WORD,
+        .version = CFL_VERSION,
+        .flags = flags,
+        .cmd_id = cmd_id,
+        .seq = seq,
+        .length = payload_len,
+    };
+    int32_t ret = 0;
+
+    if (payload_len > STREAM_MAX_DATA)
+    {
+        return -EMSGSIZE;
+    }
+
+    if (payload_len > 0 && payload == NULL)
+    {
+        return -EINVAL;
+    }
+
+    /* Written in two parts, the stream joins them without a copy */
+    ret = write_all(sock, (const uint8_t *)&header, CFL_HEADER_SIZE);
+    if (ret == 0 && payload_len > 0)
+    {
+        ret = write_all(sock, payload, payload_len);
+    }
+
+    return ret;
+}
+
+/* Sends a response frame and frees it, the packets come from the service */
+static int32_t write_response(danp_socket_t *sock, danp_packet_t *pkt)
+{
+    int32_t ret = 0;
+
+    if (pkt == NULL)
+    {
+        return 0;
+    }
+
+    ret = write_all(sock, pkt->payload, pkt->length);
+    danp_buffer_free(pkt);
+
+    if (ret == 0)
+    {
+        k_spinlock_key_t key = k_spin_lock(&stats_lock);
+        stats.frames_tx++;
+        k_spin_unlock(&stats_lock, key);
+    }
+
+    return ret;
+}
+
+static void serve_connection(danp_socket_t *conn)
+{
+    uint32_t idle_ms = 0;
+    uint32_t skipped = 0;
+    int32_t ret = 0;
+    danp_packet_t *pkt = NULL;
+    danp_packet_t *rply_pkt = NULL;
+    danp_packet_t *status_pkt = NULL;
+    k_spinlock_key_t key;
+
+    while (server.running)
+    {
+        /* No buffer means no reading, the peer is held back by the stream window */
+        pkt = danp_buffer_get();
+        if (pkt == NULL)
+        {
+            k_sleep(K_MSEC(STREAM_POLL_MS));
+            continue;
+        }
+
+        skipped = 0;
+        ret = read_frame(conn, pkt, STREAM_POLL_MS, &skipped);
+
+        key = k_spin_lock(&stats_lock);
+        stats.resyncs += skipped;
+        k_spin_unlock(&stats_lock, key);
+
+        if (ret == -EAGAIN)
+        {
+            danp_buffer_free(pkt);
+            idle_ms += STREAM_POLL_MS;
+            if (idle_ms >= CONFIG_CFL_STREAM_IDLE_MS)
+            {
+                LOG_DBG("Closing idle stream connection");
+                break;
+            }
+            continue;
+        }
+
+        if (ret < 0)
+        {
+            danp_buffer_free(pkt);
+            if (ret != -ECONNRESET)
+            {
+                CFL_LOG_RATELIMITED(LOG_ERR, "Closing stream connection: %d", ret);
+                key = k_spin_lock(&stats_lock);
+                stats.errors++;
+                k_spin_unlock(&stats_lock, key);
+            }
+            break;
+        }
+
+        idle_ms = 0;
+        key = k_spin_lock(&stats_lock);
+        stats.frames_rx++;
+        k_spin_unlock(&stats_lock, key);
+
+        rply_pkt = NULL;
+        status_pkt = NULL;
+        (void)cfl_service_danp_serve_stream(CFL_STREAM_SRC_NODE, pkt, &rply_pkt, &status_pkt);
+
+        ret = write_response(conn, status_pkt);
+        if (ret == 0)
+        {
+            ret = write_response(conn, rply_pkt);
+        }
+        else if (rply_pkt != NULL)
+        {
+            danp_buffer_free(rply_pkt);
+        }
+
+        if (ret < 0)
+        {
+            CFL_LOG_RATELIMITED(LOG_ERR, "Failed to write to the stream connection");
+            key = k_spin_lock(&stats_lock);
+            stats.errors++;
+            k_spin_unlock(&stats_lock, key);
+            break;
+        }
+    }
+}
+
+static void stream_server_task(void *arg, void *unused1, void *unused2)
+{
+    danp_socket_t *conn = NULL;
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(arg);
+    ARG_UNUSED(unused1);
+    ARG_UNUSED(unused2);
+
+    while (server.running)
+    {
+        conn = danp_accept(server.listener, STREAM_POLL_MS);
+        if (conn == NULL)
+        {
+            continue;
+        }
+
+        key = k_spin_lock(&stats_lock);
+        stats.accepted++;
+        k_spin_unlock(&stats_lock, key);
+
+        server.conn = conn;
+        serve_connection(conn);
+        server.conn = NULL;
+        danp_close(conn);
+    }
+}
+
+int32_t cfl_stream_server_start(void)
+{
+    int32_t ret = 0;
+
+    for (;;)
+    {
+        if (server.running)
+        {
+            ret = -EALREADY;
+            break;
+        }
+
+        server.listener = danp_socket(DANP_TYPE_STREAM);
+        if (server.listener == NULL)
+        {
+            LOG_ERR("Failed to create stream socket");
+            ret = -ENOMEM;
+            break;
+        }
+
+        if (danp_bind(server.listener, CONFIG_CFL_STREAM_PORT) < 0 ||
+            danp_listen(server.listener, 1) < 0)
+        {
+            LOG_ERR("Failed to listen on stream port %d", CONFIG_CFL_STREAM_PORT);
+            ret = -EADDRNOTAVAIL;
+            break;
+        }
+
+        server.running = true;
+        server.tid = k_thread_create(
+            &server.thread,
+            server_stack,
+            K_THREAD_STACK_SIZEOF(server_stack),
+            stream_server_task,
+            NULL,
+            NULL,
+            NULL,
+            CONFIG_CFL_STREAM_PRIORITY,
+            0,
+            K_NO_WAIT);
+        k_thread_name_set(server.tid, "cfl_stream");
+
+        LOG_INF("CFL stream server listening on port %d", CONFIG_CFL_STREAM_PORT);
+        break;
+    }
+
+    if (ret < 0 && ret != -EALREADY && server.listener != NULL)
+    {
+        danp_close(server.listener);
+        server.listener = NULL;
+    }
+
+    return ret;
+}
+
+void cfl_stream_server_stop(void)
+{
+    if (!server.running)
+    {
+        return;
+    }
+
+    server.running = false;
+    if (k_thread_join(&server.thread, K_MSEC(STREAM_POLL_MS * 2)) != 0)
+    {
+        LOG_WRN("Stream server did not stop in time, aborting it");
+        k_thread_abort(server.tid);
+        if (server.conn != NULL)
+        {
+            danp_close(server.conn);
+        }
+    }
+
+    danp_close(server.listener);
+    memset(&server, 0, sizeof(server));
+}
+
+int32_t cfl_stream_get_stats(cfl_stream_stats_t *out)
+{
+    k_spinlock_key_t key;
+
+    if (out == NULL)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&stats_lock);
+    *out = stats;
+    k_spin_unlock(&stats_lock, key);
+
+    return 0;
+}
+
+int32_t cfl_stream_open(cfl_stream_t *stream, uint16_t node, uint16_t port)
+{
+    int32_t ret = 0;
+
+    if (stream == NULL)
+    {
+        return -EINVAL;
+    }
+
+    stream->node = node;
+    stream->sock = danp_socket(DANP_TYPE_STREAM);
+    if (stream->sock == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    ret = danp_connect(stream->sock, node, (port != 0) ? port : CONFIG_CFL_STREAM_PORT);
+    if (ret < 0)
+    {
+        CFL_LOG_RATELIMITED(LOG_ERR, "Stream connection to node %d refused: %d", node, ret);
+        danp_close(stream->sock);
+        stream->sock = NULL;
+        return -ECONNREFUSED;
+    }
+
+    return 0;
+}
+
+void cfl_stream_close(cfl_stream_t *stream)
+{
+    if (stream != NULL && stream->sock != NULL)
+    {
+        danp_close(stream->sock);
+        stream->sock = NULL;
+    }
+}
+
+int32_t cfl_stream_push(
+    cfl_stream_t *stream,
+    uint16_t cmd_id,
+    const uint8_t *payload,
+    uint16_t payload_len)
+{
+    if (stream == NULL || stream->sock == NULL)
+    {
+        return -EINVAL;
+    }
+
+    return write_message(stream->sock, CFL_F_PUSH, cmd_id, 0, payload, payload_len);
+}
+
+int32_t cfl_stream_transaction(
+    cfl_stream_t *stream,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len,
+    uint8_t *reply,
+    uint16_t reply_size,
+    uint32_t timeout)
+{
+    int32_t ret = 0;
+    uint16_t seq = cfl_next_seq();
+    uint32_t deadline_ms = k_uptime_get_32() + timeout;
+    int32_t remaining = 0;
+    uint32_t skipped = 0;
+    danp_packet_t *pkt = NULL;
+    cfl_message_t *msg = NULL;
+    cfl_ext_status_t status = {0};
+
+    if (stream == NULL || stream->sock == NULL)
+    {
+        return -EINVAL;
+    }
+
+    for (;;)
+    {
+        ret = write_message(stream->sock, CFL_F_RQST, cmd_id, seq, request, request_len);
+        if (ret < 0)
+        {
+            break;
+        }
+
+        pkt = danp_buffer_get();
+        if (pkt == NULL)
+        {
+            ret = -ENOMEM;
+            break;
+        }
+        msg = (cfl_message_t *)pkt->payload;
+
+        /* Answers of requests abandoned earlier may still be queued ahead of ours */
+        do
+        {
+            remaining = (int32_t)(deadline_ms - k_uptime_get_32());
+            if (remaining <= 0)
+            {
+                ret = -ETIMEDOUT;
+                break;
+            }
+
+            ret = read_frame(stream->sock, pkt, (uint32_t)remaining, &skipped);
+            if (ret == -EAGAIN)
+            {
+                ret = -ETIMEDOUT;
+            }
+        } while (ret == 0 && (msg->seq != seq || msg->cmd_id != cmd_id ||
+                              !(msg->flags & (CFL_F_ACK | CFL_F_NACK | CFL_F_RPLY))));
+
+        if (ret < 0)
+        {
+            break;
+        }
+
+        if (msg->flags & CFL_F_NACK)
+        {
+            /* The handler status, unless the NACK does not carry an error code */
+            ret = -EIO;
+            if (cfl_ext_status_decode(msg->data, msg->length, &status) >= 0 && status.status < 0)
+            {
+                ret = status.status;
+            }
+            break;
+        }
+
+        if (!(msg->flags & CFL_F_RPLY))
+        {
+            ret = 0;
+            break;
+        }
+
+        if (reply != NULL && msg->length > reply_size)
+        {
+            ret = -ENOBUFS;
+            break;
+        }
+
+        if (reply != NULL)
+        {
+            memcpy(reply, msg->data, msg->length);
+        }
+        ret = msg->length;
+        break;
+    }
+
+    if (pkt != NULL)
+    {
+        danp_buffer_free(pkt);
+    }
+
+    return ret;
+}
@@ -0,0 +1,878 @@
+/* cfl_xfer.c - Windowed file and blob transfer */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+#if defined(CONFIG_FLASH_MAP)
+#include <zephyr/storage/flash_map.h>
+#endif
+
+#include "danp/danp_defs.h"
+
+#include "cfl/cfl.h"
+#include "cfl/cfl_ext.h"
+#include "cfl/cfl_ext_codec.h"
+#include "cfl/cfl_utilities.h"
+#include "cfl_log.h"
+#include "cfl/services/cfl_service_danp.h"
+#include "cfl/services/cfl_xfer.h"
+#include "services/cfl_ext_int.h"
+
+/* Imports */
+
+
+/* Definitions */
+
+LOG_MODULE_DECLARE(cfl, CONFIG_CFL_LOG_LEVEL);
+
+#define XFER_CHUNK_SIZE    (CONFIG_CFL_XFER_CHUNK_SIZE)
+#define XFER_MAX_CHUNKS    (CONFIG_CFL_XFER_MAX_CHUNKS)
+#define XFER_TARGET_COUNT  (CONFIG_CFL_XFER_TARGETS)
+#define XFER_SESSION_COUNT (CONFIG_CFL_XFER_SESSIONS)
+#define XFER_BITMAP_BYTES  ((XFER_MAX_CHUNKS + 7U) / 8U)
+/* Bitmap bytes of one status reply, 256 chunks */
+#define XFER_STATUS_BYTES  (32U)
+
+/* What cfl_transaction() returns for a NACK */
+#define XFER_TRANSACTION_NACK (-5)
+
+BUILD_ASSERT(
+    CFL_HEADER_SIZE + CFL_EXT_XFER_DATA_SIZE + XFER_CHUNK_SIZE <= DANP_MAX_PACKET_SIZE,
+    "CONFIG_CFL_XFER_CHUNK_SIZE does not fit a DANP packet");
+BUILD_ASSERT(
+    CFL_HEADER_SIZE + CFL_EXT_XFER_STATUS_REPLY_SIZE + XFER_STATUS_BYTES <= DANP_MAX_PACKET_SIZE,
+    "Transfer status replies do not fit a DANP packet");
+
+/* Types */
+
+typedef struct xfer_target_s
+{
+    bool used;
+    uint32_t object;
+    const cfl_xfer_ops_t *ops;
+    void *ctx;
+} xfer_target_t;
+
+typedef struct xfer_session_s
+{
+    bool used;
+    uint16_t xfer_id;
+    uint16_t src_node;
+    uint16_t chunk_size;
+    uint32_t size;
+    uint32_t crc32;
+    uint32_t chunks;
+    uint32_t received;
+    uint32_t last_ms;
+    const xfer_target_t *target;
+    uint8_t bitmap[XFER_BITMAP_BYTES];
+} xfer_session_t;
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static struct k_spinlock lock;
+static xfer_target_t targets[XFER_TARGET_COUNT];
+static xfer_session_t sessions[XFER_SESSION_COUNT];
+static uint16_t next_xfer_id;
+/* Handlers run one at a time, under the dispatch lock of the service */
+static uint8_t verify_buf[XFER_CHUNK_SIZE];
+
+/* Functions */
+
+static int32_t ram_open(void *ctx, uint32_t size)
+{
+    const cfl_xfer_ram_t *ram = (const cfl_xfer_ram_t *)ctx;
+
+    return (size <= ram->size) ? 0 : -EFBIG;
+}
+
+static int32_t ram_write(void *ctx, uint32_t offset, const uint8_t *data, uint16_t len)
+{
+    cfl_xfer_ram_t *ram = (cfl_xfer_ram_t *)ctx;
+
+    if ((size_t)offset + len > ram->size)
+    {
+        return -EFBIG;
+    }
+
+    memcpy(&ram->buf[offset], data, len);
+
+    return 0;
+}
+
+static int32_t ram_read(void *ctx, uint32_t offset, uint8_t *data, uint16_t len)
+{
+    const cfl_xfer_ram_t *ram = (const cfl_xfer_ram_t *)ctx;
+
+    if ((size_t)offset + len > ram->size)
+    {
+        return -EFBIG;
+    }
+
+    memcpy(data, &ram->buf[offset], len);
+
+    return 0;
+}
+
+const cfl_xfer_ops_t cfl_xfer_ram_ops = {
+    .open = ram_open,
+    .write = ram_write,
+    .read = ram_read,
+};
+
+#if defined(CONFIG_FLASH_MAP)
+static int32_t flash_open(void *ctx, uint32_t size)
+{
+    cfl_xfer_flash_t *flash = (cfl_xfer_flash_t *)ctx;
+    int32_t ret = 0;
+
+    if (flash->area == NULL)
+    {
+        ret = flash_area_open(flash->area_id, &flash->area);
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+
+    if (size > flash->area->fa_size)
+    {
+        return -EFBIG;
+    }
+
+    /* Chunks arrive in any order, so the whole area is erased up front */
+    return flash_area_erase(flash->area, 0, flash->area->fa_size);
+}
+
+static int32_t flash_write(void *ctx, uint32_t offset, const uint8_t *data, uint16_t len)
+{
+    const cfl_xfer_flash_t *flash = (const cfl_xfer_flash_t *)ctx;
+
+    return flash_area_write(flash->area, (off_t)offset, data, len);
+}
+
+static int32_t flash_read(void *ctx, uint32_t offset, uint8_t *data, uint16_t len)
+{
+    const cfl_xfer_flash_t *flash = (const cfl_xfer_flash_t *)ctx;
+
+    return flash_area_read(flash->area, (off_t)offset, data, len);
+}
+
+const cfl_xfer_ops_t cfl_xfer_flash_ops = {
+    .open = flash_open,
+    .write = flash_write,
+    .read = flash_read,
+};
+#endif
+
+static const xfer_target_t *find_target(uint32_t object)
+{
+    for (size_t i = 0; i < XFER_TARGET_COUNT; i++)
+    {
+        if (targets[i].used && targets[i].object == object)
+        {
+            return &targets[i];
+        }
+    }
+
+    return NULL;
+}
+
+static xfer_session_t *find_session(uint16_t xfer_id)
+{
+    for (size_t i = 0; i < XFER_SESSION_COUNT; i++)
+    {
+        if (sessions[i].used && sessions[i].xfer_id == xfer_id)
+        {
+            return &sessions[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool bitmap_test(const xfer_session_t *session, uint32_t index)
+{
+    return (session->bitmap[index / 8U] & BIT(index % 8U)) != 0;
+}
+
+/*
+ * The same object with the same content resumes. Otherwise the session of
+ * the object is restarted, or a free or the least recently active one is
+ * taken: an abandoned transfer does not hold a slot forever.
+ */
+static xfer_session_t *open_session_locked(
+    const xfer_target_t *target,
+    const cfl_ext_xfer_open_t *req,
+    bool *resumed)
+{
+    xfer_session_t *same = NULL;
+    xfer_session_t *unused = NULL;
+    xfer_session_t *oldest = NULL;
+    xfer_session_t *found = NULL;
+
+    for (size_t i = 0; i < XFER_SESSION_COUNT; i++)
+    {
+        xfer_session_t *session = &sessions[i];
+
+        if (!session->used)
+        {
+            unused = (unused == NULL) ? session : unused;
+        }
+        else if (session->target == target)
+        {
+            same = session;
+        }
+        else if (oldest == NULL || (int32_t)(session->last_ms - oldest->last_ms) < 0)
+        {
+            oldest = session;
+        }
+    }
+
+    found = (same != NULL) ? same : ((unused != NULL) ? unused : oldest);
+    *resumed = same != NULL && same->size == req->size && same->chunk_size == req->chunk_size &&
+               same->crc32 == req->crc32;
+
+    if (!*resumed)
+    {
+        memset(found, 0, sizeof(*found));
+        found->used = true;
+        found->target = target;
+        found->size = req->size;
+        found->chunk_size = req->chunk_size;
+        found->crc32 = req->crc32;
+        found->chunks = DIV_ROUND_UP(req->size, req->chunk_size);
+        if (++next_xfer_id == 0)
+        {
+            next_xfer_id = 1;
+        }
+        found->xfer_id = next_xfer_id;
+    }
+
+    return found;
+}
+
+int32_t cfl_xfer_register(uint32_t object, const cfl_xfer_ops_t *ops, void *ctx)
+{
+    int32_t ret = -ENOMEM;
+    k_spinlock_key_t key;
+
+    if (ops == NULL || ops->open == NULL || ops->write == NULL || ops->read == NULL)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    if (find_target(object) != NULL)
+    {
+        ret = -EEXIST;
+    }
+    else
+    {
+        for (size_t i = 0; i < XFER_TARGET_COUNT; i++)
+        {
+            if (!targets[i].used)
+            {
+                targets[i].used = true;
+                targets[i].object = object;
+                targets[i].ops = ops;
+                targets[i].ctx = ctx;
+                ret = 0;
+                break;
+            }
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    if (ret == -ENOMEM)
+    {
+        LOG_ERR("No free transfer target slot for object 0x%08x", object);
+    }
+
+    return ret;
+}
+
+int32_t cfl_xfer_get(size_t index, cfl_xfer_info_t *info)
+{
+    int32_t ret = 0;
+    const xfer_session_t *session = NULL;
+    k_spinlock_key_t key;
+
+    if (info == NULL || index >= XFER_SESSION_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&lock);
+    session = &sessions[index];
+    if (!session->used)
+    {
+        ret = -ENOENT;
+    }
+    else
+    {
+        info->xfer_id = session->xfer_id;
+        info->src_node = session->src_node;
+        info->object = session->target->object;
+        info->size = session->size;
+        info->chunks = session->chunks;
+        info->received = session->received;
+        info->idle_ms = k_uptime_get_32() - session->last_ms;
+    }
+    k_spin_unlock(&lock, key);
+
+    return ret;
+}
+
+int32_t cfl_xfer_handle_open(uint16_t src_node, struct tmtc_args *rqst, struct tmtc_args *rply)
+{
+    int32_t ret = 0;
+    bool resumed = false;
+    cfl_ext_xfer_open_t req = {0};
+    cfl_ext_xfer_open_reply_t reply = {0};
+    const xfer_target_t *target = NULL;
+    xfer_session_t *session = NULL;
+    uint8_t *buffer = NULL;
+    k_spinlock_key_t key;
+
+    ret = cfl_ext_xfer_open_decode(rqst->data + rqst->hdr_len, rqst->len - rqst->hdr_len, &req);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (req.size == 0 || req.chunk_size == 0 || req.chunk_size > XFER_CHUNK_SIZE)
+    {
+        return -EINVAL;
+    }
+
+    if (DIV_ROUND_UP(req.size, req.chunk_size) > XFER_MAX_CHUNKS)
+    {
+        return -EFBIG;
+    }
+
+    key = k_spin_lock(&lock);
+    target = find_target(req.object);
+    if (target != NULL)
+    {
+        session = open_session_locked(target, &req, &resumed);
+        session->src_node = src_node;
+        session->last_ms = k_uptime_get_32();
+        reply.xfer_id = session->xfer_id;
+        reply.received = session->received;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (target == NULL)
+    {
+        return -ENOENT;
+    }
+
+    if (!resumed)
+    {
+        /* May take long on flash, the session only takes chunks once it succeeded */
+        ret = target->ops->open(target->ctx, req.size);
+        if (ret < 0)
+        {
+            LOG_ERR("Transfer target 0x%08x refused %u bytes: %d", req.object, req.size, ret);
+            key = k_spin_lock(&lock);
+            session->used = false;
+            k_spin_unlock(&lock, key);
+            return ret;
+        }
+    }
+
+    LOG_INF(
+        "Transfer %d of object 0x%08x from node %d %s, %u of %u chunks held",
+        reply.xfer_id,
+        req.object,
+        src_node,
+        resumed ? "resumed" : "started",
+        reply.received,
+        DIV_ROUND_UP(req.size, req.chunk_size));
+
+    buffer = rply->ops.malloc(rply->hdr_len + CFL_EXT_XFER_OPEN_REPLY_SIZE);
+    if (buffer == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    ret = cfl_ext_xfer_open_reply_encode(
+        &buffer[rply->hdr_len], CFL_EXT_XFER_OPEN_REPLY_SIZE, &reply);
+    rply->data = buffer;
+    rply->len = rply->hdr_len + ret;
+
+    return 0;
+}
+
+int32_t cfl_xfer_handle_data(uint16_t src_node, struct tmtc_args *rqst, struct tmtc_args *rply)
+{
+    int32_t ret = 0;
+    cfl_ext_xfer_data_t push = {0};
+    xfer_session_t *session = NULL;
+    const xfer_target_t *target = NULL;
+    uint32_t offset = 0;
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(src_node);
+    ARG_UNUSED(rply);
+
+    ret = cfl_ext_xfer_data_decode(rqst->data + rqst->hdr_len, rqst->len - rqst->hdr_len, &push);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    key = k_spin_lock(&lock);
+    for (;;)
+    {
+        session = find_session(push.xfer_id);
+        if (session == NULL || push.index >= session->chunks)
+        {
+            ret = -ENOENT;
+            break;
+        }
+
+        offset = push.index * session->chunk_size;
+        if (push.data_len != MIN(session->chunk_size, session->size - offset))
+        {
+            ret = -EINVAL;
+            break;
+        }
+
+        session->last_ms = k_uptime_get_32();
+        if (bitmap_test(session, push.index))
+        {
+            /* Sent again before the sender saw it in a status reply */
+            ret = -EALREADY;
+            break;
+        }
+
+        target = session->target;
+        break;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (ret < 0)
+    {
+        return (ret == -EALREADY) ? 0 : ret;
+    }
+
+    ret = target->ops->write(target->ctx, offset, push.data, push.data_len);
+    if (ret < 0)
+    {
+        CFL_LOG_RATELIMITED(LOG_ERR, "Failed to store chunk %u: %d", push.index, ret);
+        return ret;
+    }
+
+    key = k_spin_lock(&lock);
+    /* Looked up again, the session may have been restarted while writing */
+    session = find_session(push.xfer_id);
+    if (session != NULL && !bitmap_test(session, push.index))
+    {
+        session->bitmap[push.index / 8U] |= BIT(push.index % 8U);
+        session->received++;
+    }
+    k_spin_unlock(&lock, key);
+
+    return 0;
+}
+
+int32_t cfl_xfer_handle_status(uint16_t src_node, struct tmtc_args *rqst, struct tmtc_args *rply)
+{
+    int32_t ret = 0;
+    cfl_ext_xfer_status_t req = {0};
+    cfl_ext_xfer_status_reply_t reply = {0};
+    uint8_t bitmap[XFER_STATUS_BYTES] = {0};
+    xfer_session_t *session = NULL;
+    uint8_t *buffer = NULL;
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(src_node);
+
+    ret = cfl_ext_xfer_status_decode(rqst->data + rqst->hdr_len, rqst->len - rqst->hdr_len, &req);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    key = k_spin_lock(&lock);
+    session = find_session(req.xfer_id);
+    if (session == NULL)
+    {
+        ret = -ENOENT;
+    }
+    else if (req.base >= session->chunks)
+    {
+        ret = -EINVAL;
+    }
+    else
+    {
+        reply.received = session->received;
+        reply.base = req.base;
+        reply.bitmap = bitmap;
+        reply.bitmap_len =
+            (uint16_t)MIN(XFER_STATUS_BYTES, DIV_ROUND_UP(session->chunks - req.base, 8U));
+        for (uint32_t i = 0; i < reply.bitmap_len * 8U; i++)
+        {
+            uint32_t index = req.base + i;
+
+            if (index >= session->chunks || bitmap_test(session, index))
+            {
+                bitmap[i / 8U] |= BIT(i % 8U);
+            }
+        }
+        session->last_ms = k_uptime_get_32();
+    }
+    k_spin_unlock(&lock, key);
+
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    buffer = rply->ops.malloc(rply->hdr_len + CFL_EXT_XFER_STATUS_REPLY_SIZE + reply.bitmap_len);
+    if (buffer == NULL)
+    {
+        return -ENOMEM;
+    }
+
+    ret = cfl_ext_xfer_status_reply_encode(
+        &buffer[rply->hdr_len], CFL_EXT_XFER_STATUS_REPLY_SIZE + reply.bitmap_len, &reply);
+    rply->data = buffer;
+    rply->len = rply->hdr_len + ret;
+
+    return 0;
+}
+
+int32_t cfl_xfer_handle_close(uint16_t src_node, struct tmtc_args *rqst, struct tmtc_args *rply)
+{
+    int32_t ret = 0;
+    cfl_ext_xfer_close_t req = {0};
+    xfer_session_t *session = NULL;
+    const xfer_target_t *target = NULL;
+    uint32_t size = 0;
+    uint16_t chunk_size = 0;
+    uint32_t expected = 0;
+    uint32_t crc = 0;
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(rply);
+
+    ret = cfl_ext_xfer_close_decode(rqst->data + rqst->hdr_len, rqst->len - rqst->hdr_len, &req);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    key = k_spin_lock(&lock);
+    session = find_session(req.xfer_id);
+    if (session == NULL)
+    {
+        ret = -ENOENT;
+    }
+    else if (session->received < session->chunks)
+    {
+        ret = -EAGAIN;
+    }
+    else
+    {
+        target = session->target;
+        size = session->size;
+        chunk_size = session->chunk_size;
+        expected = session->crc32;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* Read back from the target, so what is checked is what was stored */
+    for (uint32_t offset = 0; offset < size; offset += chunk_size)
+    {
+        uint16_t len = (uint16_t)MIN(chunk_size, size - offset);
+
+        ret = target->ops->read(target->ctx, offset, verify_buf, len);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        crc = crc32_ieee_update(crc, verify_buf, len);
+    }
+
+    key = k_spin_lock(&lock);
+    session = find_session(req.xfer_id);
+    if (session != NULL && crc != expected)
+    {
+        /* Nothing tells which chunk is wrong, a retry sends them all again */
+        memset(session->bitmap, 0, sizeof(session->bitmap));
+        session->received = 0;
+    }
+    else if (session != NULL)
+    {
+        session->used = false;
+    }
+    k_spin_unlock(&lock, key);
+
+    if (crc != expected)
+    {
+        LOG_ERR(
+            "Transfer %d from node %d failed its CRC check: 0x%08x instead of 0x%08x",
+            req.xfer_id,
+            src_node,
+            crc,
+            expected);
+        return -EBADMSG;
+    }
+
+    LOG_INF(
+        "Transfer %d of object 0x%08x complete, %u bytes",
+        req.xfer_id,
+        target->object,
+        size);
+
+    return 0;
+}
+
+/* cfl_transaction() reports failures with codes of its own */
+static int32_t xfer_request(
+    uint16_t node,
+    uint16_t cmd_id,
+    const uint8_t *request,
+    uint16_t request_len,
+    uint8_t *reply,
+    uint16_t reply_size)
+{
+    int32_t ret = (int32_t)cfl_transaction(
+        node, cmd_id, request, request_len, reply, reply_size, CONFIG_CFL_XFER_TIMEOUT_MS);
+
+    if (ret == XFER_TRANSACTION_NACK)
+    {
+        return -EIO;
+    }
+
+    return (ret < 0) ? -ETIMEDOUT : ret;
+}
+
+static int32_t object_crc(
+    uint32_t size,
+    cfl_xfer_read_t read,
+    void *ctx,
+    uint8_t *buf,
+    uint32_t *crc)
+{
+    int32_t ret = 0;
+
+    *crc = 0;
+    for (uint32_t offset = 0; offset < size; offset += XFER_CHUNK_SIZE)
+    {
+        uint16_t len = (uint16_t)MIN(XFER_CHUNK_SIZE, size - offset);
+
+        ret = read(ctx, offset, buf, len);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        *crc = crc32_ieee_update(*crc, buf, len);
+    }
+
+    return 0;
+}
+
+/* Sends up to a window of the chunks a status reply reports missing */
+static int32_t send_holes(
+    uint16_t node,
+    uint16_t xfer_id,
+    const cfl_ext_xfer_status_reply_t *status,
+    uint32_t size,
+    cfl_xfer_read_t read,
+    void *ctx,
+    uint8_t *msg)
+{
+    int32_t ret = 0;
+    int32_t sent = 0;
+    uint32_t chunks = DIV_ROUND_UP(size, XFER_CHUNK_SIZE);
+    cfl_ext_xfer_data_t push = {.xfer_id = xfer_id};
+
+    /* The chunk is read in place behind the header, encoding does not move it */
+    push.data = &msg[CFL_EXT_XFER_DATA_SIZE];
+
+    for (uint32_t i = 0; i < status->bitmap_len * 8U && sent < CONFIG_CFL_XFER_WINDOW; i++)
+    {
+        push.index = status->base + i;
+        if (push.index >= chunks)
+        {
+            break;
+        }
+
+        if (status->bitmap[i / 8U] & BIT(i % 8U))
+        {
+            continue;
+        }
+
+        push.data_len = (uint16_t)MIN(XFER_CHUNK_SIZE, size - push.index * XFER_CHUNK_SIZE);
+        ret = read(ctx, push.index * XFER_CHUNK_SIZE, (uint8_t *)push.data, push.data_len);
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        ret = cfl_ext_xfer_data_encode(msg, CFL_EXT_XFER_DATA_SIZE + XFER_CHUNK_SIZE, &push);
+        /* A chunk that fails to go out is still a hole in the next status reply */
+        (void)cfl_service_danp_send_push(
+            node, CONFIG_CFL_SUPPORT_DANP_SERVICE_PORT, CFL_EXT_CMD_XFER_DATA, msg, (uint16_t)ret);
+        sent++;
+    }
+
+    return sent;
+}
+
+int32_t cfl_xfer_send(
+    uint16_t node,
+    uint32_t object,
+    uint32_t size,
+    cfl_xfer_read_t read,
+    void *ctx)
+{
+    int32_t ret = 0;
+    int32_t sent = 0;
+    uint32_t chunks = DIV_ROUND_UP(size, XFER_CHUNK_SIZE);
+    uint32_t last_received = 0;
+    uint32_t stalls = 0;
+    uint8_t msg[CFL_EXT_XFER_DATA_SIZE + XFER_CHUNK_SIZE];
+    uint8_t rqst[CFL_EXT_XFER_OPEN_SIZE];
+    uint8_t rply[CFL_EXT_XFER_STATUS_REPLY_SIZE + XFER_STATUS_BYTES];
+    cfl_ext_xfer_open_t open = {.object = object, .size = size, .chunk_size = XFER_CHUNK_SIZE};
+    cfl_ext_xfer_open_reply_t opened = {0};
+    cfl_ext_xfer_status_t query = {0};
+    cfl_ext_xfer_status_reply_t status = {0};
+    cfl_ext_xfer_close_t close = {0};
+
+    if (read == NULL || size == 0 || chunks > XFER_MAX_CHUNKS)
+    {
+        return -EINVAL;
+    }
+
+    for (;;)
+    {
+        ret = object_crc(size, read, ctx, &msg[CFL_EXT_XFER_DATA_SIZE], &open.crc32);
+        if (ret < 0)
+        {
+            break;
+        }
+
+        ret = cfl_ext_xfer_open_encode(rqst, sizeof(rqst), &open);
+        ret = xfer_request(node, CFL_EXT_CMD_XFER_OPEN, rqst, (uint16_t)ret, rply, sizeof(rply));
+        if (ret >= 0)
+        {
+            ret = cfl_ext_xfer_open_reply_decode(rply, (size_t)ret, &opened);
+        }
+        if (ret < 0)
+        {
+            LOG_ERR("Node %d refused to open object 0x%08x: %d", node, object, ret);
+            break;
+        }
+
+        query.xfer_id = opened.xfer_id;
+        close.xfer_id = opened.xfer_id;
+        last_received = opened.received;
+
+        /* Every status reply acknowledges a window and reports the holes behind it */
+        while (stalls <= CONFIG_CFL_XFER_RETRIES)
+        {
+            ret = cfl_ext_xfer_status_encode(rqst, sizeof(rqst), &query);
+            ret = xfer_request(
+                node, CFL_EXT_CMD_XFER_STATUS, rqst, (uint16_t)ret, rply, sizeof(rply));
+            if (ret >= 0)
+            {
+                ret = cfl_ext_xfer_status_reply_decode(rply, (size_t)ret, &status);
+            }
+            if (ret < 0)
+            {
+                stalls++;
+                continue;
+            }
+
+            if (status.received >= chunks)
+            {
+                ret = cfl_ext_xfer_close_encode(rqst, sizeof(rqst), &close);
+                ret = xfer_request(node, CFL_EXT_CMD_XFER_CLOSE, rqst, (uint16_t)ret, NULL, 0);
+                if (ret == -ETIMEDOUT)
+                {
+                    stalls++;
+                    continue;
+                }
+
+                /* Refused with every chunk held, the content did not match */
+                ret = (ret == -EIO) ? -EBADMSG : ret;
+                break;
+            }
+
+            if (status.received > last_received)
+            {
+                stalls = 0;
+            }
+            else if (sent > 0)
+            {
+                stalls++;
+            }
+            last_received = status.received;
+
+            sent = send_holes(node, opened.xfer_id, &status, size, read, ctx, msg);
+            if (sent < 0)
+            {
+                ret = sent;
+                break;
+            }
+
+            /* Nothing missing up to here, earlier holes are found again after wrapping */
+            if (sent == 0)
+            {
+                query.base = status.base + status.bitmap_len * 8U;
+                query.base = (query.base >= chunks) ? 0 : query.base;
+            }
+        }
+
+        if (stalls > CONFIG_CFL_XFER_RETRIES)
+        {
+            LOG_ERR("Transfer of object 0x%08x to node %d stalled", object, node);
+            ret = -ETIMEDOUT;
+        }
+        break;
+    }
+
+    return ret;
+}
+
+static int32_t buffer_read(void *ctx, uint32_t offset, uint8_t *data, uint16_t len)
+{
+    memcpy(data, (const uint8_t *)ctx + offset, len);
+
+    return 0;
+}
+
+int32_t cfl_xfer_send_buffer(
+    uint16_t node,
+    uint32_t object,
+    const uint8_t *data,
+    uint32_t size)
+{
+    if (data == NULL)
+    {
+        return -EINVAL;
+    }
+
+    return cfl_xfer_send(node, object, size, buffer_read, (void *)data);
+}
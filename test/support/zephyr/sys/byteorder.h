@@ -0,0 +1,28 @@
+/* byteorder.h - Host stand-in for the Zephyr byte order helpers used by cfl/cfl_codec.h */
+
+/* All Rights Reserved */
+
+#ifndef INC_TEST_ZEPHYR_SYS_BYTEORDER_H
+#define INC_TEST_ZEPHYR_SYS_BYTEORDER_H
+
+/* Includes */
+
+#include <stdint.h>
+
+/* Definitions */
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define sys_cpu_to_le16(_val) __builtin_bswap16(_val)
+#define sys_cpu_to_le32(_val) __builtin_bswap32(_val)
+#define sys_cpu_to_le64(_val) __builtin_bswap64(_val)
+#else
+#define sys_cpu_to_le16(_val) (_val)
+#define sys_cpu_to_le32(_val) (_val)
+#define sys_cpu_to_le64(_val) (_val)
+#endif
+
+#define sys_le16_to_cpu(_val) sys_cpu_to_le16(_val)
+#define sys_le32_to_cpu(_val) sys_cpu_to_le32(_val)
+#define sys_le64_to_cpu(_val) sys_cpu_to_le64(_val)
+
+#endif /* INC_TEST_ZEPHYR_SYS_BYTEORDER_H */
@@ -1,181 +1,368 @@
-/* test_cfl_zephyr_support.c - Unit tests for cfl_zephyr_support */
+/* test_cfl_zephyr_support.c - Unit tests for the host buildable CFL headers */
 
 /* All Rights Reserved */
 
 /* Includes */
 
-#include "cfl_zephyr_support/cfl_zephyr_support.h"
-#include "unity.h"
-#include <limits.h>
 #include <string.h>
 
+#include "cfl/cfl_ext_codec.h"
+#include "cfl/cfl_seq.h"
+#include "cfl/cfl_spsc.h"
+#include "cfl/cfl_varint.h"
+#include "unity.h"
+
+/* Definitions */
+
+#define TEST_RING_SIZE (4U)
+#define TEST_SEQ_RESYNC (3U)
+
+/* Variables */
+
+static cfl_spsc_t ring;
+static cfl_spsc_entry_t slots[TEST_RING_SIZE];
+static uint8_t packets[TEST_RING_SIZE * 2];
+static cfl_seq_window_t window;
+
 /* Test Setup and Teardown */
 
 void setUp(void)
 {
-    /* This is run before EACH test */
+    (void)cfl_spsc_init(&ring, slots, TEST_RING_SIZE);
+    memset(&window, 0, sizeof(window));
 }
 
 void tearDown(void)
 {
-    /* This is run after EACH test */
 }
 
-/* Test Cases for cfl_zephyr_supportGetVersion */
+/* Test Cases for cfl_spsc */
 
-void test_get_version_should_return_version_string(void)
+void test_spsc_init_should_return_error_when_size_is_not_power_of_two(void)
 {
-    const char *version = cfl_zephyr_support_get_version();
-    TEST_ASSERT_NOT_NULL(version);
-    TEST_ASSERT_EQUAL_STRING("1.0.0", version);
+    TEST_ASSERT_EQUAL_INT32(-EINVAL, cfl_spsc_init(&ring, slots, 3));
+    TEST_ASSERT_EQUAL_INT32(-EINVAL, cfl_spsc_init(&ring, slots, 0));
 }
 
-/* Test Cases for cfl_zephyr_supportAdd */
+void test_spsc_pop_batch_should_return_zero_when_ring_is_empty(void)
+{
+    cfl_spsc_entry_t entry;
+
+    TEST_ASSERT_EQUAL_size_t(0, cfl_spsc_pop_batch(&ring, &entry, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, cfl_spsc_count(&ring));
+}
 
-void test_add_should_return_sum_when_adding_positive_numbers(void)
+void test_spsc_push_should_return_error_when_ring_is_full(void)
 {
-    int32_t result = cfl_zephyr_support_add(5, 3);
-    TEST_ASSERT_EQUAL_INT32(8, result);
+    for (uint32_t i = 0; i < TEST_RING_SIZE; i++)
+    {
+        TEST_ASSERT_EQUAL_INT32(0, cfl_spsc_push(&ring, &packets[i], i));
+    }
+
+    TEST_ASSERT_EQUAL_INT32(-ENOBUFS, cfl_spsc_push(&ring, &packets[0], 0));
+    TEST_ASSERT_EQUAL_UINT32(TEST_RING_SIZE, cfl_spsc_count(&ring));
 }
 
-void test_add_should_return_sum_when_adding_negative_numbers(void)
+void test_spsc_pop_batch_should_return_entries_in_order_when_indices_wrap(void)
 {
-    int32_t result = cfl_zephyr_support_add(-5, -3);
-    TEST_ASSERT_EQUAL_INT32(-8, result);
+    cfl_spsc_entry_t batch[TEST_RING_SIZE];
+    uint32_t next = 0;
+
+    /* Three passes over four slots move both indices past the end */
+    for (uint32_t round = 0; round < 3; round++)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            TEST_ASSERT_EQUAL_INT32(0, cfl_spsc_push(&ring, &packets[i], round * 3 + i));
+        }
+
+        TEST_ASSERT_EQUAL_size_t(2, cfl_spsc_pop_batch(&ring, batch, 2));
+        TEST_ASSERT_EQUAL_size_t(1, cfl_spsc_pop_batch(&ring, &batch[2], TEST_RING_SIZE));
+
+        for (uint32_t i = 0; i < 3; i++, next++)
+        {
+            TEST_ASSERT_EQUAL_PTR(&packets[i], batch[i].ptr);
+            TEST_ASSERT_EQUAL_UINT32(next, batch[i].tag);
+        }
+    }
 }
 
-void test_add_should_return_sum_when_adding_mixed_numbers(void)
+void test_spsc_push_should_succeed_when_slots_are_popped(void)
 {
-    int32_t result = cfl_zephyr_support_add(10, -5);
-    TEST_ASSERT_EQUAL_INT32(5, result);
+    cfl_spsc_entry_t entry;
+
+    for (uint32_t i = 0; i < TEST_RING_SIZE; i++)
+    {
+        (void)cfl_spsc_push(&ring, &packets[i], i);
+    }
+
+    TEST_ASSERT_EQUAL_size_t(1, cfl_spsc_pop_batch(&ring, &entry, 1));
+    TEST_ASSERT_EQUAL_INT32(0, cfl_spsc_push(&ring, &packets[0], 0));
 }
 
-void test_add_should_return_zero_when_adding_zeros(void)
+/* Test Cases for the generated codec */
+
+void test_schedule_encode_should_write_little_endian_fields(void)
 {
-    int32_t result = cfl_zephyr_support_add(0, 0);
-    TEST_ASSERT_EQUAL_INT32(0, result);
+    static const uint8_t expected[] = {
+        0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x34, 0x12, 0xAA, 0xBB};
+    static const uint8_t data[] = {0xAA, 0xBB};
+    const cfl_ext_schedule_t in = {
+        .exec_at_ms = 0x0102030405060708LL,
+        .cmd_id = 0x1234,
+        .data = data,
+        .data_len = sizeof(data),
+    };
+    uint8_t buffer[16];
+
+    TEST_ASSERT_EQUAL_INT32(sizeof(expected), cfl_ext_schedule_encode(buffer, sizeof(buffer), &in));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, buffer, sizeof(expected));
 }
 
-/* Test Cases for cfl_zephyr_supportMultiply */
+void test_schedule_decode_should_return_fields_when_encoded(void)
+{
+    static const uint8_t data[] = {1, 2, 3};
+    const cfl_ext_schedule_t in = {
+        .exec_at_ms = -5,
+        .cmd_id = 0xBEEF,
+        .data = data,
+        .data_len = sizeof(data),
+    };
+    cfl_ext_schedule_t out;
+    uint8_t buffer[16];
+    int32_t len = cfl_ext_schedule_encode(buffer, sizeof(buffer), &in);
+
+    TEST_ASSERT_EQUAL_INT32(0, cfl_ext_schedule_decode(buffer, (size_t)len, &out));
+    TEST_ASSERT_EQUAL_INT64(in.exec_at_ms, out.exec_at_ms);
+    TEST_ASSERT_EQUAL_UINT16(in.cmd_id, out.cmd_id);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(data), out.data_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, out.data, sizeof(data));
+}
 
-void test_multiply_should_return_success_when_multiplying_positive_numbers(void)
+void test_schedule_encode_should_return_error_when_buffer_is_too_small(void)
 {
-    int32_t result;
-    cfl_zephyr_support_status_t status = cfl_zephyr_support_multiply(5, 3, &result);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_SUCCESS, status);
-    TEST_ASSERT_EQUAL_INT32(15, result);
+    const cfl_ext_schedule_t in = {.cmd_id = 1};
+    uint8_t buffer[CFL_EXT_SCHEDULE_SIZE - 1];
+
+    TEST_ASSERT_EQUAL_INT32(-EMSGSIZE, cfl_ext_schedule_encode(buffer, sizeof(buffer), &in));
 }
 
-void test_multiply_should_return_success_when_multiplying_by_zero(void)
+void test_status_decode_should_return_error_when_length_differs(void)
 {
-    int32_t result;
-    cfl_zephyr_support_status_t status = cfl_zephyr_support_multiply(5, 0, &result);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_SUCCESS, status);
-    TEST_ASSERT_EQUAL_INT32(0, result);
+    const uint8_t buffer[CFL_EXT_STATUS_SIZE + 1] = {0};
+    cfl_ext_status_t out;
+
+    TEST_ASSERT_EQUAL_INT32(-EINVAL, cfl_ext_status_decode(buffer, CFL_EXT_STATUS_SIZE - 1, &out));
+    TEST_ASSERT_EQUAL_INT32(-EINVAL, cfl_ext_status_decode(buffer, sizeof(buffer), &out));
 }
 
-void test_multiply_should_return_error_null_when_result_pointer_is_null(void)
+void test_status_decode_should_return_negative_status_when_encoded(void)
 {
-    cfl_zephyr_support_status_t status = cfl_zephyr_support_multiply(5, 3, NULL);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_ERROR_NULL, status);
+    const cfl_ext_status_t in = {.status = -22};
+    cfl_ext_status_t out;
+    uint8_t buffer[CFL_EXT_STATUS_SIZE];
+
+    (void)cfl_ext_status_encode(buffer, sizeof(buffer), &in);
+
+    TEST_ASSERT_EQUAL_INT32(0, cfl_ext_status_decode(buffer, sizeof(buffer), &out));
+    TEST_ASSERT_EQUAL_INT32(-22, out.status);
 }
 
-/* Test Cases for cfl_zephyr_supportFoo */
+/* Test Cases for cfl_varint */
 
-void test_foo_should_return_success_when_processing_valid_input(void)
+void test_varint_put_should_use_one_byte_when_value_fits_seven_bits(void)
 {
-    char output[100];
-    cfl_zephyr_support_status_t status = cfl_zephyr_support_foo("test", output, sizeof(output));
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_SUCCESS, status);
-    TEST_ASSERT_EQUAL_STRING("Processed: test", output);
+    uint8_t buffer[CFL_VARINT_MAX_LEN] = {0};
+
+    TEST_ASSERT_EQUAL_size_t(1, cfl_varint_put(buffer, 0x7F));
+    TEST_ASSERT_EQUAL_HEX8(0x7F, buffer[0]);
 }
 
-void test_foo_should_return_error_null_when_input_is_null(void)
+void test_varint_put_should_set_continuation_bit_when_value_needs_two_bytes(void)
 {
-    char output[100];
-    cfl_zephyr_support_status_t status = cfl_zephyr_support_foo(NULL, output, sizeof(output));
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_ERROR_NULL, status);
+    const uint8_t expected[] = {0x80, 0x01};
+    uint8_t buffer[CFL_VARINT_MAX_LEN] = {0};
+
+    TEST_ASSERT_EQUAL_size_t(2, cfl_varint_put(buffer, 0x80));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, buffer, sizeof(expected));
 }
 
-void test_foo_should_return_error_null_when_output_is_null(void)
+void test_varint_get_should_return_value_when_encoded_at_every_length(void)
 {
-    cfl_zephyr_support_status_t status = cfl_zephyr_support_foo("test", NULL, 100);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_ERROR_NULL, status);
+    const uint16_t values[] = {0x0000, 0x007F, 0x0080, 0x3FFF, 0x4000, 0xFFFF};
+    uint8_t buffer[CFL_VARINT_MAX_LEN];
+    uint16_t value = 0;
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        size_t len = cfl_varint_put(buffer, values[i]);
+
+        TEST_ASSERT_EQUAL_INT32((int32_t)len, cfl_varint_get(buffer, len, &value));
+        TEST_ASSERT_EQUAL_HEX16(values[i], value);
+    }
+
+    TEST_ASSERT_EQUAL_size_t(CFL_VARINT_MAX_LEN, cfl_varint_put(buffer, 0xFFFF));
 }
 
-void test_foo_should_return_error_invalid_when_output_size_is_zero(void)
+void test_varint_get_should_return_error_when_encoding_is_truncated(void)
 {
-    char output[100];
-    cfl_zephyr_support_status_t status = cfl_zephyr_support_foo("test", output, 0);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_ERROR_INVALID, status);
+    uint8_t buffer[CFL_VARINT_MAX_LEN];
+    uint16_t value = 0;
+    size_t len = cfl_varint_put(buffer, 0xFFFF);
+
+    TEST_ASSERT_EQUAL_INT32(-EINVAL, cfl_varint_get(buffer, len - 1, &value));
+    TEST_ASSERT_EQUAL_INT32(-EINVAL, cfl_varint_get(buffer, 0, &value));
 }
 
-void test_foo_should_return_error_invalid_when_buffer_too_small(void)
+void test_varint_get_should_return_error_when_value_exceeds_sixteen_bits(void)
 {
-    char output[5];
-    cfl_zephyr_support_status_t status = cfl_zephyr_support_foo("test", output, sizeof(output));
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_ERROR_INVALID, status);
+    const uint8_t too_large[] = {0xFF, 0xFF, 0x04};
+    const uint8_t too_long[] = {0x80, 0x80, 0x80, 0x00};
+    uint16_t value = 0;
+
+    TEST_ASSERT_EQUAL_INT32(-EINVAL, cfl_varint_get(too_large, sizeof(too_large), &value));
+    TEST_ASSERT_EQUAL_INT32(-EINVAL, cfl_varint_get(too_long, sizeof(too_long), &value));
 }
 
-/* Test Cases for cfl_zephyr_supportBar */
+/* Test Cases for cfl_seq windows */
 
-void test_bar_should_return_true_when_value_is_in_range(void)
+static cfl_seq_verdict_t check(uint16_t seq)
 {
-    TEST_ASSERT_TRUE(cfl_zephyr_support_bar(50));
-    TEST_ASSERT_TRUE(cfl_zephyr_support_bar(0));
-    TEST_ASSERT_TRUE(cfl_zephyr_support_bar(100));
+    return cfl_seq_window_check(&window, seq, TEST_SEQ_RESYNC);
 }
 
-void test_bar_should_return_false_when_value_is_out_of_range(void)
+void test_seq_window_check_should_take_first_number_as_top_when_window_is_empty(void)
 {
-    TEST_ASSERT_FALSE(cfl_zephyr_support_bar(-1));
-    TEST_ASSERT_FALSE(cfl_zephyr_support_bar(101));
-    TEST_ASSERT_FALSE(cfl_zephyr_support_bar(-100));
-    TEST_ASSERT_FALSE(cfl_zephyr_support_bar(200));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(0x1234));
+    TEST_ASSERT_TRUE(window.valid);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, window.top);
 }
 
-/* Test Cases for cfl_zephyr_supportFactorial */
+void test_seq_window_check_should_return_duplicate_when_number_is_received_again(void)
+{
+    (void)check(10);
+    (void)check(12);
+
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_DUPLICATE, check(12));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_DUPLICATE, check(10));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(11));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_DUPLICATE, check(11));
+    TEST_ASSERT_EQUAL_HEX16(12, window.top);
+}
 
-void test_factorial_should_return_correct_value_when_input_is_zero(void)
+void test_seq_window_check_should_slide_forward_when_number_wraps_at_0xffff(void)
 {
-    cfl_zephyr_support_result_t result = cfl_zephyr_support_factorial(0);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_SUCCESS, result.status);
-    TEST_ASSERT_EQUAL_INT32(1, result.value);
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(0xFFFE));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(0xFFFF));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(0x0000));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(0x0001));
+    TEST_ASSERT_EQUAL_HEX16(0x0001, window.top);
+
+    /* Numbers before the wrap are still remembered behind the new top */
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_DUPLICATE, check(0xFFFF));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_DUPLICATE, check(0xFFFE));
 }
 
-void test_factorial_should_return_correct_value_when_input_is_one(void)
+void test_seq_window_check_should_accept_late_number_when_it_arrives_after_the_wrap(void)
 {
-    cfl_zephyr_support_result_t result = cfl_zephyr_support_factorial(1);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_SUCCESS, result.status);
-    TEST_ASSERT_EQUAL_INT32(1, result.value);
+    (void)check(0xFFFD);
+    (void)check(0x0002);
+
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(0xFFFF));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_DUPLICATE, check(0xFFFF));
+    TEST_ASSERT_EQUAL_HEX16(0x0002, window.top);
 }
 
-void test_factorial_should_return_correct_value_when_input_is_five(void)
+void test_seq_window_check_should_return_stale_when_number_is_older_than_the_window(void)
 {
-    cfl_zephyr_support_result_t result = cfl_zephyr_support_factorial(5);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_SUCCESS, result.status);
-    TEST_ASSERT_EQUAL_INT32(120, result.value);
+    (void)check(0x0010);
+
+    /* 0x0010 - 32 wraps below zero and is just out of the window */
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_STALE, check(0xFFF0));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(0xFFF1));
+    TEST_ASSERT_EQUAL_HEX16(0x0010, window.top);
 }
 
-void test_factorial_should_return_correct_value_when_input_is_ten(void)
+void test_seq_window_check_should_forget_older_numbers_when_top_jumps_past_the_window(void)
 {
-    cfl_zephyr_support_result_t result = cfl_zephyr_support_factorial(10);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_SUCCESS, result.status);
-    TEST_ASSERT_EQUAL_INT32(3628800, result.value);
+    (void)check(0xFFF0);
+    (void)check(0x0020);
+
+    TEST_ASSERT_EQUAL_HEX32(1U, window.seen);
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_STALE, check(0xFFF0));
 }
 
-void test_factorial_should_return_error_invalid_when_input_is_negative(void)
+void test_seq_window_check_should_restart_window_when_stale_numbers_arrive_in_a_row(void)
 {
-    cfl_zephyr_support_result_t result = cfl_zephyr_support_factorial(-1);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_ERROR_INVALID, result.status);
-    TEST_ASSERT_EQUAL_INT32(0, result.value);
+    (void)check(0x8000);
+
+    /* A restarted peer numbers from 1 again */
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_STALE, check(1));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_STALE, check(2));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_RESYNC, check(3));
+    TEST_ASSERT_EQUAL_HEX16(3, window.top);
+
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(4));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_DUPLICATE, check(3));
+}
+
+void test_seq_window_check_should_keep_window_when_stale_row_is_broken(void)
+{
+    (void)check(100);
+
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_STALE, check(1));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_STALE, check(2));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_NEW, check(99));
+    TEST_ASSERT_EQUAL_INT(CFL_SEQ_STALE, check(3));
+    TEST_ASSERT_EQUAL_HEX16(100, window.top);
 }
 
-void test_factorial_should_return_error_invalid_when_input_is_too_large(void)
+/* Test Cases for cfl_seq ranges */
+
+void test_seq_range_add_should_extend_range_when_numbers_wrap_at_0xffff(void)
 {
-    cfl_zephyr_support_result_t result = cfl_zephyr_support_factorial(13);
-    TEST_ASSERT_EQUAL(CFL_ZEPHYR_SUPPORT_ERROR_INVALID, result.status);
-    TEST_ASSERT_EQUAL_INT32(0, result.value);
+    cfl_seq_range_t range = {0};
+
+    TEST_ASSERT_TRUE(cfl_seq_range_add(&range, 0xFFFE));
+    TEST_ASSERT_TRUE(cfl_seq_range_add(&range, 0xFFFF));
+    TEST_ASSERT_TRUE(cfl_seq_range_add(&range, 0x0000));
+    TEST_ASSERT_TRUE(cfl_seq_range_add(&range, 0x0001));
+    TEST_ASSERT_EQUAL_HEX16(0xFFFE, range.first);
+    TEST_ASSERT_EQUAL_UINT16(4, range.count);
+}
+
+void test_seq_range_add_should_leave_range_untouched_when_number_does_not_follow(void)
+{
+    cfl_seq_range_t range = {0};
+
+    (void)cfl_seq_range_add(&range, 10);
+    (void)cfl_seq_range_add(&range, 11);
+
+    /* A gap, a number received again and one from before the range */
+    TEST_ASSERT_FALSE(cfl_seq_range_add(&range, 13));
+    TEST_ASSERT_FALSE(cfl_seq_range_add(&range, 11));
+    TEST_ASSERT_FALSE(cfl_seq_range_add(&range, 9));
+    TEST_ASSERT_EQUAL_HEX16(10, range.first);
+    TEST_ASSERT_EQUAL_UINT16(2, range.count);
+}
+
+void test_seq_range_covers_should_hold_numbers_on_both_sides_when_range_wraps(void)
+{
+    const cfl_seq_range_t range = {.first = 0xFFFD, .count = 5};
+
+    TEST_ASSERT_FALSE(cfl_seq_range_covers(&range, 0xFFFC));
+    TEST_ASSERT_TRUE(cfl_seq_range_covers(&range, 0xFFFD));
+    TEST_ASSERT_TRUE(cfl_seq_range_covers(&range, 0xFFFF));
+    TEST_ASSERT_TRUE(cfl_seq_range_covers(&range, 0x0000));
+    TEST_ASSERT_TRUE(cfl_seq_range_covers(&range, 0x0001));
+    TEST_ASSERT_FALSE(cfl_seq_range_covers(&range, 0x0002));
+}
+
+void test_seq_range_covers_should_return_false_when_range_is_empty(void)
+{
+    const cfl_seq_range_t range = {.first = 7, .count = 0};
+
+    TEST_ASSERT_FALSE(cfl_seq_range_covers(&range, 7));
 }
 
 /* Main Test Runner */
@@ -184,44 +371,42 @@ int main(void)
 {
     UNITY_BEGIN();
 
-    /* Version tests */
-    RUN_TEST(test_get_version_should_return_version_string);
-
-    /* Add function tests */
-    RUN_TEST(test_add_should_return_sum_when_adding_positive_numbers);
-    RUN_TEST(test_add_should_return_sum_when_adding_negative_numbers);
-    RUN_TEST(test_add_should_return_sum_when_adding_mixed_numbers);
-    RUN_TEST(test_add_should_return_zero_when_adding_zeros);
-    RUN_TEST(test_add_should_saturate_on_overflow);
-    RUN_TEST(test_add_should_saturate_on_underflow);
-
-    /* Multiply function tests */
-    RUN_TEST(test_multiply_should_return_success_when_multiplying_positive_numbers);
-    RUN_TEST(test_multiply_should_return_success_when_multiplying_by_zero);
-    RUN_TEST(test_multiply_should_return_error_null_when_result_pointer_is_null);
-    RUN_TEST(test_multiply_should_return_error_invalid_on_overflow);
-    RUN_TEST(test_multiply_should_return_error_invalid_on_underflow);
-
-    /* Foo function tests */
-    RUN_TEST(test_foo_should_return_success_when_processing_valid_input);
-    RUN_TEST(test_foo_should_return_error_null_when_input_is_null);
-    RUN_TEST(test_foo_should_return_error_null_when_output_is_null);
-    RUN_TEST(test_foo_should_return_error_invalid_when_output_size_is_zero);
-    RUN_TEST(test_foo_should_return_error_invalid_when_buffer_too_small);
-    RUN_TEST(test_foo_should_succeed_when_buffer_exact_size);
-    RUN_TEST(test_foo_should_return_error_invalid_when_buffer_one_byte_short);
-
-    /* Bar function tests */
-    RUN_TEST(test_bar_should_return_true_when_value_is_in_range);
-    RUN_TEST(test_bar_should_return_false_when_value_is_out_of_range);
-
-    /* Factorial function tests */
-    RUN_TEST(test_factorial_should_return_correct_value_when_input_is_zero);
-    RUN_TEST(test_factorial_should_return_correct_value_when_input_is_one);
-    RUN_TEST(test_factorial_should_return_correct_value_when_input_is_five);
-    RUN_TEST(test_factorial_should_return_correct_value_when_input_is_ten);
-    RUN_TEST(test_factorial_should_return_error_invalid_when_input_is_negative);
-    RUN_TEST(test_factorial_should_return_error_invalid_when_input_is_too_large);
+    /* SPSC ring tests */
+    RUN_TEST(test_spsc_init_should_return_error_when_size_is_not_power_of_two);
+    RUN_TEST(test_spsc_pop_batch_should_return_zero_when_ring_is_empty);
+    RUN_TEST(test_spsc_push_should_return_error_when_ring_is_full);
+    RUN_TEST(test_spsc_pop_batch_should_return_entries_in_order_when_indices_wrap);
+    RUN_TEST(test_spsc_push_should_succeed_when_slots_are_popped);
+
+    /* Generated codec tests */
+    RUN_TEST(test_schedule_encode_should_write_little_endian_fields);
+    RUN_TEST(test_schedule_decode_should_return_fields_when_encoded);
+    RUN_TEST(test_schedule_encode_should_return_error_when_buffer_is_too_small);
+    RUN_TEST(test_status_decode_should_return_error_when_length_differs);
+    RUN_TEST(test_status_decode_should_return_negative_status_when_encoded);
+
+    /* Compact header varint tests */
+    RUN_TEST(test_varint_put_should_use_one_byte_when_value_fits_seven_bits);
+    RUN_TEST(test_varint_put_should_set_continuation_bit_when_value_needs_two_bytes);
+    RUN_TEST(test_varint_get_should_return_value_when_encoded_at_every_length);
+    RUN_TEST(test_varint_get_should_return_error_when_encoding_is_truncated);
+    RUN_TEST(test_varint_get_should_return_error_when_value_exceeds_sixteen_bits);
+
+    /* Sequence window tests */
+    RUN_TEST(test_seq_window_check_should_take_first_number_as_top_when_window_is_empty);
+    RUN_TEST(test_seq_window_check_should_return_duplicate_when_number_is_received_again);
+    RUN_TEST(test_seq_window_check_should_slide_forward_when_number_wraps_at_0xffff);
+    RUN_TEST(test_seq_window_check_should_accept_late_number_when_it_arrives_after_the_wrap);
+    RUN_TEST(test_seq_window_check_should_return_stale_when_number_is_older_than_the_window);
+    RUN_TEST(test_seq_window_check_should_forget_older_numbers_when_top_jumps_past_the_window);
+    RUN_TEST(test_seq_window_check_should_restart_window_when_stale_numbers_arrive_in_a_row);
+    RUN_TEST(test_seq_window_check_should_keep_window_when_stale_row_is_broken);
+
+    /* Sequence range tests */
+    RUN_TEST(test_seq_range_add_should_extend_range_when_numbers_wrap_at_0xffff);
+    RUN_TEST(test_seq_range_add_should_leave_range_untouched_when_number_does_not_follow);
+    RUN_TEST(test_seq_range_covers_should_hold_numbers_on_both_sides_when_range_wraps);
+    RUN_TEST(test_seq_range_covers_should_return_false_when_range_is_empty);
 
     return UNITY_END();
 }